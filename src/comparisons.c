@@ -0,0 +1,698 @@
+/** \file comparisons.c
+ * Background comparisons engine.
+ *
+ * A worker thread keeps the segment times of the whole run history of the
+ * open split file in memory, sorted per segment, and computes the comparisons
+ * (average, median, latest, balanced PB and best segments) from them. New runs
+ * are added incrementally, a binary search and a memmove per segment.
+ *
+ * The same goes for the graphs of the history: the attempts are grouped into
+ * at most LS_GRAPH_POINTS points, two neighbours merging whenever they would
+ * be more, and every segment keeps a histogram of its times that only gets
+ * refitted when its range changes, so a run never walks the whole history.
+ *
+ * Every update produces a new immutable ls_comparisons snapshot, which the
+ * main thread picks up with ls_comparisons_take, so switching comparison or
+ * adding a run never stalls the GUI, no matter how long the history is.
+ */
+#include "comparisons.h"
+#include "logging.h"
+#include "timer.h"
+
+#include <jansson.h>
+#include <limits.h>
+#include <linux/prctl.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+
+/*! Comparison names, as shown to the user */
+const char* const ls_comparison_names[LS_COMPARISON_COUNT] = {
+    [LS_COMPARISON_PB] = "Personal Best",
+    [LS_COMPARISON_AVERAGE] = "Average Segments",
+    [LS_COMPARISON_MEDIAN] = "Median Segments",
+    [LS_COMPARISON_LATEST] = "Latest Run",
+    [LS_COMPARISON_BALANCED_PB] = "Balanced PB",
+    [LS_COMPARISON_BEST_SEGMENTS] = "Best Segments",
+};
+
+/*! Comparison names, as written in a layout */
+const char* const ls_comparison_keys[LS_COMPARISON_COUNT] = {
+    [LS_COMPARISON_PB] = "pb",
+    [LS_COMPARISON_AVERAGE] = "average",
+    [LS_COMPARISON_MEDIAN] = "median",
+    [LS_COMPARISON_LATEST] = "latest",
+    [LS_COMPARISON_BALANCED_PB] = "balanced-pb",
+    [LS_COMPARISON_BEST_SEGMENTS] = "best-segments",
+};
+
+/**
+ * Finds a comparison by the name it has in a layout.
+ *
+ * @param key The name, like "average".
+ *
+ * @return The comparison, LS_COMPARISON_COUNT if there's none by that name.
+ */
+ls_comparison_type ls_comparison_find(const char* key)
+{
+    int i = 0;
+    while (i < LS_COMPARISON_COUNT && strcmp(ls_comparison_keys[i], key) != 0) {
+        ++i;
+    }
+    return (ls_comparison_type)i;
+}
+
+/**
+ * @brief The history of a single segment.
+ */
+typedef struct segment_samples {
+    long long* times; /*!< Every known time of the segment, sorted */
+    size_t count; /*!< Number of times */
+    size_t capacity; /*!< Number of times that fit in the array */
+    long long sum; /*!< Sum of all the times */
+    ls_graph_histogram histogram; /*!< Distribution of the times */
+    size_t fitted; /*!< Number of times when the histogram range was chosen */
+} segment_samples;
+
+/**
+ * @brief Everything the worker knows about the history of the open split file.
+ */
+typedef struct comparisons_state {
+    char split_file[PATH_MAX]; /*!< The split file */
+    unsigned int split_count; /*!< Number of splits */
+    size_t run_count; /*!< Number of history runs seen so far */
+    long long pb; /*!< Personal best final time, 0 if none */
+    segment_samples* segments; /*!< History of every segment */
+    long long* latest; /*!< Split times of the latest run */
+    ls_graph_point points[LS_GRAPH_POINTS]; /*!< Attempt history, downsampled */
+    size_t point_count; /*!< Number of points */
+    unsigned int point_runs; /*!< Attempts grouped in a full point */
+    long long fastest; /*!< Best final time in the history */
+    long long slowest; /*!< Worst final time in the history */
+    unsigned int* resets; /*!< Number of runs reset during each split */
+} comparisons_state;
+
+/**
+ * @brief The requests queue, filled by anyone and consumed by the worker.
+ */
+static struct {
+    ls_comparisons_request* head;
+    ls_comparisons_request* tail;
+    bool active;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} queue = {
+    .active = true,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+/*! Latest snapshot not yet taken by the main thread */
+static _Atomic(ls_comparisons*) pending = NULL;
+
+/*! Told when a snapshot is ready to be taken, may be NULL */
+static void (*_Atomic ready_callback)(void) = NULL;
+
+/**
+ * Appends a request to the queue.
+ *
+ * @param request The request, the queue takes ownership of it.
+ */
+static void push_request(ls_comparisons_request* request)
+{
+    pthread_mutex_lock(&queue.lock);
+    if (queue.tail) {
+        queue.tail->next = request;
+    } else {
+        queue.head = request;
+    }
+    queue.tail = request;
+    pthread_cond_signal(&queue.cond);
+    pthread_mutex_unlock(&queue.lock);
+}
+
+/**
+ * Asks the worker to compute the comparisons of a split file from its whole history.
+ *
+ * @param split_file The path of the split file.
+ */
+void ls_comparisons_load(const char* split_file)
+{
+    ls_comparisons_request* request = calloc(1, sizeof(ls_comparisons_request));
+    if (!request) {
+        return;
+    }
+    request->load = true;
+    strncpy(request->split_file, split_file, sizeof(request->split_file) - 1);
+    push_request(request);
+}
+
+/**
+ * Asks the worker to add a run that was just appended to the history.
+ *
+ * @param split_file The path of the split file the run belongs to.
+ * @param run The run, the worker takes ownership of it.
+ * @param position The position of the run in the history, so runs already
+ *                 seen while loading the history are not counted twice.
+ */
+void ls_comparisons_add_run(const char* split_file, ls_history_run* run, size_t position)
+{
+    ls_comparisons_request* request = calloc(1, sizeof(ls_comparisons_request));
+    if (!request) {
+        ls_history_run_free(run);
+        return;
+    }
+    strncpy(request->split_file, split_file, sizeof(request->split_file) - 1);
+    request->run = run;
+    request->position = position;
+    push_request(request);
+}
+
+/**
+ * Takes the latest comparisons computed by the worker.
+ *
+ * @return The new comparisons, to be freed by the caller, or NULL if nothing changed.
+ */
+ls_comparisons* ls_comparisons_take(void)
+{
+    return atomic_exchange(&pending, NULL);
+}
+
+/**
+ * Sets the function told when new comparisons are ready to be taken.
+ *
+ * It's called from the worker thread.
+ *
+ * @param callback The function, NULL for none.
+ */
+void ls_comparisons_set_ready_callback(void (*callback)(void))
+{
+    atomic_store(&ready_callback, callback);
+}
+
+/**
+ * Frees a comparisons snapshot.
+ *
+ * @param comparisons The snapshot.
+ */
+void ls_comparisons_free(ls_comparisons* comparisons)
+{
+    free(comparisons);
+}
+
+/**
+ * Asks the worker thread to exit.
+ */
+void ls_comparisons_close(void)
+{
+    pthread_mutex_lock(&queue.lock);
+    queue.active = false;
+    pthread_cond_signal(&queue.cond);
+    pthread_mutex_unlock(&queue.lock);
+}
+
+/**
+ * Frees all the history kept by the worker.
+ *
+ * @param state The worker state.
+ */
+static void state_clear(comparisons_state* state)
+{
+    if (state->segments) {
+        for (unsigned int i = 0; i < state->split_count; ++i) {
+            free(state->segments[i].times);
+        }
+        free(state->segments);
+    }
+    free(state->latest);
+    free(state->resets);
+    memset(state, 0, sizeof(comparisons_state));
+}
+
+/**
+ * Finds where a time goes in the sorted history of a segment.
+ *
+ * @param samples The segment history.
+ * @param time The time.
+ *
+ * @return The index of the first time greater than the given one.
+ */
+static size_t samples_find(const segment_samples* samples, long long time)
+{
+    size_t low = 0;
+    size_t high = samples->count;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (samples->times[mid] <= time) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * Inserts a time in the sorted history of a segment.
+ *
+ * @param samples The segment history.
+ * @param time The time to insert.
+ *
+ * @return Zero on success, non-zero otherwise.
+ */
+static int samples_insert(segment_samples* samples, long long time)
+{
+    if (samples->count == samples->capacity) {
+        const size_t capacity = samples->capacity ? samples->capacity * 2 : 64;
+        long long* times = realloc(samples->times, capacity * sizeof(long long));
+        if (!times) {
+            return 1;
+        }
+        samples->times = times;
+        samples->capacity = capacity;
+    }
+    const size_t low = samples_find(samples, time);
+    memmove(&samples->times[low + 1], &samples->times[low], (samples->count - low) * sizeof(long long));
+    samples->times[low] = time;
+    samples->count++;
+    samples->sum += time;
+    return 0;
+}
+
+/**
+ * Returns the time of a segment at a given percentile of its history.
+ *
+ * @param samples The segment history, must not be empty.
+ * @param percentile The percentile, from 0 (best) to 1 (worst).
+ *
+ * @return The segment time.
+ */
+static long long samples_percentile(const segment_samples* samples, double percentile)
+{
+    return samples->times[(size_t)(percentile * (samples->count - 1) + 0.5)];
+}
+
+/**
+ * Chooses the range of the histogram of a segment, then fills it from
+ * the sorted times, with a binary search per bin.
+ *
+ * @param samples The segment history.
+ */
+static void histogram_fit(segment_samples* samples)
+{
+    ls_graph_histogram* histogram = &samples->histogram;
+    memset(histogram, 0, sizeof(ls_graph_histogram));
+    samples->fitted = samples->count;
+    if (!samples->count) {
+        return;
+    }
+    // The slowest times would squash all the others in the first bins
+    histogram->low = samples->times[0];
+    histogram->bin_width = (samples_percentile(samples, 0.95) - histogram->low) / LS_GRAPH_BINS + 1;
+    size_t start = 0;
+    for (int i = 0; i < LS_GRAPH_BINS; ++i) {
+        const size_t end = i == LS_GRAPH_BINS - 1
+            ? samples->count
+            : samples_find(samples, histogram->low + (i + 1) * histogram->bin_width - 1);
+        histogram->bins[i] = end - start;
+        if (histogram->bins[i] > histogram->peak) {
+            histogram->peak = histogram->bins[i];
+        }
+        start = end;
+    }
+}
+
+/**
+ * Adds a time, already inserted in the history of a segment, to its histogram.
+ * The range is chosen again when the time is a new best, or when the
+ * number of times doubled since it was chosen.
+ *
+ * @param samples The segment history.
+ * @param time The time.
+ */
+static void histogram_add(segment_samples* samples, long long time)
+{
+    ls_graph_histogram* histogram = &samples->histogram;
+    if (time < histogram->low || samples->count >= 2 * samples->fitted) {
+        histogram_fit(samples);
+        return;
+    }
+    size_t bin = (time - histogram->low) / histogram->bin_width;
+    if (bin >= LS_GRAPH_BINS) {
+        bin = LS_GRAPH_BINS - 1;
+    }
+    histogram->bins[bin]++;
+    if (histogram->bins[bin] > histogram->peak) {
+        histogram->peak = histogram->bins[bin];
+    }
+}
+
+/**
+ * Merges two neighbour points of the attempt history.
+ *
+ * @param a The older point.
+ * @param b The newer point.
+ *
+ * @return The merged point.
+ */
+static ls_graph_point point_merge(const ls_graph_point* a, const ls_graph_point* b)
+{
+    ls_graph_point point = {
+        .best = a->best,
+        .worst = a->worst,
+        .runs = a->runs + b->runs,
+        .completed = a->completed + b->completed,
+    };
+    if (b->best && (!point.best || b->best < point.best)) {
+        point.best = b->best;
+    }
+    if (b->worst > point.worst) {
+        point.worst = b->worst;
+    }
+    return point;
+}
+
+/**
+ * Adds a run to the attempt history and to the resets of its split.
+ *
+ * @param state The worker state.
+ * @param run The run to add.
+ */
+static void graph_add_run(comparisons_state* state, const ls_history_run* run)
+{
+    ls_graph_point* points = state->points;
+    if (state->point_count == LS_GRAPH_POINTS && points[LS_GRAPH_POINTS - 1].runs == state->point_runs) {
+        // Out of points, every point now takes twice as many attempts
+        for (size_t i = 0; i < LS_GRAPH_POINTS / 2; ++i) {
+            points[i] = point_merge(&points[2 * i], &points[2 * i + 1]);
+        }
+        state->point_count = LS_GRAPH_POINTS / 2;
+        state->point_runs *= 2;
+    }
+    if (!state->point_count || points[state->point_count - 1].runs == state->point_runs) {
+        memset(&points[state->point_count++], 0, sizeof(ls_graph_point));
+    }
+
+    ls_graph_point* point = &points[state->point_count - 1];
+    const long long time = run->header.final_time;
+    point->runs++;
+    if ((run->header.flags & LS_HISTORY_COMPLETED) && time > 0) {
+        point->completed++;
+        if (!point->best || time < point->best) {
+            point->best = time;
+        }
+        if (time > point->worst) {
+            point->worst = time;
+        }
+        if (!state->fastest || time < state->fastest) {
+            state->fastest = time;
+        }
+        if (time > state->slowest) {
+            state->slowest = time;
+        }
+    } else if (run->header.splits_reached < state->split_count) {
+        state->resets[run->header.splits_reached]++;
+    }
+}
+
+/**
+ * Adds a run to the history kept by the worker.
+ *
+ * @param state The worker state.
+ * @param run The run to add.
+ */
+static void state_add_run(comparisons_state* state, const ls_history_run* run)
+{
+    if (run->header.split_count != state->split_count) {
+        // The split file changed since the run was saved
+        return;
+    }
+    for (unsigned int i = 0; i < state->split_count; ++i) {
+        if (run->segment_times[i] > 0 && run->segment_times[i] < LLONG_MAX
+            && samples_insert(&state->segments[i], run->segment_times[i]) == 0) {
+            histogram_add(&state->segments[i], run->segment_times[i]);
+        }
+    }
+    graph_add_run(state, run);
+    if (run->header.splits_reached) {
+        memcpy(state->latest, run->split_times, state->split_count * sizeof(long long));
+    }
+    if ((run->header.flags & LS_HISTORY_COMPLETED) && run->header.final_time > 0
+        && (!state->pb || run->header.final_time < state->pb)) {
+        state->pb = run->header.final_time;
+    }
+}
+
+/**
+ * Loads the whole history of a split file.
+ *
+ * @param state The worker state.
+ * @param split_file The path of the split file.
+ *
+ * @return Zero on success, non-zero otherwise.
+ */
+static int state_load(comparisons_state* state, const char* split_file)
+{
+    ls_history history;
+    state_clear(state);
+
+    // The split file knows the number of splits and the PB
+    json_t* game = json_load_file(split_file, 0, NULL);
+    if (!game) {
+        return 1;
+    }
+    json_t* splits = json_object_get(game, "splits");
+    state->split_count = json_array_size(splits);
+    if (state->split_count) {
+        json_t* last = json_array_get(splits, state->split_count - 1);
+        state->pb = ls_time_value(json_string_value(json_object_get(last, "time")));
+    }
+    json_decref(game);
+
+    strncpy(state->split_file, split_file, sizeof(state->split_file) - 1);
+    state->segments = calloc(state->split_count, sizeof(segment_samples));
+    state->latest = calloc(state->split_count, sizeof(long long));
+    state->resets = calloc(state->split_count, sizeof(unsigned int));
+    state->point_runs = 1;
+    if (!state->segments || !state->latest || !state->resets) {
+        state_clear(state);
+        return 1;
+    }
+
+    if (ls_history_open(&history, split_file)) {
+        return 1;
+    }
+    for (size_t i = 0; i < history.count; ++i) {
+        ls_history_run* run = ls_history_read_run(&history, i, state->split_count);
+        if (run) {
+            state_add_run(state, run);
+            ls_history_run_free(run);
+        }
+    }
+    state->run_count = history.count;
+    ls_history_close(&history);
+    return 0;
+}
+
+/**
+ * Computes the balanced PB segments.
+ *
+ * Finds, with a binary search, the percentile at which the sum of all
+ * segments matches the PB, then takes every segment at that percentile.
+ * Good segments then get compared against good times, bad ones against
+ * bad times, instead of against whatever happened during the PB.
+ *
+ * @param state The worker state.
+ * @param segments Where to store the segment times.
+ */
+static void balanced_pb(const comparisons_state* state, long long* segments)
+{
+    for (unsigned int i = 0; i < state->split_count; ++i) {
+        if (!state->segments[i].count) {
+            return;
+        }
+    }
+    if (!state->pb) {
+        return;
+    }
+
+    double low = 0.;
+    double high = 1.;
+    for (int iteration = 0; iteration < 32; ++iteration) {
+        const double mid = (low + high) / 2.;
+        long long total = 0;
+        for (unsigned int i = 0; i < state->split_count; ++i) {
+            total += samples_percentile(&state->segments[i], mid);
+        }
+        if (total < state->pb) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    for (unsigned int i = 0; i < state->split_count; ++i) {
+        segments[i] = samples_percentile(&state->segments[i], high);
+    }
+}
+
+/**
+ * Computes a new comparisons snapshot from the worker state.
+ *
+ * @param state The worker state.
+ *
+ * @return The snapshot, or NULL on error.
+ */
+static ls_comparisons* state_snapshot(const comparisons_state* state)
+{
+    const unsigned int n = state->split_count;
+    // A single allocation for the snapshot and all of its arrays
+    ls_comparisons* comparisons = calloc(1, sizeof(ls_comparisons)
+            + 2 * LS_COMPARISON_COUNT * n * sizeof(long long)
+            + n * sizeof(ls_graph_histogram)
+            + state->point_count * sizeof(ls_graph_point)
+            + n * sizeof(unsigned int));
+    if (!comparisons) {
+        return NULL;
+    }
+    strcpy(comparisons->split_file, state->split_file);
+    comparisons->split_count = n;
+    comparisons->run_count = state->run_count;
+
+    long long* times = (long long*)(comparisons + 1);
+    for (int c = LS_COMPARISON_PB + 1; c < LS_COMPARISON_COUNT; ++c) {
+        comparisons->split_times[c] = times;
+        comparisons->segment_times[c] = times + n;
+        times += 2 * n;
+    }
+    ls_graph_histogram* histograms = (ls_graph_histogram*)((long long*)(comparisons + 1) + 2 * LS_COMPARISON_COUNT * n);
+    ls_graph_point* points = (ls_graph_point*)(histograms + n);
+    unsigned int* resets = (unsigned int*)(points + state->point_count);
+
+    ls_run_graph* graph = &comparisons->graph;
+    memcpy(points, state->points, state->point_count * sizeof(ls_graph_point));
+    memcpy(resets, state->resets, n * sizeof(unsigned int));
+    graph->points = points;
+    graph->point_count = state->point_count;
+    graph->fastest = state->fastest;
+    graph->slowest = state->slowest;
+    graph->resets = resets;
+    graph->segments = histograms;
+    for (unsigned int i = 0; i < n; ++i) {
+        histograms[i] = state->segments[i].histogram;
+        if (resets[i] > graph->max_resets) {
+            graph->max_resets = resets[i];
+        }
+    }
+
+    for (unsigned int i = 0; i < n; ++i) {
+        const segment_samples* samples = &state->segments[i];
+        if (samples->count) {
+            comparisons->segment_times[LS_COMPARISON_AVERAGE][i] = samples->sum / (long long)samples->count;
+            comparisons->segment_times[LS_COMPARISON_MEDIAN][i] = samples->times[samples->count / 2];
+            comparisons->segment_times[LS_COMPARISON_BEST_SEGMENTS][i] = samples->times[0];
+        }
+        if (state->latest[i] > 0) {
+            comparisons->split_times[LS_COMPARISON_LATEST][i] = state->latest[i];
+            if (!i) {
+                comparisons->segment_times[LS_COMPARISON_LATEST][i] = state->latest[i];
+            } else if (state->latest[i - 1] > 0) {
+                comparisons->segment_times[LS_COMPARISON_LATEST][i] = state->latest[i] - state->latest[i - 1];
+            }
+        }
+    }
+    balanced_pb(state, comparisons->segment_times[LS_COMPARISON_BALANCED_PB]);
+
+    // Sum the segments into split times, which are unknown after an unknown segment
+    for (int c = LS_COMPARISON_PB + 1; c < LS_COMPARISON_COUNT; ++c) {
+        if (c == LS_COMPARISON_LATEST) {
+            continue;
+        }
+        long long total = 0;
+        for (unsigned int i = 0; i < n; ++i) {
+            if (!comparisons->segment_times[c][i]) {
+                break;
+            }
+            total += comparisons->segment_times[c][i];
+            comparisons->split_times[c][i] = total;
+        }
+    }
+    return comparisons;
+}
+
+/**
+ * Publishes a new snapshot for the main thread, replacing
+ * one it didn't take yet.
+ *
+ * @param state The worker state.
+ */
+static void publish(const comparisons_state* state)
+{
+    ls_comparisons* comparisons = state_snapshot(state);
+    if (comparisons) {
+        ls_comparisons_free(atomic_exchange(&pending, comparisons));
+        void (*callback)(void) = atomic_load(&ready_callback);
+        if (callback) {
+            callback();
+        }
+    }
+}
+
+/**
+ * The comparisons worker thread.
+ *
+ * @param arg Unused.
+ */
+void* ls_comparisons_thread(void* arg)
+{
+    prctl(PR_SET_NAME, "LS Comparisons", 0, 0, 0);
+    comparisons_state state = { 0 };
+
+    pthread_mutex_lock(&queue.lock);
+    while (1) {
+        while (queue.head == NULL && queue.active) {
+            pthread_cond_wait(&queue.cond, &queue.lock);
+        }
+        if (!queue.active) {
+            break;
+        }
+        ls_comparisons_request* request = queue.head;
+        queue.head = request->next;
+        if (!queue.head) {
+            queue.tail = NULL;
+        }
+        pthread_mutex_unlock(&queue.lock);
+
+        if (request->load) {
+            if (state_load(&state, request->split_file) == 0) {
+                publish(&state);
+            }
+        } else if (state.segments && strcmp(request->split_file, state.split_file) == 0
+            && request->position >= state.run_count) {
+            state_add_run(&state, request->run);
+            state.run_count = request->position + 1;
+            publish(&state);
+        }
+        if (request->run) {
+            ls_history_run_free(request->run);
+        }
+        free(request);
+
+        pthread_mutex_lock(&queue.lock);
+    }
+    // Drop whatever is left, the results would never be shown
+    while (queue.head) {
+        ls_comparisons_request* request = queue.head;
+        queue.head = request->next;
+        if (request->run) {
+            ls_history_run_free(request->run);
+        }
+        free(request);
+    }
+    queue.tail = NULL;
+    pthread_mutex_unlock(&queue.lock);
+
+    state_clear(&state);
+    ls_comparisons_free(atomic_exchange(&pending, NULL));
+    return NULL;
+}
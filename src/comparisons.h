@@ -0,0 +1,96 @@
+#pragma once
+
+#include "history.h"
+
+#include <linux/limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief The times a run can be compared against.
+ */
+typedef enum ls_comparison_type {
+    LS_COMPARISON_PB, /*!< The personal best, from the split file */
+    LS_COMPARISON_AVERAGE, /*!< Average of every segment in the history */
+    LS_COMPARISON_MEDIAN, /*!< Median of every segment in the history */
+    LS_COMPARISON_LATEST, /*!< The latest run in the history */
+    LS_COMPARISON_BALANCED_PB, /*!< The PB, with time spread evenly across segments */
+    LS_COMPARISON_BEST_SEGMENTS, /*!< Sum of the best segments, the best possible time */
+    LS_COMPARISON_COUNT,
+} ls_comparison_type;
+
+extern const char* const ls_comparison_names[LS_COMPARISON_COUNT];
+extern const char* const ls_comparison_keys[LS_COMPARISON_COUNT];
+
+ls_comparison_type ls_comparison_find(const char* key);
+
+#define LS_GRAPH_POINTS 128 /*!< Most points in the attempt history graph */
+#define LS_GRAPH_BINS 24 /*!< Bars in a segment distribution graph */
+
+/**
+ * @brief A group of consecutive attempts, a point of the attempt history graph.
+ */
+typedef struct ls_graph_point {
+    long long best; /*!< Best final time of the completed runs, 0 if none */
+    long long worst; /*!< Worst final time of the completed runs, 0 if none */
+    unsigned int runs; /*!< Number of attempts in the group */
+    unsigned int completed; /*!< Number of them that reached the last split */
+} ls_graph_point;
+
+/**
+ * @brief The distribution of the times of a segment.
+ */
+typedef struct ls_graph_histogram {
+    long long low; /*!< Time at the start of the first bin */
+    long long bin_width; /*!< Time covered by every bin, 0 if the segment has no times */
+    unsigned int bins[LS_GRAPH_BINS]; /*!< Number of times in every bin, the last one also holds the slower ones */
+    unsigned int peak; /*!< Number of times in the fullest bin */
+} ls_graph_histogram;
+
+/**
+ * @brief Downsampled history of the runs, ready to be plotted.
+ */
+typedef struct ls_run_graph {
+    const ls_graph_point* points; /*!< Attempt history, oldest first */
+    size_t point_count; /*!< Number of points */
+    long long fastest; /*!< Best final time in the history, 0 if none */
+    long long slowest; /*!< Worst final time in the history, 0 if none */
+    const unsigned int* resets; /*!< Number of runs reset during each split */
+    unsigned int max_resets; /*!< Highest number of resets of a single split */
+    const ls_graph_histogram* segments; /*!< Distribution of every segment */
+} ls_run_graph;
+
+/**
+ * @brief An immutable set of comparisons, computed from a run history.
+ * Times are 0 where they are unknown.
+ */
+typedef struct ls_comparisons {
+    char split_file[PATH_MAX]; /*!< The split file whose history was used */
+    unsigned int split_count; /*!< Number of splits */
+    size_t run_count; /*!< Number of runs the comparisons are based on */
+    long long* split_times[LS_COMPARISON_COUNT]; /*!< Cumulative split times, NULL for the PB */
+    long long* segment_times[LS_COMPARISON_COUNT]; /*!< Segment times, NULL for the PB */
+    ls_run_graph graph; /*!< History graphs */
+} ls_comparisons;
+
+/**
+ * @brief A request for the comparisons worker.
+ */
+typedef struct ls_comparisons_request {
+    bool load; /*!< Whether to (re)load the whole history, otherwise add a run */
+    char split_file[PATH_MAX]; /*!< The split file the request is about */
+    ls_history_run* run; /*!< Run to add, owned by the request */
+    size_t position; /*!< Position of the run in the history */
+    struct ls_comparisons_request* next; /*!< Next request in the queue */
+} ls_comparisons_request;
+
+void ls_comparisons_load(const char* split_file);
+void ls_comparisons_add_run(const char* split_file, ls_history_run* run, size_t position);
+
+ls_comparisons* ls_comparisons_take(void);
+void ls_comparisons_set_ready_callback(void (*callback)(void));
+void ls_comparisons_free(ls_comparisons* comparisons);
+
+void ls_comparisons_close(void);
+void* ls_comparisons_thread(void* arg);
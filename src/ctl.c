@@ -28,9 +28,38 @@ void print_help(void)
     printf("  unsplit       - Unsplit the timer\n");
     printf("  skipsplit     - Skip the current split\n");
     printf("  exit          - Closes LibreSplit\n");
+    printf("  stats         - Show startup, drawing and auto splitter statistics\n");
     printf("  help          - Show this help message\n");
 }
 
+/**
+ * Reads a text reply from LibreSplit and prints it.
+ *
+ * @param sockfd The socket connected to LibreSplit.
+ * @return True if the whole reply was read, false otherwise.
+ */
+bool printReply(int sockfd)
+{
+    uint32_t len = 0;
+    if (read(sockfd, &len, sizeof(len)) != sizeof(len)) {
+        fprintf(stderr, "LibreSplit didn't reply.\n");
+        return false;
+    }
+    len = ntohl(len);
+
+    char buffer[4096];
+    while (len > 0) {
+        const ssize_t n = read(sockfd, buffer, len < sizeof(buffer) ? len : sizeof(buffer));
+        if (n <= 0) {
+            fprintf(stderr, "Failed to read the reply from LibreSplit.\n");
+            return false;
+        }
+        fwrite(buffer, 1, n, stdout);
+        len -= n;
+    }
+    return true;
+}
+
 /**
  * Sends a command to LibreSplit via Unix Socket.
  *
@@ -85,9 +114,14 @@ bool sendToLibreSplit(const CTLCommand cmd)
         return false;
     }
     free(ctl_msg);
+
+    bool success = true;
+    if (cmd == CTL_CMD_STATS) {
+        success = printReply(sockfd);
+    }
     close(sockfd);
 
-    return true;
+    return success;
 }
 
 /**
@@ -122,6 +156,8 @@ int main(int argc, char* argv[])
         success = sendToLibreSplit(CTL_CMD_SKIP);
     } else if (strcmp(cmd, "exit") == 0) {
         success = sendToLibreSplit(CTL_CMD_EXIT);
+    } else if (strcmp(cmd, "stats") == 0) {
+        success = sendToLibreSplit(CTL_CMD_STATS);
     } else {
         fprintf(stderr, "Unknown command: %s\n", cmd);
         fprintf(stderr, "Try 'help' for a list of valid commands.\n");
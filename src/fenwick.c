@@ -0,0 +1,106 @@
+/** \file fenwick.c
+ * Fenwick (binary indexed) trees, for the statistics of a run that
+ * depend on sums of segments and must stay cheap to update every split.
+ */
+#include "fenwick.h"
+
+#include <string.h>
+
+/**
+ * Returns the memory a tree needs.
+ *
+ * @param size The number of values.
+ *
+ * @return The size of the memory, in bytes.
+ */
+size_t ls_fenwick_memory(unsigned int size)
+{
+    return 2 * ((size_t)size + 1) * sizeof(long long);
+}
+
+/**
+ * Sets up a tree in memory owned by the caller, so it can live in the
+ * same allocation as what it sums.
+ *
+ * @param fenwick The tree.
+ * @param size The number of values.
+ * @param memory At least ls_fenwick_memory(size) bytes, zeroed, aligned
+ *               for a long long. All values start at 0.
+ */
+void ls_fenwick_place(ls_fenwick* fenwick, unsigned int size, void* memory)
+{
+    fenwick->size = size;
+    fenwick->values = memory;
+    fenwick->tree = fenwick->values + size + 1;
+}
+
+/**
+ * Builds the tree again from its values, in O(n).
+ * For when most of the values changed at once.
+ *
+ * @param fenwick The tree.
+ */
+void ls_fenwick_build(ls_fenwick* fenwick)
+{
+    fenwick->tree[0] = 0;
+    memcpy(&fenwick->tree[1], fenwick->values, fenwick->size * sizeof(long long));
+    for (unsigned int i = 1; i <= fenwick->size; ++i) {
+        const unsigned int parent = i + (i & -i);
+        if (parent <= fenwick->size) {
+            fenwick->tree[parent] += fenwick->tree[i];
+        }
+    }
+}
+
+/**
+ * Changes a value, in O(log n).
+ *
+ * @param fenwick The tree.
+ * @param i The index of the value.
+ * @param value The new value.
+ */
+void ls_fenwick_set(ls_fenwick* fenwick, unsigned int i, long long value)
+{
+    const long long delta = value - fenwick->values[i];
+    fenwick->values[i] = value;
+    for (unsigned int j = i + 1; j <= fenwick->size; j += j & -j) {
+        fenwick->tree[j] += delta;
+    }
+}
+
+/**
+ * Returns the sum of the values before an index.
+ *
+ * @param fenwick The tree.
+ * @param end The index, at most the number of values.
+ *
+ * @return The sum.
+ */
+static long long prefix_sum(const ls_fenwick* fenwick, unsigned int end)
+{
+    long long sum = 0;
+    for (unsigned int j = end; j > 0; j -= j & -j) {
+        sum += fenwick->tree[j];
+    }
+    return sum;
+}
+
+/**
+ * Returns the sum of a range of values, in O(log n).
+ *
+ * @param fenwick The tree.
+ * @param begin The index of the first value.
+ * @param end The index after the last value.
+ *
+ * @return The sum, 0 for an empty range.
+ */
+long long ls_fenwick_sum(const ls_fenwick* fenwick, unsigned int begin, unsigned int end)
+{
+    if (end > fenwick->size) {
+        end = fenwick->size;
+    }
+    if (begin >= end) {
+        return 0;
+    }
+    return prefix_sum(fenwick, end) - prefix_sum(fenwick, begin);
+}
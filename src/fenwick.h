@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * @brief A Fenwick tree, sums of ranges of values kept up to date in O(log n).
+ */
+typedef struct ls_fenwick {
+    long long* values; /*!< The values, may be changed directly before calling ls_fenwick_build */
+    long long* tree; /*!< Partial sums, 1-based */
+    unsigned int size; /*!< Number of values */
+} ls_fenwick;
+
+size_t ls_fenwick_memory(unsigned int size);
+void ls_fenwick_place(ls_fenwick* fenwick, unsigned int size, void* memory);
+void ls_fenwick_build(ls_fenwick* fenwick);
+void ls_fenwick_set(ls_fenwick* fenwick, unsigned int i, long long value);
+long long ls_fenwick_sum(const ls_fenwick* fenwick, unsigned int begin, unsigned int end);
@@ -4,6 +4,7 @@
 #include "src/gui/timer.h"
 #include "src/lasr/auto-splitter.h"
 #include "src/lasr/utils.h"
+#include "src/saver.h"
 #include "src/settings/settings.h"
 #include <gtk/gtk.h>
 #include <sys/stat.h>
@@ -179,6 +180,8 @@ void save_activated(GSimpleAction* action,
         if (saving) {
             ls_game_update_splits(win->game, win->timer);
             save_game(win->game);
+            // The personal best may have changed
+            ls_app_window_set_comparison(win, win->comparison);
         }
     }
 }
@@ -284,7 +287,8 @@ void quit_activated(GSimpleAction* action,
     if (win->welcome_box) {
         welcome_box_destroy(win->welcome_box);
     }
-    exit(0);
+    // Don't lose any save still waiting to be written
+    exit(ls_saver_flush() ? EXIT_FAILURE : EXIT_SUCCESS);
 }
 
 /**
@@ -323,6 +327,31 @@ void menu_toggle_win_on_top(GtkCheckMenuItem* menu_item,
     win->opts.win_on_top = active;
 }
 
+/**
+ * Callback to change what the run is compared against.
+ *
+ * @param menu_item Pointer to the radio menu item that triggered this callback,
+ *                  carrying the comparison type as "comparison" data.
+ * @param app Pointer to the LibreSplit application.
+ */
+void menu_set_comparison(GtkCheckMenuItem* menu_item,
+    gpointer app)
+{
+    if (!gtk_check_menu_item_get_active(menu_item)) {
+        // Also called for the item being deselected
+        return;
+    }
+    GList* windows;
+    LSAppWindow* win;
+    windows = gtk_application_get_windows(GTK_APPLICATION(app));
+    if (windows) {
+        win = LS_APP_WINDOW(windows->data);
+    } else {
+        win = ls_app_window_new(LS_APP(app));
+    }
+    ls_app_window_set_comparison(win, GPOINTER_TO_INT(g_object_get_data(G_OBJECT(menu_item), "comparison")));
+}
+
 /**
  * Shows the "Open Lua Auto Splitter" dialog eventually using
  * the last known auto splitter folder. Also saves a new
@@ -16,4 +16,6 @@ void toggle_auto_splitter(GtkCheckMenuItem* menu_item, gpointer user_data);
 
 void menu_toggle_win_on_top(GtkCheckMenuItem* menu_item, gpointer app);
 
+void menu_set_comparison(GtkCheckMenuItem* menu_item, gpointer app);
+
 void open_auto_splitter(GSimpleAction* action, GVariant* parameter, gpointer app);
@@ -1,23 +1,37 @@
 #include "app_window.h"
+#include "src/comparisons.h"
 #include "src/gui/actions.h"
 #include "src/gui/component/components.h"
 #include "src/gui/context_menu.h"
+#include "src/gui/dialogs.h"
 #include "src/gui/game.h"
+#include "src/gui/icon_cache.h"
+#include "src/gui/offscreen.h"
 #include "src/gui/theming.h"
 #include "src/gui/timer.h"
+#include "src/journal.h"
 #include "src/keybinds/delayed_callbacks.h"
 #include "src/keybinds/keybinds_callbacks.h"
 #include "src/lasr/auto-splitter.h"
+#include "src/lasr/sampler.h"
 #include "src/logging.h"
+#include "src/saver.h"
 #include "src/settings/settings.h"
 #include "src/settings/utils.h"
+#include "src/stats.h"
 #include "src/timer.h"
+#include <linux/prctl.h>
+#include <pthread.h>
 #include <stdatomic.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/prctl.h>
 #include <sys/stat.h>
 
 extern atomic_bool exit_requested; /*!< Set to 1 when LibreSplit is exiting */
 
+#define REDRAW_SLACK 2000 /*!< How early a frame may come and still be drawn, in microseconds */
+
 static void ls_app_init(LSApp* app)
 {
 }
@@ -42,7 +56,14 @@ void toggle_win_on_top(LSAppWindow* win)
     config_save();
 }
 
-static void resize_window(LSAppWindow* win,
+/**
+ * Tells the components the size of the window changed.
+ *
+ * @param win The LibreSplit window.
+ * @param window_width The new width of the window.
+ * @param window_height The new height of the window.
+ */
+void ls_app_window_resize_components(LSAppWindow* win,
     int window_width,
     int window_height)
 {
@@ -62,10 +83,128 @@ gboolean ls_app_window_resize(GtkWidget* widget,
     gpointer data)
 {
     LSAppWindow* win = (LSAppWindow*)widget;
-    resize_window(win, event->configure.width, event->configure.height);
+    ls_app_window_resize_components(win, event->configure.width, event->configure.height);
+    ls_app_window_request_draw(widget);
     return FALSE;
 }
 
+/**
+ * Compares the run against the chosen comparison.
+ *
+ * Comparisons other than the personal best come from the run history,
+ * until the worker computed them the personal best is used instead.
+ *
+ * @param win The LibreSplit window.
+ * @param comparison The comparison to use.
+ */
+void ls_app_window_set_comparison(LSAppWindow* win, ls_comparison_type comparison)
+{
+    win->comparison = comparison;
+    if (!win->timer) {
+        return;
+    }
+    ls_app_window_wake(win);
+    if (win->comparisons && win->comparisons->split_count == win->game->split_count) {
+        ls_timer_set_comparison(win->timer,
+            win->comparisons->split_times[comparison],
+            win->comparisons->segment_times[comparison]);
+        win->timer->graph = &win->comparisons->graph;
+        win->timer->comparisons = win->comparisons;
+    } else {
+        ls_timer_set_comparison(win->timer, NULL, NULL);
+        win->timer->graph = NULL;
+        win->timer->comparisons = NULL;
+    }
+}
+
+/**
+ * Replaces the components of the window with the ones of a layout.
+ *
+ * A layout is a comma separated list of component names, in the order they
+ * are shown. A name may be followed by a colon and an argument, so the same
+ * component can be shown more than once, configured differently.
+ * Only the components in the layout are created, drawn and notified.
+ *
+ * @param win The LibreSplit window.
+ * @param layout The layout, like LS_DEFAULT_LAYOUT.
+ */
+static void ls_app_window_set_layout(LSAppWindow* win, const char* layout)
+{
+    if (win->layout && strcmp(win->layout, layout) == 0) {
+        return;
+    }
+
+    for (GList* l = win->components; l != NULL; l = l->next) {
+        LSComponent* component = l->data;
+        GtkWidget* widget = component->ops->widget(component);
+        component->ops->delete(component);
+        if (widget) {
+            gtk_widget_destroy(widget);
+        }
+    }
+    g_list_free(win->components);
+    win->components = NULL;
+    free(win->layout);
+    win->layout = strdup(layout);
+
+    gchar** entries = g_strsplit(layout, ",", -1);
+    for (int i = 0; entries[i] != NULL; i++) {
+        char* name = g_strstrip(entries[i]);
+        char* arg = strchr(name, ':');
+        if (arg) {
+            *arg++ = '\0';
+        }
+        if (!*name) {
+            continue;
+        }
+        const LSComponentAvailable* available = ls_component_find(name);
+        if (!available) {
+            LOG_WARNF("Unknown component in the layout: %s", name);
+            continue;
+        }
+        LSComponent* component = available->new(arg);
+        if (component) {
+            GtkWidget* widget = component->ops->widget(component);
+            if (widget) {
+                gtk_widget_set_margin_start(widget, WINDOW_PAD);
+                gtk_widget_set_margin_end(widget, WINDOW_PAD);
+                gtk_container_add(GTK_CONTAINER(win->box), widget);
+            }
+            win->components = g_list_append(win->components, component);
+        }
+    }
+    g_strfreev(entries);
+
+    // The footer stays at the bottom
+    if (win->footer) {
+        gtk_box_reorder_child(GTK_BOX(win->box), win->footer, -1);
+        int width, height;
+        gtk_window_get_size(GTK_WINDOW(win), &width, &height);
+        ls_app_window_resize_components(win, width, height);
+    }
+}
+
+/**
+ * Installs comparisons computed by the worker, if they are about the open splits.
+ *
+ * @param win The LibreSplit window.
+ * @param comparisons The new comparisons, the window takes ownership of them.
+ */
+static void update_comparisons(LSAppWindow* win, ls_comparisons* comparisons)
+{
+    if (!win->game || strcmp(comparisons->split_file, win->game->path) != 0) {
+        ls_comparisons_free(comparisons);
+        return;
+    }
+    ls_comparisons* old = win->comparisons;
+    win->comparisons = comparisons;
+    // The timer must stop pointing to the old comparisons before they are freed
+    ls_app_window_set_comparison(win, win->comparison);
+    if (old) {
+        ls_comparisons_free(old);
+    }
+}
+
 LSAppWindow* ls_app_window_new(LSApp* app)
 {
     LSAppWindow* win;
@@ -74,22 +213,33 @@ LSAppWindow* ls_app_window_new(LSApp* app)
     return win;
 }
 
-void ls_app_window_open(LSAppWindow* win, const char* file)
+/**
+ * Replaces the game of the window with a parsed split file.
+ *
+ * @param win The LibreSplit window.
+ * @param game The parsed split file, NULL if it couldn't be parsed.
+ * @param file The path of the split file.
+ * @param error_msg Why the split file couldn't be parsed, or NULL, freed here.
+ */
+static void ls_app_window_set_game(LSAppWindow* win, ls_game* game, const char* file, char* error_msg)
 {
-    char* error_msg = NULL;
     GtkWidget* error_popup;
 
+    ls_app_window_wake(win);
     if (win->timer) {
         ls_app_window_clear_game(win);
         ls_timer_release(win->timer);
         win->timer = 0;
     }
+    if (win->comparisons) {
+        ls_comparisons_free(win->comparisons);
+        win->comparisons = NULL;
+    }
     if (win->game) {
         ls_game_release(win->game);
-        win->game = 0;
     }
-    if (ls_game_create(&win->game, file, &error_msg)) {
-        win->game = 0;
+    win->game = game;
+    if (!win->game) {
         if (error_msg) {
             error_popup = gtk_message_dialog_new(
                 GTK_WINDOW(win),
@@ -107,10 +257,131 @@ void ls_app_window_open(LSAppWindow* win, const char* file)
     } else if (ls_timer_create(&win->timer, win->game)) {
         win->timer = 0;
     } else {
+        ls_app_window_set_layout(win,
+            win->game->layout ? win->game->layout : cfg.libresplit.layout.value.s);
+        ls_app_window_set_comparison(win, win->comparison);
+        // Icons may have been edited since the split file was last opened
+        ls_icon_cache_refresh();
+        // Bring old runs/run_*.json files into the history of this split file,
+        // the comparisons are computed from the history once that's done
+        ls_saver_queue_migration(win->game->path);
+        // Offer to pick up a run that was interrupted by a crash or a quit
+        if (ls_journal_pending(win->game->path, win->game->split_count)) {
+            if (!display_confirm_restore_dialog() || !ls_timer_restore(win->timer)) {
+                ls_journal_set_state(LS_JOURNAL_IDLE);
+            }
+        }
         ls_app_window_show_game(win);
     }
 }
 
+/**
+ * Opens a split file.
+ *
+ * @param win The LibreSplit window.
+ * @param file The path of the split file.
+ */
+void ls_app_window_open(LSAppWindow* win, const char* file)
+{
+    ls_game* game = NULL;
+    char* error_msg = NULL;
+
+    // Split files still being parsed are stale now
+    win->open_serial++;
+    if (ls_game_create(&game, file, &error_msg)) {
+        game = NULL;
+    }
+    ls_app_window_set_game(win, game, file, error_msg);
+}
+
+/**
+ * @brief A split file being parsed on a worker thread.
+ */
+typedef struct LSOpenJob {
+    LSAppWindow* win; /*!< The window to open the split file in, referenced */
+    unsigned long serial; /*!< The open serial of the window when the job started */
+    char path[PATH_MAX]; /*!< The split file */
+    ls_game* game; /*!< The parsed split file, NULL if it couldn't be parsed */
+    char* error_msg; /*!< Why the split file couldn't be parsed */
+} LSOpenJob;
+
+/**
+ * Hands a parsed split file to the window, back on the main thread.
+ *
+ * @param data The job.
+ */
+static gboolean ls_app_window_open_finish(gpointer data)
+{
+    LSOpenJob* job = data;
+    if (job->serial == job->win->open_serial) {
+        ls_app_window_set_game(job->win, job->game, job->path, job->error_msg);
+        ls_stats_phase("split file");
+    } else {
+        // Another split file was opened in the meantime
+        if (job->game) {
+            ls_game_release(job->game);
+        }
+        free(job->error_msg);
+    }
+    g_object_unref(job->win);
+    free(job);
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * Parses a split file, on its own thread.
+ *
+ * @param arg The job.
+ */
+static void* ls_app_window_open_thread(void* arg)
+{
+    LSOpenJob* job = arg;
+    prctl(PR_SET_NAME, "LS Open", 0, 0, 0);
+    if (ls_game_create(&job->game, job->path, &job->error_msg)) {
+        job->game = NULL;
+    }
+    g_idle_add(ls_app_window_open_finish, job);
+    return NULL;
+}
+
+/**
+ * Opens a split file, parsing it on a worker thread so the window stays
+ * responsive. The timer is usable once the split file is parsed.
+ *
+ * @param win The LibreSplit window.
+ * @param file The path of the split file.
+ */
+void ls_app_window_open_async(LSAppWindow* win, const char* file)
+{
+    pthread_t thread;
+    LSOpenJob* job = calloc(1, sizeof(LSOpenJob));
+    if (!job || strlen(file) >= sizeof(job->path)) {
+        free(job);
+        ls_app_window_open(win, file);
+        return;
+    }
+    job->win = g_object_ref(win);
+    job->serial = ++win->open_serial;
+    strcpy(job->path, file);
+    if (pthread_create(&thread, NULL, ls_app_window_open_thread, job)) {
+        g_object_unref(win);
+        free(job);
+        ls_app_window_open(win, file);
+        return;
+    }
+    pthread_detach(thread);
+}
+
+/**
+ * Shows the saves that failed, called by the saver from its own thread.
+ *
+ * @param path The file that couldn't be written.
+ */
+static void ls_app_save_failed(const char* path)
+{
+    g_idle_add(display_save_error_dialog, g_strdup(path));
+}
+
 /**
  * Starts LibreSplit, loading the last splits and auto splitter.
  * Eventually opens some dialogs if there are no last splits or auto-splitters.
@@ -122,10 +393,16 @@ void ls_app_activate(GApplication* app)
     if (!config_init()) {
         printf("Configuration failed to load, will use defaults\n");
     }
+    ls_stats_phase("settings");
+    ls_saver_set_error_callback(ls_app_save_failed);
+    ls_comparisons_set_ready_callback(ls_app_wake);
 
     LSAppWindow* win;
     win = ls_app_window_new(LS_APP(app));
-    gtk_window_present(GTK_WINDOW(win));
+    if (!ls_offscreen_start(win)) {
+        gtk_window_present(GTK_WINDOW(win));
+    }
+    ls_stats_phase("window");
 
     if (cfg.history.split_file.value.s[0] != '\0') {
         // Check if split file exists
@@ -136,7 +413,7 @@ void ls_app_activate(GApplication* app)
             printf("Split JSON %s does not exist\n", splits_path);
             open_activated(NULL, NULL, app);
         } else {
-            ls_app_window_open(win, splits_path);
+            ls_app_window_open_async(win, splits_path);
         }
     } else {
         open_activated(NULL, NULL, app);
@@ -170,9 +447,13 @@ void ls_app_open(GApplication* app,
         win = ls_app_window_new(LS_APP(app));
     }
     for (i = 0; i < n_files; i++) {
-        ls_app_window_open(win, g_file_get_path(files[i]));
+        char* path = g_file_get_path(files[i]);
+        ls_app_window_open_async(win, path);
+        g_free(path);
+    }
+    if (!ls_offscreen_active()) {
+        gtk_window_present(GTK_WINDOW(win));
     }
-    gtk_window_present(GTK_WINDOW(win));
 }
 
 LSApp* ls_app_new(void)
@@ -203,16 +484,36 @@ static void ls_app_window_class_init(LSAppWindowClass* class)
 void ls_app_window_destroy(GtkWidget* widget, gpointer data)
 {
     LSAppWindow* win = (LSAppWindow*)widget;
+    if (win->step_id) {
+        g_source_remove(win->step_id);
+        win->step_id = 0;
+    }
     if (win->timer) {
         ls_timer_release(win->timer);
         win->timer = 0;
     }
+    if (win->comparisons) {
+        ls_comparisons_free(win->comparisons);
+        win->comparisons = NULL;
+    }
     if (win->game) {
         ls_game_release(win->game);
         win->game = 0;
     }
+    if (win->layout) {
+        free(win->layout);
+        win->layout = NULL;
+    }
+    // Drop the split files still being parsed
+    win->open_serial++;
+    ls_app_window_unwatch_theme(win);
     atomic_store(&auto_splitter_enabled, 0);
     atomic_store(&exit_requested, 1);
+    ls_saver_close();
+    ls_comparisons_close();
+    ls_icon_cache_close();
+    ls_journal_close();
+    // Last, the others log failed saves and errors while closing
     close_logger();
     // Close any other open application windows (settings, dialogs, etc.)
     GApplication* app = g_application_get_default();
@@ -229,10 +530,43 @@ void ls_app_window_destroy(GtkWidget* widget, gpointer data)
     }
 }
 
+/**
+ * Starts or ends a load reported by the auto splitter.
+ *
+ * @param win The LibreSplit Window.
+ * @param loading Whether the game is loading.
+ * @param time When the load started or ended, according to the timer clock.
+ */
+static void set_loading(LSAppWindow* win, bool loading, long long time)
+{
+    if (loading == (bool)win->timer->loading) {
+        return;
+    }
+    if (win->timer->running) {
+        if (loading) {
+            timer_pause_at(win, time);
+        } else {
+            timer_unpause_at(win, time);
+        }
+    } else if (loading) {
+        // Track loads even while not running
+        ls_timer_pause_at(win->timer, time);
+    } else {
+        ls_timer_unpause_at(win->timer, time);
+    }
+}
+
 /**
  * Updates the internal state of the LibreSplit Window.
  *
+ * Runs every millisecond while the timer runs, and removes itself
+ * otherwise, so an idle window doesn't wake up at all. Anything that needs
+ * it to run again calls ls_app_window_wake, or ls_app_wake from another
+ * thread, like the auto splitter does when it asks for a timer action.
+ *
  * @param data Pointer to the LibreSplit Window.
+ *
+ * @return G_SOURCE_CONTINUE while busy, G_SOURCE_REMOVE once idle.
  */
 gboolean ls_app_window_step(gpointer data)
 {
@@ -248,6 +582,11 @@ gboolean ls_app_window_step(gpointer data)
     }
 
     if (win->timer) {
+        ls_comparisons* comparisons = ls_comparisons_take();
+        if (comparisons) {
+            update_comparisons(win, comparisons);
+        }
+
         ls_timer_step(win->timer);
 
         // printf("RTA: %llu; LT: %llu; LRT: %llu; GT: %llu; GT?: %d\n",
@@ -259,7 +598,7 @@ gboolean ls_app_window_step(gpointer data)
 
         if (atomic_load(&auto_splitter_enabled)) {
             if (atomic_load(&run_using_game_time_call)) {
-                win->timer->usingGameTime = atomic_load(&run_using_game_time);
+                ls_timer_use_game_time(win->timer, atomic_load(&run_using_game_time));
                 atomic_store(&run_using_game_time_call, false);
             }
             if (atomic_load(&call_start)) {
@@ -271,20 +610,17 @@ gboolean ls_app_window_step(gpointer data)
                 atomic_store(&call_split, 0);
             }
             if (atomic_load(&toggle_loading)) {
-                win->timer->loading = !win->timer->loading;
-
-                if (win->timer->running) {
-                    if (win->timer->loading) {
-                        timer_pause(win);
-                    } else {
-                        timer_unpause(win);
-                    }
-                }
+                set_loading(win, !win->timer->loading, ls_timer_now(win->timer));
                 atomic_store(&toggle_loading, 0);
             }
+            // Loads seen by the sampler, from when they were sampled
+            lasr_load_event load;
+            while (lasr_sampler_take(&load)) {
+                set_loading(win, load.loading, load.time);
+            }
             if (atomic_load(&update_game_time)) {
                 // Update the timer with the game time from auto-splitter
-                win->timer->gameTime = atomic_load(&game_time_value);
+                ls_timer_set_game_time(win->timer, atomic_load(&game_time_value));
                 atomic_store(&update_game_time, false);
             }
             if (atomic_load(&call_reset)) {
@@ -296,12 +632,82 @@ gboolean ls_app_window_step(gpointer data)
     }
     process_delayed_handlers(win);
 
-    return TRUE;
+    // Wake the frame clock up only when there's something new to show
+    if ((win->timer && (win->timer->running || win->timer->generation != win->drawn_generation))
+        || ls_icon_cache_generation() != win->drawn_icon_generation) {
+        ls_app_window_request_draw(GTK_WIDGET(win));
+    }
+
+    const bool busy = (win->timer && win->timer->running)
+        || (win->opts.hide_cursor && !set_cursor);
+    if (!busy) {
+        win->step_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
 }
 
-gboolean ls_app_window_draw(gpointer data)
+/**
+ * Makes sure the window gets stepped, until it's idle again.
+ *
+ * Must be called on the main thread, after anything the step has to take
+ * care of: a timer event, a delayed handler, new comparisons...
+ *
+ * @param win The LibreSplit Window.
+ */
+void ls_app_window_wake(LSAppWindow* win)
+{
+    if (!win->step_id) {
+        win->step_id = g_timeout_add(1, ls_app_window_step, win);
+    }
+}
+
+static atomic_bool wake_pending = false; /*!< Whether the windows are about to be woken up */
+
+/**
+ * Wakes the LibreSplit windows up, on the main thread.
+ *
+ * @param data Unused.
+ *
+ * @return G_SOURCE_REMOVE, to only run once.
+ */
+static gboolean ls_app_wake_windows(gpointer data)
+{
+    // Wakes asked from now on need another run
+    atomic_store(&wake_pending, false);
+    GApplication* app = g_application_get_default();
+    if (!app) {
+        return G_SOURCE_REMOVE;
+    }
+    GList* windows = gtk_application_get_windows(GTK_APPLICATION(app));
+    for (GList* l = windows; l != NULL; l = l->next) {
+        if (G_TYPE_CHECK_INSTANCE_TYPE(l->data, LS_APP_WINDOW_TYPE)) {
+            ls_app_window_wake(LS_APP_WINDOW(l->data));
+        }
+    }
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * Wakes the LibreSplit windows up, from any thread, for instance when the
+ * auto splitter asks for a split or a worker has something new to show.
+ *
+ * Wakes asked before the windows were woken up are merged into one.
+ */
+void ls_app_wake(void)
+{
+    if (!atomic_exchange(&wake_pending, true)) {
+        g_idle_add(ls_app_wake_windows, NULL);
+    }
+}
+
+/**
+ * Draws the components of the LibreSplit Window.
+ *
+ * @param win The LibreSplit Window.
+ */
+void ls_app_window_draw(LSAppWindow* win)
 {
-    LSAppWindow* win = data;
     if (win->timer) {
         GList* l;
         for (l = win->components; l != NULL; l = l->next) {
@@ -310,21 +716,109 @@ gboolean ls_app_window_draw(gpointer data)
                 component->ops->draw(component, win->game, win->timer);
             }
         }
+        win->drawn_generation = win->timer->generation;
     } else {
         GdkRectangle rect;
         gtk_widget_get_allocation(GTK_WIDGET(win), &rect);
         gdk_window_invalidate_rect(gtk_widget_get_window(GTK_WIDGET(win)),
             &rect, FALSE);
     }
-    return TRUE;
+    win->drawn_icon_generation = ls_icon_cache_generation();
 }
 
-static void ls_app_window_init(LSAppWindow* win)
+/**
+ * Loads the theme, deferred until the window is shown to get it on
+ * screen sooner.
+ *
+ * @param data The LibreSplit Window, referenced.
+ */
+static gboolean ls_app_window_load_theme(gpointer data)
 {
-    const char* theme;
-    const char* theme_variant;
-    int i;
+    LSAppWindow* win = data;
+    // A split file opened in the meantime may have brought its own theme
+    if (!win->game || !win->game->theme) {
+        ls_app_load_theme_with_fallback(win,
+            cfg.libresplit.theme.value.s, cfg.libresplit.theme_variant.value.s);
+    }
+    ls_stats_phase("theme");
+    g_object_unref(win);
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * Finishes the startup once the first frame was drawn, on screen or not.
+ *
+ * @param win The LibreSplit Window.
+ */
+void ls_app_window_shown(LSAppWindow* win)
+{
+    if (!win->shown) {
+        // The theme waits for the window to be on screen
+        win->shown = true;
+        ls_stats_phase("first frame");
+        g_idle_add(ls_app_window_load_theme, g_object_ref(win));
+    }
+}
+
+/**
+ * Frame clock callback, draws the window at the configured rate and
+ * removes itself once there's nothing left to animate.
+ *
+ * @param widget The LibreSplit Window.
+ * @param clock The frame clock of the window.
+ * @param data Unused.
+ *
+ * @return G_SOURCE_CONTINUE while the timer runs, G_SOURCE_REMOVE otherwise.
+ */
+static gboolean ls_app_window_tick(GtkWidget* widget, GdkFrameClock* clock, gpointer data)
+{
+    LSAppWindow* win = LS_APP_WINDOW(widget);
+    const gint64 frame_time = gdk_frame_clock_get_frame_time(clock);
+    const int rate = cfg.libresplit.redraw_rate.value.i;
+    const bool animating = win->timer && win->timer->running;
+
+    // Skip the frames coming earlier than the configured rate, with a bit of
+    // slack so that a 60 Hz display still draws every other frame at 30 FPS
+    if (animating && rate > 0 && win->last_frame_time
+        && frame_time - win->last_frame_time < 1000000 / rate - REDRAW_SLACK) {
+        return G_SOURCE_CONTINUE;
+    }
 
+    const gint64 start = g_get_monotonic_time();
+    ls_app_window_draw(win);
+    ls_stats_frame(g_get_monotonic_time() - start,
+        win->last_frame_time ? frame_time - win->last_frame_time : 0);
+
+    ls_app_window_shown(win);
+
+    if (!animating) {
+        win->tick_id = 0;
+        win->last_frame_time = 0;
+        return G_SOURCE_REMOVE;
+    }
+    win->last_frame_time = frame_time;
+    return G_SOURCE_CONTINUE;
+}
+
+/**
+ * Asks for the window a widget belongs to to be drawn on the next frame.
+ *
+ * @param widget The LibreSplit Window or any widget inside it.
+ */
+void ls_app_window_request_draw(GtkWidget* widget)
+{
+    GtkWidget* toplevel = gtk_widget_get_toplevel(widget);
+    if (!G_TYPE_CHECK_INSTANCE_TYPE(toplevel, LS_APP_WINDOW_TYPE)) {
+        return;
+    }
+    LSAppWindow* win = LS_APP_WINDOW(toplevel);
+    if (!win->tick_id) {
+        win->tick_id = gtk_widget_add_tick_callback(toplevel, ls_app_window_tick, NULL, NULL);
+    }
+}
+
+static void ls_app_window_init(LSAppWindow* win)
+{
     win->display = gdk_display_get_default();
     win->style = NULL;
     win->context_menu = NULL;
@@ -348,16 +842,13 @@ static void ls_app_window_init(LSAppWindow* win)
     gtk_window_set_decorated(GTK_WINDOW(win), win->opts.decorated);
     gtk_window_set_keep_above(GTK_WINDOW(win), win->opts.win_on_top);
 
-    // Load theme
-    theme = cfg.libresplit.theme.value.s;
-    theme_variant = cfg.libresplit.theme_variant.value.s;
-    ls_app_load_theme_with_fallback(win, theme, theme_variant);
-
     // Load window junk
     add_class(GTK_WIDGET(win), "window");
     add_class(GTK_WIDGET(win), "main-window");
     win->game = 0;
     win->timer = 0;
+    win->comparisons = NULL;
+    win->comparison = LS_COMPARISON_PB;
 
     g_signal_connect(win, "destroy",
         G_CALLBACK(ls_app_window_destroy), NULL);
@@ -393,21 +884,9 @@ static void ls_app_window_init(LSAppWindow* win)
     gtk_widget_set_vexpand(win->box, TRUE);
     gtk_container_add(GTK_CONTAINER(win->container), win->box);
 
-    // Create all available components (TODO: change this in the future)
     win->components = NULL;
-    for (i = 0; ls_components[i].name != NULL; i++) {
-        LSComponent* component = ls_components[i].new();
-        if (component) {
-            GtkWidget* widget = component->ops->widget(component);
-            if (widget) {
-                gtk_widget_set_margin_start(widget, WINDOW_PAD);
-                gtk_widget_set_margin_end(widget, WINDOW_PAD);
-                gtk_container_add(GTK_CONTAINER(win->box),
-                    component->ops->widget(component));
-            }
-            win->components = g_list_append(win->components, component);
-        }
-    }
+    win->layout = NULL;
+    ls_app_window_set_layout(win, cfg.libresplit.layout.value.s);
 
     // NOTE: This always creates an empty footer, no matter how many
     //  ^ "footers" are available, which may give issues with theming
@@ -418,8 +897,9 @@ static void ls_app_window_init(LSAppWindow* win)
     gtk_container_add(GTK_CONTAINER(win->box), win->footer);
     gtk_widget_show(win->footer);
 
-    // Update the internal state every millisecond
-    g_timeout_add(1, ls_app_window_step, win);
-    // Draw the window at 30 FPS
-    g_timeout_add((int)(1000 / 30.), ls_app_window_draw, win);
+    // Update the internal state every millisecond, until idle
+    win->step_id = 0;
+    ls_app_window_wake(win);
+    // Drawing follows the frame clock, see ls_app_window_tick
+    ls_app_window_request_draw(GTK_WIDGET(win));
 }
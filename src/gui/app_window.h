@@ -1,5 +1,6 @@
 #pragma once
 
+#include "src/comparisons.h"
 #include "src/gui/welcome_box.h"
 #include "src/keybinds/delayed_handlers.h"
 #include "src/keybinds/keybinds.h"
@@ -42,24 +43,38 @@ typedef struct _LSAppWindow {
     char data_path[PATH_MAX]; /*!< The path to the libresplit user config directory */
     ls_game* game;
     ls_timer* timer;
+    ls_comparisons* comparisons; /*!< Latest comparisons computed from the run history, NULL until ready */
+    ls_comparison_type comparison; /*!< What the run is compared against */
     GdkDisplay* display;
     GtkWidget* container;
     LSWelcomeBox* welcome_box;
     GtkWidget* box;
     GtkWidget* context_menu; /*!< The context menu */
     GList* components;
+    char* layout; /*!< The layout the components were created from */
     GtkWidget* footer;
     GtkCssProvider* reset_style; /*!< The "reset rules" provider, will remove desktop theme rules */
     GtkCssProvider* style; /*!< Current style provider, there can be only one */
+    GFileMonitor* theme_monitor; /*!< Watches the theme file, NULL when using the default theme */
+    guint theme_reload; /*!< Pending reload of the theme, 0 if none */
+    char theme_path[PATH_MAX]; /*!< The theme file being watched */
     LSKeybinds keybinds; /*!< The keybinds related to this application window */
     DelayedHandlers delayed_handlers; /*!< Handlers due for the next window step */
     LSOpts opts; /*!< The window options */
+    guint step_id; /*!< The source stepping the window, 0 while idle */
+    guint tick_id; /*!< The frame clock callback drawing the window, 0 when idle */
+    gint64 last_frame_time; /*!< Frame time of the last frame drawn, 0 after being idle */
+    unsigned long drawn_generation; /*!< Timer generation when the window was last drawn */
+    unsigned long drawn_icon_generation; /*!< Icon cache generation when the window was last drawn */
+    bool shown; /*!< Whether the first frame was drawn */
+    unsigned long open_serial; /*!< Bumped when a split file is opened, to drop those still being parsed */
 } LSAppWindow;
 
 void toggle_decorations(LSAppWindow* win);
 void toggle_win_on_top(LSAppWindow* win);
 
 gboolean ls_app_window_resize(GtkWidget* widget, GdkEvent* event, gpointer data);
+void ls_app_window_resize_components(LSAppWindow* win, int window_width, int window_height);
 
 LSAppWindow* ls_app_window_new(LSApp* app);
 void ls_app_activate(GApplication* app);
@@ -67,7 +82,13 @@ void ls_app_open(GApplication* app, GFile** files, gint n_files, const gchar* hi
 LSApp* ls_app_new(void);
 
 void ls_app_window_open(LSAppWindow* win, const char* file);
+void ls_app_window_open_async(LSAppWindow* win, const char* file);
+void ls_app_window_set_comparison(LSAppWindow* win, ls_comparison_type comparison);
 
 gboolean ls_app_window_step(gpointer data);
+void ls_app_window_wake(LSAppWindow* win);
+void ls_app_wake(void);
 void ls_app_window_destroy(GtkWidget* widget, gpointer data);
-gboolean ls_app_window_draw(gpointer data);
+void ls_app_window_draw(LSAppWindow* win);
+void ls_app_window_request_draw(GtkWidget* widget);
+void ls_app_window_shown(LSAppWindow* win);
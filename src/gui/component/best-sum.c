@@ -19,7 +19,7 @@ extern LSComponentOps ls_best_sum_operations;
 /**
  * Constructor
  */
-LSComponent* ls_component_best_sum_new(void)
+LSComponent* ls_component_best_sum_new(const char* arg)
 {
     LSBestSum* self;
     GtkWidget* label;
@@ -113,12 +113,12 @@ static void best_sum_draw(LSComponent* self_, const ls_game* game,
 {
     LSBestSum* self = (LSBestSum*)self_;
     char str[256];
-    remove_class(self->sum_of_bests, "time");
-    gtk_label_set_text(GTK_LABEL(self->sum_of_bests), "-");
+    set_class(self->sum_of_bests, "time", timer->sum_of_bests);
     if (timer->sum_of_bests) {
-        add_class(self->sum_of_bests, "time");
         ls_time_string(str, timer->sum_of_bests);
-        gtk_label_set_text(GTK_LABEL(self->sum_of_bests), str);
+        set_label_text(self->sum_of_bests, str);
+    } else {
+        set_label_text(self->sum_of_bests, "-");
     }
 }
 
@@ -12,13 +12,16 @@ typedef struct LSTimer {
     GtkWidget* time; /*!< The timer container */
     GtkWidget* time_seconds; /*!< The label representing the seconds part of the timer */
     GtkWidget* time_millis; /*!< The label representing the milliseconds part of the timer */
+    bool real_time; /*!< Whether to show the real time rather than the timing method of the run */
 } LSTimer;
 extern LSComponentOps ls_timer_operations;
 
 /**
  * Constructor
+ *
+ * @param arg "real" to always show the real time, including loads.
  */
-LSComponent* ls_component_timer_new(void)
+LSComponent* ls_component_timer_new(const char* arg)
 {
     LSTimer* self;
     GtkWidget* spacer;
@@ -28,6 +31,7 @@ LSComponent* ls_component_timer_new(void)
         return NULL;
     }
     self->base.ops = &ls_timer_operations;
+    self->real_time = arg && strcmp(arg, "real") == 0;
 
     self->time = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
     add_class(self->time, "timer");
@@ -112,36 +116,22 @@ static void timer_draw(LSComponent* self_, const ls_game* game, const ls_timer*
         --curr;
     }
 
-    remove_class(self->time, "delay");
-    remove_class(self->time, "behind");
-    remove_class(self->time, "losing");
-    remove_class(self->time, "best-split");
-
     if (curr && curr == game->split_count) {
         curr = game->split_count - 1;
     }
-    if (ls_timer_get_time(timer, true) <= 0) {
-        add_class(self->time, "delay");
-    } else {
-        if (timer->curr_split == game->split_count
-            && timer->split_info[curr]
-                & LS_INFO_BEST_SPLIT) {
-            add_class(self->time, "best-split");
-        } else {
-            if (timer->split_info[curr]
-                & LS_INFO_BEHIND_TIME) {
-                add_class(self->time, "behind");
-            }
-            if (timer->split_info[curr]
-                & LS_INFO_LOSING_TIME) {
-                add_class(self->time, "losing");
-            }
-        }
-    }
-    ls_time_millis_string(str, &millis[1], ls_timer_get_time(timer, true));
+    // Work out the classes first, so the label is only restyled when they change
+    const long long time = self->real_time ? timer->realTime : ls_timer_get_time(timer, true);
+    const bool delay = time <= 0;
+    const bool best_split = !delay && timer->curr_split == game->split_count
+        && timer->split_info[curr] & LS_INFO_BEST_SPLIT;
+    set_class(self->time, "delay", delay);
+    set_class(self->time, "best-split", best_split);
+    set_class(self->time, "behind", !delay && !best_split && timer->split_info[curr] & LS_INFO_BEHIND_TIME);
+    set_class(self->time, "losing", !delay && !best_split && timer->split_info[curr] & LS_INFO_LOSING_TIME);
+    ls_time_millis_string(str, &millis[1], time);
     millis[0] = '.';
-    gtk_label_set_text(GTK_LABEL(self->time_seconds), str);
-    gtk_label_set_text(GTK_LABEL(self->time_millis), millis);
+    set_label_text(self->time_seconds, str);
+    set_label_text(self->time_millis, millis);
 }
 
 LSComponentOps ls_timer_operations = {
@@ -4,23 +4,50 @@
  */
 #include "components.h"
 
-LSComponent* ls_component_title_new(void);
-LSComponent* ls_component_splits_new(void);
-LSComponent* ls_component_timer_new(void);
-LSComponent* ls_component_detailed_timer_new(void);
-LSComponent* ls_component_prev_segment_new(void);
-LSComponent* ls_component_best_sum_new(void);
-LSComponent* ls_component_pb_new(void);
-LSComponent* ls_component_wr_new(void);
+LSComponent* ls_component_title_new(const char* arg);
+LSComponent* ls_component_splits_new(const char* arg);
+LSComponent* ls_component_timer_new(const char* arg);
+LSComponent* ls_component_glyph_clock_new(const char* arg);
+LSComponent* ls_component_detailed_timer_new(const char* arg);
+LSComponent* ls_component_prev_segment_new(const char* arg);
+LSComponent* ls_component_best_sum_new(const char* arg);
+LSComponent* ls_component_pb_new(const char* arg);
+LSComponent* ls_component_wr_new(const char* arg);
+LSComponent* ls_component_graph_new(const char* arg);
+LSComponent* ls_component_best_possible_new(const char* arg);
+LSComponent* ls_component_time_save_new(const char* arg);
+LSComponent* ls_component_pace_new(const char* arg);
 
 LSComponentAvailable ls_components[] = {
     { "title", ls_component_title_new },
     { "splits", ls_component_splits_new },
-    // { "timer", ls_component_timer_new },
+    { "timer", ls_component_timer_new },
+    { "glyph-clock", ls_component_glyph_clock_new },
     { "detailed-timer", ls_component_detailed_timer_new },
     { "prev-segment", ls_component_prev_segment_new },
     { "best-sum", ls_component_best_sum_new },
     { "pb", ls_component_pb_new },
     { "wr", ls_component_wr_new },
+    { "graph", ls_component_graph_new },
+    { "best-possible", ls_component_best_possible_new },
+    { "time-save", ls_component_time_save_new },
+    { "pace", ls_component_pace_new },
     { NULL, NULL }
 };
+
+/**
+ * Finds an available component by name.
+ *
+ * @param name The name of the component, as written in the layout.
+ *
+ * @return The component, or NULL if there's none by that name.
+ */
+const LSComponentAvailable* ls_component_find(const char* name)
+{
+    for (int i = 0; ls_components[i].name != NULL; i++) {
+        if (strcmp(ls_components[i].name, name) == 0) {
+            return &ls_components[i];
+        }
+    }
+    return NULL;
+}
@@ -35,10 +35,12 @@ typedef struct LSComponentOps {
 
 typedef struct LSComponentAvailable {
     char* name;
-    LSComponent* (*new)(void);
+    LSComponent* (*new)(const char* arg); /*!< Creates an instance, arg is what follows "name:" in the layout, or NULL */
 } LSComponentAvailable;
 
 // A NULL-terminated array of all available components
 extern LSComponentAvailable ls_components[];
 
+const LSComponentAvailable* ls_component_find(const char* name);
+
 #endif /* __COMPONENTS_H__ */
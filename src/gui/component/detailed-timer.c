@@ -26,7 +26,7 @@ extern LSComponentOps ls_detailed_timer_operations;
 /**
  * Constructor
  */
-LSComponent* ls_component_detailed_timer_new(void)
+LSComponent* ls_component_detailed_timer_new(const char* arg)
 {
     LSDetailedTimer* self;
     GtkWidget* spacer;
@@ -176,54 +176,39 @@ static void detailed_timer_draw(LSComponent* self_, const ls_game* game, const l
         --curr;
     }
 
-    remove_class(self->time, "delay");
-    remove_class(self->time, "behind");
-    remove_class(self->time, "losing");
-    remove_class(self->time, "best-split");
-
     if (curr == game->split_count) {
         curr = game->split_count - 1;
     }
-    if (ls_timer_get_time(timer, true) <= 0) {
-        add_class(self->time, "delay");
-    } else {
-        if (timer->curr_split == game->split_count
-            && timer->split_info[curr]
-                & LS_INFO_BEST_SPLIT) {
-            add_class(self->time, "best-split");
-        } else {
-            if (timer->split_info[curr]
-                & LS_INFO_BEHIND_TIME) {
-                add_class(self->time, "behind");
-            }
-            if (timer->split_info[curr]
-                & LS_INFO_LOSING_TIME) {
-                add_class(self->time, "losing");
-            }
-        }
-    }
+    // Work out the classes first, so the label is only restyled when they change
+    const bool delay = ls_timer_get_time(timer, true) <= 0;
+    const bool best_split = !delay && timer->curr_split == game->split_count
+        && timer->split_info[curr] & LS_INFO_BEST_SPLIT;
+    set_class(self->time, "delay", delay);
+    set_class(self->time, "best-split", best_split);
+    set_class(self->time, "behind", !delay && !best_split && timer->split_info[curr] & LS_INFO_BEHIND_TIME);
+    set_class(self->time, "losing", !delay && !best_split && timer->split_info[curr] & LS_INFO_LOSING_TIME);
     ls_time_millis_string(str, &millis[1], ls_timer_get_time(timer, true));
     if (millis[1] != '\0')
         millis[0] = '.';
-    gtk_label_set_text(GTK_LABEL(self->time_seconds), str);
-    gtk_label_set_text(GTK_LABEL(self->time_millis), millis);
+    set_label_text(self->time_seconds, str);
+    set_label_text(self->time_millis, millis);
 
     if (timer->curr_split == 0) {
-        gtk_label_set_text(GTK_LABEL(self->segment_seconds), str);
-        gtk_label_set_text(GTK_LABEL(self->segment_millis), millis);
+        set_label_text(self->segment_seconds, str);
+        set_label_text(self->segment_millis, millis);
     } else {
         ls_time_millis_string(seg, &seg_millis[1], timer->segment_times[timer->curr_split]);
         if (seg_millis[1] != '\0')
             seg_millis[0] = '.';
-        gtk_label_set_text(GTK_LABEL(self->segment_seconds), seg);
-        gtk_label_set_text(GTK_LABEL(self->segment_millis), seg_millis);
+        set_label_text(self->segment_seconds, seg);
+        set_label_text(self->segment_millis, seg_millis);
     }
 
-    ls_time_string(&pb[6], game->segment_times[timer->curr_split]);
-    gtk_label_set_text(GTK_LABEL(self->segment_pb), pb);
+    ls_time_string(&pb[6], timer->curr_split < game->split_count ? timer->comparison_segments[timer->curr_split] : 0);
+    set_label_text(self->segment_pb, pb);
 
     ls_time_string(&best[6], game->best_segments[timer->curr_split]);
-    gtk_label_set_text(GTK_LABEL(self->segment_best), best);
+    set_label_text(self->segment_best, best);
 }
 
 LSComponentOps ls_detailed_timer_operations = {
@@ -0,0 +1,540 @@
+/** \file glyph-clock.c
+ *
+ * Implementation of the custom drawn clock/timer component.
+ *
+ * Same look as the clock component, but the characters it can show are
+ * shaped once with Pango and kept as alpha masks, then painted with the
+ * colour of the theme. Every character gets a fixed cell, digits all being
+ * as wide as the widest one, so a frame only redraws the cells whose
+ * digit changed and doesn't format strings or allocate anything.
+ */
+#include "components.h"
+#include "src/settings/definitions.h"
+
+extern AppConfig cfg;
+
+#define GLYPHS "0123456789:.-" /*!< Every character the clock may show */
+#define GLYPH_COUNT (sizeof(GLYPHS) - 1)
+#define MAX_CELLS 32 /*!< Longer than any time the clock may show */
+
+/**
+ * @brief A character, shaped and rendered once.
+ */
+typedef struct LSGlyph {
+    cairo_surface_t* mask; /*!< Alpha mask of the character, NULL for an empty one */
+    int width; /*!< Advance of the character, in pixels */
+    int baseline; /*!< Distance from the top of the mask to the baseline */
+} LSGlyph;
+
+/**
+ * @brief The glyphs of one part of the clock, seconds or milliseconds.
+ */
+typedef struct LSGlyphFont {
+    PangoFontDescription* font; /*!< The font the glyphs were rendered with, NULL if not rendered */
+    LSGlyph glyphs[GLYPH_COUNT];
+    int digit_width; /*!< Width of the cells holding digits */
+    int ascent; /*!< Highest glyph above the baseline */
+    int descent; /*!< Lowest glyph below the baseline */
+    GdkRGBA color; /*!< Colour the glyphs are painted with */
+} LSGlyphFont;
+
+enum {
+    PART_SECONDS,
+    PART_MILLIS,
+    PART_COUNT
+};
+
+/**
+ * Classes the clock sets on itself depending on the run, removed together
+ * when the game is cleared.
+ */
+static const char* const state_classes[] = { "delay", "best-split", "behind", "losing" };
+
+/**
+ * @brief The Glyph Clock component itself.
+ */
+typedef struct LSGlyphClock {
+    LSComponent base; /*!< The base struct that is extended. */
+    GtkWidget* area; /*!< The drawing area, styled like the timer */
+    LSGlyphFont parts[PART_COUNT]; /*!< Glyphs for the seconds and milliseconds */
+    int scale; /*!< Scale factor the glyphs were rendered at */
+    int right_inset; /*!< Space to leave on the right of the digits */
+    int baseline; /*!< Position of the baseline in the area */
+    char text[MAX_CELLS]; /*!< Characters shown, seconds then milliseconds */
+    unsigned char part[MAX_CELLS]; /*!< Part each character belongs to */
+    int x[MAX_CELLS]; /*!< Position of each cell */
+    int cell_count; /*!< Number of characters shown */
+    bool real_time; /*!< Whether to show the real time rather than the timing method of the run */
+} LSGlyphClock;
+extern LSComponentOps ls_glyph_clock_operations;
+
+/**
+ * Returns the glyph of a character.
+ *
+ * @param part The part the character belongs to.
+ * @param c The character, one of GLYPHS.
+ *
+ * @return The glyph.
+ */
+static const LSGlyph* glyph_get(const LSGlyphFont* part, char c)
+{
+    return &part->glyphs[strchr(GLYPHS, c) - GLYPHS];
+}
+
+/**
+ * Returns the width of the cell holding a character.
+ *
+ * @param part The part the character belongs to.
+ * @param c The character.
+ *
+ * @return The width, in pixels.
+ */
+static int cell_width(const LSGlyphFont* part, char c)
+{
+    if (isdigit((unsigned char)c)) {
+        return part->digit_width;
+    }
+    return glyph_get(part, c)->width;
+}
+
+/**
+ * Frees the glyphs of a part.
+ *
+ * @param part The part.
+ */
+static void part_free(LSGlyphFont* part)
+{
+    for (size_t i = 0; i < GLYPH_COUNT; ++i) {
+        if (part->glyphs[i].mask) {
+            cairo_surface_destroy(part->glyphs[i].mask);
+            part->glyphs[i].mask = NULL;
+        }
+    }
+    if (part->font) {
+        pango_font_description_free(part->font);
+        part->font = NULL;
+    }
+}
+
+/**
+ * Shapes and renders a character.
+ *
+ * @param widget The widget the character will be drawn on.
+ * @param font The font to use.
+ * @param scale The scale factor of the widget.
+ * @param c The character.
+ * @param glyph Where to store the result.
+ */
+static void glyph_load(GtkWidget* widget, const PangoFontDescription* font, int scale, char c, LSGlyph* glyph)
+{
+    const char str[2] = { c, '\0' };
+    PangoRectangle logical;
+    PangoLayout* layout = gtk_widget_create_pango_layout(widget, str);
+    pango_layout_set_font_description(layout, font);
+    pango_layout_get_pixel_extents(layout, NULL, &logical);
+    glyph->width = logical.width;
+    glyph->baseline = pango_layout_get_baseline(layout) / PANGO_SCALE - logical.y;
+    glyph->mask = NULL;
+    if (logical.width > 0 && logical.height > 0) {
+        glyph->mask = cairo_image_surface_create(CAIRO_FORMAT_A8,
+            logical.width * scale, logical.height * scale);
+        cairo_surface_set_device_scale(glyph->mask, scale, scale);
+        cairo_t* cr = cairo_create(glyph->mask);
+        cairo_move_to(cr, -logical.x, -logical.y);
+        pango_cairo_show_layout(cr, layout);
+        cairo_destroy(cr);
+    }
+    g_object_unref(layout);
+}
+
+/**
+ * Reads the style of one part of the clock, as if it were the label the
+ * clock component shows it in, so that descendant selectors like
+ * ".timer.behind .timer-seconds" apply to it.
+ *
+ * @param widget The drawing area of the clock.
+ * @param part The part, PART_SECONDS or PART_MILLIS.
+ * @param padding Where to store the padding of the part.
+ * @param color Where to store the colour of the part.
+ *
+ * @return The font of the part, to be freed with pango_font_description_free.
+ */
+static PangoFontDescription* part_style(GtkWidget* widget, int part, GtkBorder* padding, GdkRGBA* color)
+{
+    GtkStyleContext* parent = gtk_widget_get_style_context(widget);
+    GtkWidgetPath* path = gtk_widget_path_copy(gtk_widget_get_path(widget));
+    PangoFontDescription* font;
+    gint pos;
+
+    // The path may predate the state classes set since
+    GList* classes = gtk_style_context_list_classes(parent);
+    for (GList* l = classes; l != NULL; l = l->next) {
+        gtk_widget_path_iter_add_class(path, -1, l->data);
+    }
+    g_list_free(classes);
+
+    // The clock component puts the milliseconds in a box of their own
+    if (part == PART_MILLIS) {
+        pos = gtk_widget_path_append_type(path, GTK_TYPE_BOX);
+        gtk_widget_path_iter_set_object_name(path, pos, "box");
+    }
+    pos = gtk_widget_path_append_type(path, GTK_TYPE_LABEL);
+    gtk_widget_path_iter_set_object_name(path, pos, "label");
+    gtk_widget_path_iter_add_class(path, pos, part == PART_MILLIS ? "timer-millis" : "timer-seconds");
+
+    GtkStyleContext* context = gtk_style_context_new();
+    gtk_style_context_set_path(context, path);
+    gtk_style_context_set_parent(context, parent);
+    gtk_style_context_set_scale(context, gtk_widget_get_scale_factor(widget));
+    gtk_style_context_set_state(context, gtk_style_context_get_state(parent));
+    const GtkStateFlags state = gtk_style_context_get_state(context);
+    gtk_style_context_get(context, state, GTK_STYLE_PROPERTY_FONT, &font, NULL);
+    gtk_style_context_get_padding(context, state, padding);
+    gtk_style_context_get_color(context, state, color);
+    g_object_unref(context);
+    gtk_widget_path_unref(path);
+    return font;
+}
+
+/**
+ * Renders the glyphs again if the theme changed the fonts.
+ *
+ * @param self The glyph clock component.
+ */
+static void glyphs_update(LSGlyphClock* self)
+{
+    GtkStyleContext* context = gtk_widget_get_style_context(self->area);
+    const int scale = gtk_widget_get_scale_factor(self->area);
+    bool changed = false;
+    GtkBorder padding;
+
+    for (int i = 0; i < PART_COUNT; ++i) {
+        LSGlyphFont* part = &self->parts[i];
+        GdkRGBA color;
+        PangoFontDescription* font = part_style(self->area, i, &padding, &color);
+        if (!gdk_rgba_equal(&color, &part->color)) {
+            part->color = color;
+            gtk_widget_queue_draw(self->area);
+        }
+        if (part->font && scale == self->scale && pango_font_description_equal(font, part->font)) {
+            pango_font_description_free(font);
+            continue;
+        }
+        part_free(part);
+        part->font = font;
+        part->digit_width = part->ascent = part->descent = 0;
+        for (size_t g = 0; g < GLYPH_COUNT; ++g) {
+            LSGlyph* glyph = &part->glyphs[g];
+            int height = 0;
+            glyph_load(self->area, font, scale, GLYPHS[g], glyph);
+            if (glyph->mask) {
+                height = cairo_image_surface_get_height(glyph->mask) / scale;
+            }
+            if (isdigit((unsigned char)GLYPHS[g]) && glyph->width > part->digit_width) {
+                part->digit_width = glyph->width;
+            }
+            part->ascent = MAX(part->ascent, glyph->baseline);
+            part->descent = MAX(part->descent, height - glyph->baseline);
+        }
+        changed = true;
+    }
+    // The padding left after the loop is the one of the milliseconds
+    const int millis_padding = padding.right;
+    self->scale = scale;
+
+    gtk_style_context_get_padding(context, gtk_style_context_get_state(context), &padding);
+    const int ascent = MAX(self->parts[PART_SECONDS].ascent, self->parts[PART_MILLIS].ascent);
+    const int descent = MAX(self->parts[PART_SECONDS].descent, self->parts[PART_MILLIS].descent);
+    self->baseline = padding.top + ascent;
+    self->right_inset = padding.right + millis_padding;
+
+    if (changed) {
+        gtk_widget_set_size_request(self->area, -1, padding.top + ascent + descent + padding.bottom);
+        self->cell_count = 0;
+        gtk_widget_queue_draw(self->area);
+    }
+}
+
+/**
+ * Writes a number with at least some digits.
+ *
+ * @param text Where to write the number.
+ * @param number The number, not negative.
+ * @param digits The minimum number of digits.
+ *
+ * @return The number of characters written.
+ */
+static int put_number(char* text, long long number, int digits)
+{
+    char reversed[24];
+    int count = 0;
+    do {
+        reversed[count++] = (char)('0' + number % 10);
+        number /= 10;
+    } while (number || count < digits);
+    for (int i = 0; i < count; ++i) {
+        text[i] = reversed[count - 1 - i];
+    }
+    return count;
+}
+
+/**
+ * Formats a time like ls_time_millis_string, without the C library.
+ *
+ * @param text Where to write the characters, at least MAX_CELLS long.
+ * @param part Where to write the part of each character.
+ * @param time The time, in microseconds.
+ *
+ * @return The number of characters written.
+ */
+static int format_time(char* text, unsigned char* part, long long time)
+{
+    int count = 0;
+    int decimals = cfg.libresplit.decimals.value.i;
+    if (decimals < 0) {
+        decimals = 0;
+    } else if (decimals > 6) {
+        decimals = 6;
+    }
+
+    if (time < 0) {
+        time = -time;
+        text[count++] = '-';
+    }
+    const long long hours = time / (1000000LL * 60 * 60);
+    const long long minutes = (time / (1000000LL * 60)) % 60;
+    const long long seconds = (time / 1000000LL) % 60;
+    if (hours) {
+        count += put_number(&text[count], hours, 1);
+        text[count++] = ':';
+    }
+    if (hours || minutes) {
+        count += put_number(&text[count], minutes, hours ? 2 : 1);
+        text[count++] = ':';
+    }
+    count += put_number(&text[count], seconds, hours || minutes ? 2 : 1);
+    memset(part, PART_SECONDS, count);
+
+    if (decimals) {
+        long long subsecs = time % 1000000LL;
+        for (int i = decimals; i < 6; ++i) {
+            subsecs /= 10;
+        }
+        part[count] = PART_MILLIS;
+        text[count++] = '.';
+        memset(&part[count], PART_MILLIS, decimals);
+        count += put_number(&text[count], subsecs, decimals);
+    }
+    return count;
+}
+
+/**
+ * Places the characters in their cells, aligned to the right.
+ *
+ * @param self The glyph clock component.
+ * @param text The characters.
+ * @param part The part of each character.
+ * @param count The number of characters.
+ * @param x Where to store the position of each cell.
+ */
+static void layout_cells(const LSGlyphClock* self, const char* text, const unsigned char* part, int count, int* x)
+{
+    int right = gtk_widget_get_allocated_width(self->area) - self->right_inset;
+    for (int i = count - 1; i >= 0; --i) {
+        right -= cell_width(&self->parts[part[i]], text[i]);
+        x[i] = right;
+    }
+}
+
+/**
+ * Draw handler of the area: the timer background, then the glyphs.
+ *
+ * @param widget The drawing area.
+ * @param cr The cairo context, clipped to the cells that changed.
+ * @param data The glyph clock component.
+ *
+ * @return FALSE, to let the draw go on.
+ */
+static gboolean glyph_clock_render(GtkWidget* widget, cairo_t* cr, gpointer data)
+{
+    LSGlyphClock* self = data;
+    GtkStyleContext* context = gtk_widget_get_style_context(widget);
+    const int width = gtk_widget_get_allocated_width(widget);
+    const int height = gtk_widget_get_allocated_height(widget);
+    double clip_x1, clip_y1, clip_x2, clip_y2;
+
+    gtk_render_background(context, cr, 0, 0, width, height);
+    gtk_render_frame(context, cr, 0, 0, width, height);
+
+    cairo_clip_extents(cr, &clip_x1, &clip_y1, &clip_x2, &clip_y2);
+    for (int i = 0; i < self->cell_count; ++i) {
+        const LSGlyphFont* part = &self->parts[self->part[i]];
+        const LSGlyph* glyph = glyph_get(part, self->text[i]);
+        // Digits are centered in their cell
+        const int x = self->x[i] + (cell_width(part, self->text[i]) - glyph->width) / 2;
+        if (!glyph->mask || x > clip_x2 || x + glyph->width < clip_x1) {
+            continue;
+        }
+        gdk_cairo_set_source_rgba(cr, &part->color);
+        cairo_mask_surface(cr, glyph->mask, x, self->baseline - glyph->baseline);
+    }
+    return FALSE;
+}
+
+/**
+ * Renders the glyphs again when the theme changes.
+ *
+ * @param widget The drawing area.
+ * @param data The glyph clock component.
+ */
+static void glyph_clock_style_updated(GtkWidget* widget, gpointer data)
+{
+    glyphs_update(data);
+}
+
+/**
+ * Constructor
+ *
+ * @param arg "real" to always show the real time, including loads.
+ */
+LSComponent* ls_component_glyph_clock_new(const char* arg)
+{
+    LSGlyphClock* self;
+
+    self = calloc(1, sizeof(LSGlyphClock));
+    if (!self) {
+        return NULL;
+    }
+    self->base.ops = &ls_glyph_clock_operations;
+    self->real_time = arg && strcmp(arg, "real") == 0;
+
+    self->area = gtk_drawing_area_new();
+    add_class(self->area, "timer");
+    add_class(self->area, "time");
+    add_class(self->area, "glyph-clock");
+    gtk_widget_set_hexpand(self->area, TRUE);
+    g_signal_connect(self->area, "draw", G_CALLBACK(glyph_clock_render), self);
+    g_signal_connect(self->area, "style-updated", G_CALLBACK(glyph_clock_style_updated), self);
+    gtk_widget_show(self->area);
+
+    return (LSComponent*)self;
+}
+
+/**
+ * Destructor.
+ *
+ * @param self_ The glyph clock component itself
+ */
+static void glyph_clock_delete(LSComponent* self_)
+{
+    LSGlyphClock* self = (LSGlyphClock*)self_;
+    g_signal_handlers_disconnect_by_data(self->area, self);
+    for (int i = 0; i < PART_COUNT; ++i) {
+        part_free(&self->parts[i]);
+    }
+    free(self);
+}
+
+/**
+ * Returns the glyph clock GTK widget.
+ *
+ * @param self The glyph clock component itself.
+ * @return The drawing area as a GTK Widget.
+ */
+static GtkWidget* glyph_clock_widget(LSComponent* self)
+{
+    return ((LSGlyphClock*)self)->area;
+}
+
+/**
+ * Redraws every cell, since they moved.
+ *
+ * @param self_ The glyph clock component itself.
+ * @param win_width The new width of the window.
+ * @param win_height The new height of the window.
+ */
+static void glyph_clock_resize(LSComponent* self_, int win_width, int win_height)
+{
+    LSGlyphClock* self = (LSGlyphClock*)self_;
+    self->cell_count = 0;
+    gtk_widget_queue_draw(self->area);
+}
+
+/**
+ * Function to execute when ls_app_window_clear_game is executed.
+ *
+ * @param self_ The glyph clock component itself.
+ */
+static void glyph_clock_clear_game(LSComponent* self_)
+{
+    LSGlyphClock* self = (LSGlyphClock*)self_;
+    self->cell_count = 0;
+    for (size_t i = 0; i < sizeof(state_classes) / sizeof(state_classes[0]); ++i) {
+        remove_class(self->area, state_classes[i]);
+    }
+    gtk_widget_queue_draw(self->area);
+}
+
+/**
+ * Function to execute when ls_app_window_draw is executed.
+ *
+ * @param self_ The glyph clock component itself.
+ * @param game The game struct instance.
+ * @param timer The timer instance.
+ */
+static void glyph_clock_draw(LSComponent* self_, const ls_game* game, const ls_timer* timer)
+{
+    LSGlyphClock* self = (LSGlyphClock*)self_;
+    char text[MAX_CELLS];
+    unsigned char part[MAX_CELLS];
+    int x[MAX_CELLS];
+
+    unsigned int curr = timer->curr_split;
+    if (curr && curr == game->split_count) {
+        --curr;
+    }
+
+    const long long time = self->real_time ? timer->realTime : ls_timer_get_time(timer, true);
+    const bool delay = time <= 0;
+    const bool best_split = !delay && timer->curr_split == game->split_count
+        && timer->split_info[curr] & LS_INFO_BEST_SPLIT;
+    set_class(self->area, "delay", delay);
+    set_class(self->area, "best-split", best_split);
+    set_class(self->area, "behind", !delay && !best_split && timer->split_info[curr] & LS_INFO_BEHIND_TIME);
+    set_class(self->area, "losing", !delay && !best_split && timer->split_info[curr] & LS_INFO_LOSING_TIME);
+
+    if (!self->parts[PART_SECONDS].font) {
+        glyphs_update(self);
+    }
+
+    const int count = format_time(text, part, time);
+    layout_cells(self, text, part, count, x);
+
+    bool moved = count != self->cell_count;
+    for (int i = 0; !moved && i < count; ++i) {
+        moved = x[i] != self->x[i] || part[i] != self->part[i];
+    }
+    if (moved) {
+        gtk_widget_queue_draw(self->area);
+    } else {
+        const int height = gtk_widget_get_allocated_height(self->area);
+        for (int i = 0; i < count; ++i) {
+            if (text[i] != self->text[i]) {
+                gtk_widget_queue_draw_area(self->area, x[i], 0,
+                    cell_width(&self->parts[part[i]], text[i]), height);
+            }
+        }
+    }
+    memcpy(self->text, text, count);
+    memcpy(self->part, part, count);
+    memcpy(self->x, x, count * sizeof(int));
+    self->cell_count = count;
+}
+
+LSComponentOps ls_glyph_clock_operations = {
+    .delete = glyph_clock_delete,
+    .widget = glyph_clock_widget,
+    .resize = glyph_clock_resize,
+    .clear_game = glyph_clock_clear_game,
+    .draw = glyph_clock_draw
+};
@@ -0,0 +1,386 @@
+/** \file graph.c
+ *
+ * Implementation of the run history graph component.
+ *
+ * Plots, from the run history, the final time and reset rate of the
+ * attempts, the splits where runs get reset, and how the times of the
+ * current segment are distributed. The series are downsampled and the
+ * histograms kept up to date by the comparisons worker, so drawing
+ * never walks the history, however long it is, and the graph is only
+ * drawn again when the worker publishes new data or the split changes.
+ */
+#include "components.h"
+#include "src/comparisons.h"
+
+#define GRAPH_HEIGHT 48 /*!< Default height of every graph, themes can ask for more */
+
+enum {
+    GRAPH_ATTEMPTS = 1 << 0,
+    GRAPH_RESETS = 1 << 1,
+    GRAPH_SEGMENTS = 1 << 2,
+    GRAPH_ALL = GRAPH_ATTEMPTS | GRAPH_RESETS | GRAPH_SEGMENTS
+};
+
+/**
+ * @brief The History Graph component itself.
+ */
+typedef struct LSGraph {
+    LSComponent base; /*!< The base struct that is extended */
+    GtkWidget* area; /*!< The drawing area */
+    int graphs; /*!< GRAPH_* flags of the graphs to show */
+    const ls_game* game; /*!< The open game, NULL if none */
+    const ls_timer* timer; /*!< The timer, which points to the graph data */
+    const ls_run_graph* drawn_graph; /*!< Graph data last drawn */
+    unsigned int drawn_split; /*!< Split last drawn */
+} LSGraph;
+extern LSComponentOps ls_graph_operations;
+
+/**
+ * Returns how many graphs are shown.
+ *
+ * @param graphs GRAPH_* flags.
+ *
+ * @return The number of graphs.
+ */
+static int graph_count(int graphs)
+{
+    int count = 0;
+    for (; graphs; graphs >>= 1) {
+        count += graphs & 1;
+    }
+    return count;
+}
+
+/**
+ * Sets the colour of a part of the graph as the source of a cairo context.
+ *
+ * @param context The style context of the graph.
+ * @param cr The cairo context.
+ * @param class The style class of the part.
+ * @param alpha How opaque to draw, relative to the theme.
+ */
+static void graph_set_color(GtkStyleContext* context, cairo_t* cr, const char* class, double alpha)
+{
+    GdkRGBA color;
+    gtk_style_context_save(context);
+    gtk_style_context_add_class(context, class);
+    gtk_style_context_get_color(context, gtk_style_context_get_state(context), &color);
+    gtk_style_context_restore(context);
+    color.alpha *= alpha;
+    gdk_cairo_set_source_rgba(cr, &color);
+}
+
+/**
+ * Returns the split whose segment is shown.
+ *
+ * @param self The graph component.
+ *
+ * @return The index of the split.
+ */
+static unsigned int graph_split(const LSGraph* self)
+{
+    unsigned int split = self->timer->curr_split;
+    if (split && split >= self->game->split_count) {
+        split = self->game->split_count - 1;
+    }
+    return split;
+}
+
+/**
+ * Plots the attempts: the range of final times of the completed runs of
+ * every point, faster on top, over the share of runs that were reset.
+ *
+ * @param context The style context of the graph.
+ * @param cr The cairo context.
+ * @param graph The graph data.
+ * @param area Where to plot.
+ */
+static void graph_attempts(GtkStyleContext* context, cairo_t* cr, const ls_run_graph* graph, const GdkRectangle* area)
+{
+    if (!graph->point_count) {
+        return;
+    }
+    const double step = (double)area->width / graph->point_count;
+    const double range = graph->slowest - graph->fastest;
+
+    graph_set_color(context, cr, "graph-resets", 0.3);
+    for (size_t i = 0; i < graph->point_count; ++i) {
+        const ls_graph_point* point = &graph->points[i];
+        const double height = (double)area->height * (point->runs - point->completed) / point->runs;
+        cairo_rectangle(cr, area->x + i * step, area->y + area->height - height, step, height);
+    }
+    cairo_fill(cr);
+
+    graph_set_color(context, cr, "graph-attempts", 1.);
+    for (size_t i = 0; i < graph->point_count; ++i) {
+        const ls_graph_point* point = &graph->points[i];
+        if (!point->completed) {
+            continue;
+        }
+        double top = area->height / 2.;
+        double bottom = top;
+        if (range > 0) {
+            top = (point->best - graph->fastest) / range * area->height;
+            bottom = (point->worst - graph->fastest) / range * area->height;
+        }
+        cairo_rectangle(cr, area->x + i * step, area->y + top - 1.,
+            step > 2. ? step - 1. : step, bottom - top + 2.);
+    }
+    cairo_fill(cr);
+}
+
+/**
+ * Plots how many runs were reset during every split, the current one highlighted.
+ *
+ * @param self The graph component.
+ * @param context The style context of the graph.
+ * @param cr The cairo context.
+ * @param graph The graph data.
+ * @param area Where to plot.
+ */
+static void graph_resets(const LSGraph* self, GtkStyleContext* context, cairo_t* cr,
+    const ls_run_graph* graph, const GdkRectangle* area)
+{
+    const unsigned int split_count = self->game->split_count;
+    if (!split_count || !graph->max_resets) {
+        return;
+    }
+    const unsigned int current = graph_split(self);
+    const double step = (double)area->width / split_count;
+
+    for (int highlight = 0; highlight < 2; ++highlight) {
+        graph_set_color(context, cr, highlight ? "graph-current" : "graph-resets", 1.);
+        for (unsigned int i = 0; i < split_count; ++i) {
+            if ((i == current) != highlight) {
+                continue;
+            }
+            const double height = (double)area->height * graph->resets[i] / graph->max_resets;
+            cairo_rectangle(cr, area->x + i * step, area->y + area->height - height,
+                step > 2. ? step - 1. : step, height);
+        }
+        cairo_fill(cr);
+    }
+}
+
+/**
+ * Plots the distribution of the times of the current segment, with a
+ * mark at its time in the personal best.
+ *
+ * @param self The graph component.
+ * @param context The style context of the graph.
+ * @param cr The cairo context.
+ * @param graph The graph data.
+ * @param area Where to plot.
+ */
+static void graph_segments(const LSGraph* self, GtkStyleContext* context, cairo_t* cr,
+    const ls_run_graph* graph, const GdkRectangle* area)
+{
+    if (!self->game->split_count) {
+        return;
+    }
+    const unsigned int current = graph_split(self);
+    const ls_graph_histogram* histogram = &graph->segments[current];
+    if (!histogram->peak) {
+        return;
+    }
+    const double step = (double)area->width / LS_GRAPH_BINS;
+
+    graph_set_color(context, cr, "graph-segments", 1.);
+    for (int i = 0; i < LS_GRAPH_BINS; ++i) {
+        const double height = (double)area->height * histogram->bins[i] / histogram->peak;
+        cairo_rectangle(cr, area->x + i * step, area->y + area->height - height, step - 1., height);
+    }
+    cairo_fill(cr);
+
+    const long long pb = self->game->segment_times[current];
+    const long long span = histogram->bin_width * LS_GRAPH_BINS;
+    if (pb >= histogram->low && pb < histogram->low + span) {
+        graph_set_color(context, cr, "graph-current", 1.);
+        const double x = area->x + (double)(pb - histogram->low) / span * area->width;
+        cairo_rectangle(cr, x - 1., area->y, 2., area->height);
+        cairo_fill(cr);
+    }
+}
+
+/**
+ * Draws the graphs, one under the other.
+ *
+ * @param widget The drawing area.
+ * @param cr The cairo context.
+ * @param data The graph component.
+ *
+ * @return FALSE, to let the draw go on.
+ */
+static gboolean graph_render(GtkWidget* widget, cairo_t* cr, gpointer data)
+{
+    LSGraph* self = data;
+    GtkStyleContext* context = gtk_widget_get_style_context(widget);
+    const int width = gtk_widget_get_allocated_width(widget);
+    const int height = gtk_widget_get_allocated_height(widget);
+    GtkBorder padding;
+
+    gtk_render_background(context, cr, 0, 0, width, height);
+    gtk_render_frame(context, cr, 0, 0, width, height);
+
+    // The timer drops the graph data before it's freed
+    const ls_run_graph* graph = self->timer ? self->timer->graph : NULL;
+    if (!graph) {
+        return FALSE;
+    }
+
+    gtk_style_context_get_padding(context, gtk_style_context_get_state(context), &padding);
+    const int count = graph_count(self->graphs);
+    const int inner_height = height - padding.top - padding.bottom;
+    GdkRectangle area = {
+        .x = padding.left,
+        .y = padding.top,
+        .width = width - padding.left - padding.right,
+        .height = (inner_height - (count - 1) * padding.top) / count,
+    };
+    if (area.width <= 0 || area.height <= 0) {
+        return FALSE;
+    }
+
+    if (self->graphs & GRAPH_ATTEMPTS) {
+        graph_attempts(context, cr, graph, &area);
+        area.y += area.height + padding.top;
+    }
+    if (self->graphs & GRAPH_RESETS) {
+        graph_resets(self, context, cr, graph, &area);
+        area.y += area.height + padding.top;
+    }
+    if (self->graphs & GRAPH_SEGMENTS) {
+        graph_segments(self, context, cr, graph, &area);
+    }
+    return FALSE;
+}
+
+/**
+ * Constructor
+ *
+ * @param arg "attempts", "resets" or "segments" to show only that graph, NULL to show them all.
+ */
+LSComponent* ls_component_graph_new(const char* arg)
+{
+    LSGraph* self;
+
+    self = calloc(1, sizeof(LSGraph));
+    if (!self) {
+        return NULL;
+    }
+    self->base.ops = &ls_graph_operations;
+    self->graphs = GRAPH_ALL;
+    if (arg && strcmp(arg, "attempts") == 0) {
+        self->graphs = GRAPH_ATTEMPTS;
+    } else if (arg && strcmp(arg, "resets") == 0) {
+        self->graphs = GRAPH_RESETS;
+    } else if (arg && strcmp(arg, "segments") == 0) {
+        self->graphs = GRAPH_SEGMENTS;
+    }
+
+    const int count = graph_count(self->graphs);
+    self->area = gtk_drawing_area_new();
+    add_class(self->area, "graph");
+    gtk_widget_set_hexpand(self->area, TRUE);
+    gtk_widget_set_size_request(self->area, -1, count * GRAPH_HEIGHT);
+    g_signal_connect(self->area, "draw", G_CALLBACK(graph_render), self);
+    gtk_widget_show(self->area);
+
+    return (LSComponent*)self;
+}
+
+/**
+ * Destructor
+ *
+ * @param self_ The graph component itself.
+ */
+static void graph_delete(LSComponent* self_)
+{
+    LSGraph* self = (LSGraph*)self_;
+    g_signal_handlers_disconnect_by_data(self->area, self);
+    free(self);
+}
+
+/**
+ * Returns the graph GTK widget.
+ *
+ * @param self The graph component itself.
+ * @return The drawing area as a GTK Widget.
+ */
+static GtkWidget* graph_widget(LSComponent* self)
+{
+    return ((LSGraph*)self)->area;
+}
+
+/**
+ * Function to execute when ls_app_window_show_game is executed.
+ *
+ * @param self_ The graph component itself.
+ * @param game The game struct instance.
+ * @param timer The timer instance.
+ */
+static void graph_show_game(LSComponent* self_, const ls_game* game, const ls_timer* timer)
+{
+    LSGraph* self = (LSGraph*)self_;
+    self->game = game;
+    self->timer = timer;
+    self->drawn_graph = timer->graph;
+    self->drawn_split = graph_split(self);
+    gtk_widget_queue_draw(self->area);
+}
+
+/**
+ * Function to execute when ls_app_window_clear_game is executed.
+ *
+ * @param self_ The graph component itself.
+ */
+static void graph_clear_game(LSComponent* self_)
+{
+    LSGraph* self = (LSGraph*)self_;
+    self->game = NULL;
+    self->timer = NULL;
+    self->drawn_graph = NULL;
+    gtk_widget_queue_draw(self->area);
+}
+
+/**
+ * Function to execute when ls_app_window_draw is executed.
+ * Nothing gets drawn unless the graph data or the split changed.
+ *
+ * @param self_ The graph component itself.
+ * @param game The game struct instance.
+ * @param timer The timer instance.
+ */
+static void graph_draw(LSComponent* self_, const ls_game* game, const ls_timer* timer)
+{
+    LSGraph* self = (LSGraph*)self_;
+    self->game = game;
+    self->timer = timer;
+    const unsigned int split = graph_split(self);
+    if (timer->graph != self->drawn_graph || split != self->drawn_split) {
+        self->drawn_graph = timer->graph;
+        self->drawn_split = split;
+        gtk_widget_queue_draw(self->area);
+    }
+}
+
+/**
+ * Redraws the graphs, which are as wide as the window.
+ *
+ * @param self_ The graph component itself.
+ * @param win_width The new width of the window.
+ * @param win_height The new height of the window.
+ */
+static void graph_resize(LSComponent* self_, int win_width, int win_height)
+{
+    gtk_widget_queue_draw(((LSGraph*)self_)->area);
+}
+
+LSComponentOps ls_graph_operations = {
+    .delete = graph_delete,
+    .widget = graph_widget,
+    .resize = graph_resize,
+    .show_game = graph_show_game,
+    .clear_game = graph_clear_game,
+    .draw = graph_draw
+};
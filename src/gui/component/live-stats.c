@@ -0,0 +1,181 @@
+/** \file live-stats.c
+ *
+ * Implementation of the "Best possible time", "Possible time save"
+ * and "Current pace" components.
+ *
+ * The timer keeps these up to date as the run goes, so the components
+ * only format the time when it changes.
+ */
+#include "components.h"
+
+/**
+ * @brief A statistic of the run, shown by one of these components.
+ */
+typedef struct LSLiveStat {
+    const char* label; /*!< Text shown next to the time */
+    const char* class; /*!< Style class of the time, also used for the container and the label */
+    size_t offset; /*!< Offset of the time in ls_timer */
+} LSLiveStat;
+
+static const LSLiveStat best_possible_time = {
+    "Best possible time", "best-possible-time", offsetof(ls_timer, best_possible_time)
+};
+static const LSLiveStat possible_time_save = {
+    "Possible time save", "possible-time-save", offsetof(ls_timer, possible_time_save)
+};
+static const LSLiveStat total_time_save = {
+    "Total possible time save", "possible-time-save", offsetof(ls_timer, total_time_save)
+};
+static const LSLiveStat current_pace = {
+    "Current pace", "current-pace", offsetof(ls_timer, current_pace)
+};
+
+/**
+ * @brief The component representing a statistic of the run.
+ */
+typedef struct LSLiveStats {
+    LSComponent base; /*!< The base struct that is extended */
+    const LSLiveStat* stat; /*!< The statistic shown */
+    GtkWidget* container; /*!< The container for the statistic */
+    GtkWidget* time; /*!< The label showing the time */
+    long long shown; /*!< The time shown, -1 if none */
+} LSLiveStats;
+extern LSComponentOps ls_live_stats_operations;
+
+/**
+ * Creates a component showing a statistic.
+ *
+ * @param stat The statistic.
+ */
+static LSComponent* live_stats_new(const LSLiveStat* stat)
+{
+    LSLiveStats* self;
+    GtkWidget* label;
+    char class[64];
+
+    self = malloc(sizeof(LSLiveStats));
+    if (!self) {
+        return NULL;
+    }
+    self->base.ops = &ls_live_stats_operations;
+    self->stat = stat;
+    self->shown = -1;
+
+    self->container = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
+    add_class(self->container, "footer"); /* hack */
+    snprintf(class, sizeof(class), "%s-container", stat->class);
+    add_class(self->container, class);
+    gtk_widget_show(self->container);
+
+    label = gtk_label_new(stat->label);
+    snprintf(class, sizeof(class), "%s-label", stat->class);
+    add_class(label, class);
+    gtk_widget_set_halign(label, GTK_ALIGN_START);
+    gtk_widget_set_hexpand(label, TRUE);
+    gtk_container_add(GTK_CONTAINER(self->container), label);
+    gtk_widget_show(label);
+
+    self->time = gtk_label_new(NULL);
+    add_class(self->time, stat->class);
+    gtk_widget_set_halign(self->time, GTK_ALIGN_END);
+    gtk_container_add(GTK_CONTAINER(self->container), self->time);
+    gtk_widget_show(self->time);
+
+    return (LSComponent*)self;
+}
+
+/**
+ * Constructor of the best possible time component.
+ */
+LSComponent* ls_component_best_possible_new(const char* arg)
+{
+    return live_stats_new(&best_possible_time);
+}
+
+/**
+ * Constructor of the possible time save component.
+ *
+ * @param arg "total" to show the time that can be saved on the rest of
+ *            the run, rather than on the current segment.
+ */
+LSComponent* ls_component_time_save_new(const char* arg)
+{
+    if (arg && strcmp(arg, "total") == 0) {
+        return live_stats_new(&total_time_save);
+    }
+    return live_stats_new(&possible_time_save);
+}
+
+/**
+ * Constructor of the current pace component.
+ */
+LSComponent* ls_component_pace_new(const char* arg)
+{
+    return live_stats_new(&current_pace);
+}
+
+/**
+ * Destructor
+ *
+ * @param self The component to destroy
+ */
+static void live_stats_delete(LSComponent* self)
+{
+    free(self);
+}
+
+/**
+ * Returns the live stats GTK widget.
+ *
+ * @param self The live stats component itself.
+ * @return The container as a GTK Widget.
+ */
+static GtkWidget* live_stats_widget(LSComponent* self)
+{
+    return ((LSLiveStats*)self)->container;
+}
+
+/**
+ * Function to execute when ls_app_window_clear_game is executed.
+ *
+ * @param self_ The live stats component itself.
+ */
+static void live_stats_clear_game(LSComponent* self_)
+{
+    LSLiveStats* self = (LSLiveStats*)self_;
+    self->shown = -1;
+    gtk_label_set_text(GTK_LABEL(self->time), "");
+}
+
+/**
+ * Function to execute when ls_app_window_draw is executed.
+ *
+ * @param self_ The live stats component itself.
+ * @param game The game struct instance.
+ * @param timer The timer instance.
+ */
+static void live_stats_draw(LSComponent* self_, const ls_game* game,
+    const ls_timer* timer)
+{
+    LSLiveStats* self = (LSLiveStats*)self_;
+    char str[256];
+    const long long time = *(const long long*)((const char*)timer + self->stat->offset);
+    if (time == self->shown) {
+        return;
+    }
+    self->shown = time;
+    set_class(self->time, "time", time);
+    if (time) {
+        ls_time_string(str, time);
+        set_label_text(self->time, str);
+    } else {
+        set_label_text(self->time, "-");
+    }
+}
+
+LSComponentOps ls_live_stats_operations = {
+    .delete = live_stats_delete,
+    .widget = live_stats_widget,
+    .clear_game = live_stats_clear_game,
+    .draw = live_stats_draw
+};
@@ -19,7 +19,7 @@ extern LSComponentOps ls_pb_operations;
 /**
  * Constructor
  */
-LSComponent* ls_component_pb_new(void)
+LSComponent* ls_component_pb_new(const char* arg)
 {
     LSPb* self;
     GtkWidget* label;
@@ -114,23 +114,23 @@ static void pb_draw(LSComponent* self_, const ls_game* game,
 {
     LSPb* self = (LSPb*)self_;
     char str[256];
-    remove_class(self->personal_best, "time");
-    gtk_label_set_text(GTK_LABEL(self->personal_best), "-");
+    long long time = 0;
     if (game->split_count
         && timer->curr_split == game->split_count
         && timer->split_times[game->split_count - 1]
         && (!game->split_times[game->split_count - 1]
             || (timer->split_times[game->split_count - 1]
                 < game->split_times[game->split_count - 1]))) {
-        add_class(self->personal_best, "time");
-        ls_time_string(
-            str, timer->split_times[game->split_count - 1]);
-        gtk_label_set_text(GTK_LABEL(self->personal_best), str);
-    } else if (game->split_count && game->split_times[game->split_count - 1]) {
-        add_class(self->personal_best, "time");
-        ls_time_string(
-            str, game->split_times[game->split_count - 1]);
-        gtk_label_set_text(GTK_LABEL(self->personal_best), str);
+        time = timer->split_times[game->split_count - 1];
+    } else if (game->split_count) {
+        time = game->split_times[game->split_count - 1];
+    }
+    set_class(self->personal_best, "time", time);
+    if (time) {
+        ls_time_string(str, time);
+        set_label_text(self->personal_best, str);
+    } else {
+        set_label_text(self->personal_best, "-");
     }
 }
 
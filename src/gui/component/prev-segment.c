@@ -21,7 +21,7 @@ extern LSComponentOps ls_prev_segment_operations;
 /**
  * Constructor
  */
-LSComponent* ls_component_prev_segment_new(void)
+LSComponent* ls_component_prev_segment_new(const char* arg)
 {
     LSPrevSegment* self;
 
@@ -122,22 +122,14 @@ static void prev_segment_draw(LSComponent* self_, const ls_game* game,
         --curr;
     }
 
-    remove_class(self->previous_segment, "best-segment");
-    remove_class(self->previous_segment, "behind");
-    remove_class(self->previous_segment, "losing");
-    remove_class(self->previous_segment, "delta");
-    gtk_label_set_text(GTK_LABEL(self->previous_segment), "-");
-
+    bool best_segment = false, behind = false;
+    long long delta = 0;
     label = PREVIOUS_SEGMENT;
     if (timer->segment_deltas && timer->segment_deltas[curr] > 0) {
         // Live segment
         label = LIVE_SEGMENT;
-        remove_class(self->previous_segment, "best-segment");
-        add_class(self->previous_segment, "behind");
-        add_class(self->previous_segment, "losing");
-        add_class(self->previous_segment, "delta");
-        ls_delta_string(str, timer->segment_deltas[curr]);
-        gtk_label_set_text(GTK_LABEL(self->previous_segment), str);
+        behind = true;
+        delta = timer->segment_deltas[curr];
     } else if (curr) {
         // Previous segment
         if (timer->curr_split) {
@@ -145,18 +137,25 @@ static void prev_segment_draw(LSComponent* self_, const ls_game* game,
             if (timer->segment_deltas && timer->segment_deltas[prev]) {
                 if (timer->split_info[prev]
                     & LS_INFO_BEST_SEGMENT) {
-                    add_class(self->previous_segment, "best-segment");
+                    best_segment = true;
                 } else if (timer->segment_deltas[prev] > 0) {
-                    add_class(self->previous_segment, "behind");
-                    add_class(self->previous_segment, "losing");
+                    behind = true;
                 }
-                add_class(self->previous_segment, "delta");
-                ls_delta_string(str, timer->segment_deltas[prev]);
-                gtk_label_set_text(GTK_LABEL(self->previous_segment), str);
+                delta = timer->segment_deltas[prev];
             }
         }
     }
-    gtk_label_set_text(GTK_LABEL(self->previous_segment_label), label);
+    set_class(self->previous_segment, "best-segment", best_segment);
+    set_class(self->previous_segment, "behind", behind);
+    set_class(self->previous_segment, "losing", behind);
+    set_class(self->previous_segment, "delta", delta);
+    if (delta) {
+        ls_delta_string(str, delta);
+        set_label_text(self->previous_segment, str);
+    } else {
+        set_label_text(self->previous_segment, "-");
+    }
+    set_label_text(self->previous_segment_label, label);
 }
 
 LSComponentOps ls_prev_segment_operations = {
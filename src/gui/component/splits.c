@@ -1,11 +1,32 @@
 /** \file splits.c
  *
  * Implementation of the splits component.
+ *
+ * Only the rows that fit in the component exist, they are recycled to show
+ * other splits as the list scrolls. Loading and drawing a split file take
+ * the same time whether it has ten splits or two thousand.
  */
 #include "components.h"
+#include "src/comparisons.h"
+#include "src/gui/app_window.h"
+#include "src/gui/icon_cache.h"
 #include <gtk/gtk.h>
 #include <limits.h>
 
+/**
+ * @brief A row of the splits list, showing any one split.
+ */
+typedef struct LSSplitRow {
+    GtkWidget* row; /*!< The row container */
+    GtkWidget* icon; /*!< The split icon, NULL if the splits have no icons */
+    GtkWidget* title; /*!< The split title */
+    GtkWidget* delta; /*!< The split delta */
+    GtkWidget* time; /*!< The split time */
+    int split; /*!< Index of the split shown, -1 if none */
+    bool dirty; /*!< Whether the row must be redrawn regardless of the timer generations */
+    unsigned long split_generation; /*!< Split generation the row was last drawn at */
+} LSSplitRow;
+
 /**
  * @brief The component containing all the splits for the game.
  */
@@ -18,47 +39,242 @@ typedef struct LSSplits {
     GtkAdjustment* split_adjust;
     GtkWidget* split_scroller;
     GtkWidget* split_viewport;
-    GtkWidget** split_rows;
-    GtkWidget** split_titles;
-    GtkWidget** split_icons;
-    GtkWidget** split_deltas;
-    GtkWidget** split_times;
-    GtkCssProvider* icons_css_provider;
+    LSSplitRow* rows; /*!< The recycled rows */
+    unsigned int row_count; /*!< Number of recycled rows created so far */
+    LSSplitRow last_row; /*!< The row pinning the last split when it's scrolled out */
+    bool has_icons; /*!< Whether the rows have an icon */
+    char** title_classes; /*!< The class naming each split, NULL if the split has no title */
+    const ls_game* game; /*!< The game whose splits are shown */
+    unsigned long icon_generation; /*!< Icon cache generation the icons were last looked up at */
+    unsigned int offset; /*!< Index of the first split shown */
+    int scroller_height; /*!< Height available for the rows */
+    unsigned long generation; /*!< Timer generation the rows were last drawn at */
+    ls_comparison_type comparison; /*!< Comparison the rows show, LS_COMPARISON_COUNT for the one of the window */
 } LSSplits;
 extern LSComponentOps ls_splits_operations;
 
+/**
+ * Draws the icon of a row, scaled to fit and centered.
+ *
+ * @param widget The icon widget.
+ * @param cr The cairo context to draw with.
+ * @param data Unused.
+ *
+ * @return Always FALSE, so the theme can draw too.
+ */
+static gboolean icon_draw(GtkWidget* widget, cairo_t* cr, gpointer data)
+{
+    GdkPixbuf* pixbuf = g_object_get_data(G_OBJECT(widget), "pixbuf");
+    if (!pixbuf) {
+        return FALSE;
+    }
+    const int width = gtk_widget_get_allocated_width(widget);
+    const int height = gtk_widget_get_allocated_height(widget);
+    const int icon_width = gdk_pixbuf_get_width(pixbuf);
+    const int icon_height = gdk_pixbuf_get_height(pixbuf);
+    double scale = (double)width / icon_width;
+    if ((double)height / icon_height < scale) {
+        scale = (double)height / icon_height;
+    }
+    cairo_save(cr);
+    cairo_translate(cr, (width - icon_width * scale) / 2, (height - icon_height * scale) / 2);
+    cairo_scale(cr, scale, scale);
+    gdk_cairo_set_source_pixbuf(cr, pixbuf, 0, 0);
+    cairo_paint(cr);
+    cairo_restore(cr);
+    return FALSE;
+}
+
+/**
+ * Looks up the icon of the split a row is showing.
+ *
+ * @param self The splits component.
+ * @param row The row.
+ */
+static void row_set_icon(LSSplits* self, LSSplitRow* row)
+{
+    if (!row->icon) {
+        return;
+    }
+    const char* path = self->game->split_icon_paths[row->split];
+    GdkPixbuf* pixbuf = path ? ls_icon_cache_get(path) : NULL;
+    if (pixbuf != g_object_get_data(G_OBJECT(row->icon), "pixbuf")) {
+        // The widget keeps the reference
+        g_object_set_data_full(G_OBJECT(row->icon), "pixbuf", pixbuf, pixbuf ? g_object_unref : NULL);
+        gtk_widget_queue_draw(row->icon);
+    } else if (pixbuf) {
+        g_object_unref(pixbuf);
+    }
+}
+
+/**
+ * Creates the widgets of a row, adding it to a container.
+ *
+ * @param self The splits component.
+ * @param row The row to create.
+ * @param parent The container to add the row to.
+ */
+static void row_init(LSSplits* self, LSSplitRow* row, GtkWidget* parent)
+{
+    row->row = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
+    add_class(row->row, "split");
+    gtk_widget_set_hexpand(row->row, TRUE);
+    gtk_container_add(GTK_CONTAINER(parent), row->row);
+
+    row->icon = NULL;
+    if (self->has_icons) {
+        row->icon = gtk_drawing_area_new();
+        add_class(row->icon, "split-icon");
+        // set size but allow to dinamically change it from css with min-width and min-height
+        gtk_widget_set_size_request(row->icon, 20, 20);
+        gtk_widget_set_margin_end(row->icon, 4);
+        g_signal_connect(row->icon, "draw", G_CALLBACK(icon_draw), NULL);
+        gtk_container_add(GTK_CONTAINER(row->row), row->icon);
+    }
+
+    row->title = gtk_label_new(NULL);
+    add_class(row->title, "split-title");
+    gtk_widget_set_halign(row->title, GTK_ALIGN_START);
+    gtk_widget_set_hexpand(row->title, TRUE);
+    gtk_container_add(GTK_CONTAINER(row->row), row->title);
+
+    row->delta = gtk_label_new(NULL);
+    add_class(row->delta, "split-delta");
+    gtk_widget_set_size_request(row->delta, 1, -1);
+    gtk_container_add(GTK_CONTAINER(row->row), row->delta);
+
+    row->time = gtk_label_new(NULL);
+    add_class(row->time, "split-time");
+    gtk_widget_set_halign(row->time, GTK_ALIGN_END);
+    gtk_container_add(GTK_CONTAINER(row->row), row->time);
+
+    row->split = -1;
+    row->dirty = true;
+    gtk_widget_show_all(row->row);
+}
+
+/**
+ * Makes a row show a given split.
+ *
+ * @param self The splits component.
+ * @param row The row.
+ * @param game The game struct instance.
+ * @param split The index of the split to show.
+ */
+static void row_bind(LSSplits* self, LSSplitRow* row, const ls_game* game, unsigned int split)
+{
+    if (row->split == (int)split) {
+        return;
+    }
+    if (row->split >= 0 && self->title_classes[row->split]) {
+        remove_class(row->row, self->title_classes[row->split]);
+    }
+    if (self->title_classes[split]) {
+        // Themes can address the row through this class
+        add_class(row->row, self->title_classes[split]);
+    }
+    set_label_text(row->title, game->split_titles[split] ? game->split_titles[split] : "");
+    row->split = split;
+    row->dirty = true;
+    row_set_icon(self, row);
+}
+
+/**
+ * Destroys the widgets of a row.
+ *
+ * @param row The row.
+ */
+static void row_destroy(LSSplitRow* row)
+{
+    if (row->row) {
+        gtk_widget_destroy(row->row);
+        row->row = NULL;
+    }
+}
+
 void free_all(LSSplits* self_)
 {
     LSSplits* self = (LSSplits*)self_;
-    if (self->split_rows) {
-        free(self->split_rows);
+    for (unsigned int i = 0; i < self->row_count; ++i) {
+        row_destroy(&self->rows[i]);
     }
-    if (self->split_titles) {
-        free(self->split_titles);
+    if (self->rows) {
+        free(self->rows);
+        self->rows = NULL;
     }
-    if (self->split_icons) {
-        free(self->split_icons);
+    self->row_count = 0;
+    row_destroy(&self->last_row);
+    if (self->title_classes) {
+        for (unsigned int i = 0; i < self->split_count; ++i) {
+            free(self->title_classes[i]);
+        }
+        free(self->title_classes);
+        self->title_classes = NULL;
     }
-    if (self->split_deltas) {
-        free(self->split_deltas);
+}
+
+/**
+ * Scrolls the splits with the mouse wheel, a row at a time.
+ *
+ * @param widget The scroller.
+ * @param event The scroll event.
+ * @param data The splits component.
+ *
+ * @return Always TRUE, the scroller itself never scrolls.
+ */
+static gboolean splits_scroll(GtkWidget* widget, GdkEventScroll* event, gpointer data)
+{
+    LSSplits* self = data;
+    double delta_x, delta_y = 0;
+    if (event->direction == GDK_SCROLL_UP) {
+        delta_y = -1;
+    } else if (event->direction == GDK_SCROLL_DOWN) {
+        delta_y = 1;
+    } else if (event->direction == GDK_SCROLL_SMOOTH) {
+        gdk_event_get_scroll_deltas((GdkEvent*)event, &delta_x, &delta_y);
     }
-    if (self->split_times) {
-        free(self->split_times);
+    if (delta_y < 0 && self->offset) {
+        self->offset--;
+    } else if (delta_y > 0) {
+        // Clamped on the next draw
+        self->offset++;
+    }
+    ls_app_window_request_draw(widget);
+    return TRUE;
+}
+
+/**
+ * Keeps track of the height available for the rows.
+ *
+ * @param widget The scroller.
+ * @param allocation The new size of the scroller.
+ * @param data The splits component.
+ */
+static void splits_size_allocate(GtkWidget* widget, GdkRectangle* allocation, gpointer data)
+{
+    LSSplits* self = data;
+    if (self->scroller_height != allocation->height) {
+        self->scroller_height = allocation->height;
+        ls_app_window_request_draw(widget);
     }
 }
 
 /**
  * Constructor
+ *
+ * @param arg A comparison, like "average", to show it rather than the one
+ *            picked in the window.
  */
-LSComponent* ls_component_splits_new(void)
+LSComponent* ls_component_splits_new(const char* arg)
 {
     LSSplits* self;
 
-    self = malloc(sizeof(LSSplits));
+    self = calloc(1, sizeof(LSSplits));
     if (!self) {
         return NULL;
     }
     self->base.ops = &ls_splits_operations;
+    self->comparison = arg ? ls_comparison_find(arg) : LS_COMPARISON_COUNT;
 
     self->split_adjust = gtk_adjustment_new(0., 0., 0., 0., 0., 0.);
 
@@ -69,6 +285,8 @@ LSComponent* ls_component_splits_new(void)
     gtk_widget_add_events(self->split_scroller, GDK_SCROLL_MASK);
     gtk_widget_hide(gtk_scrolled_window_get_vscrollbar(GTK_SCROLLED_WINDOW(self->split_scroller)));
     gtk_widget_hide(gtk_scrolled_window_get_hscrollbar(GTK_SCROLLED_WINDOW(self->split_scroller)));
+    g_signal_connect(self->split_scroller, "scroll-event", G_CALLBACK(splits_scroll), self);
+    g_signal_connect(self->split_scroller, "size-allocate", G_CALLBACK(splits_size_allocate), self);
 
     self->split_viewport = gtk_viewport_new(NULL, NULL);
     gtk_container_add(GTK_CONTAINER(self->split_scroller),
@@ -81,12 +299,9 @@ LSComponent* ls_component_splits_new(void)
     gtk_container_add(GTK_CONTAINER(self->split_viewport), self->splits);
     gtk_widget_show(self->splits);
 
-    self->icons_css_provider = NULL;
-
     self->split_last = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
     add_class(self->split_last, "split-last");
     gtk_widget_set_hexpand(self->split_last, TRUE);
-    gtk_widget_show(self->split_last);
 
     self->container = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
     gtk_container_add(GTK_CONTAINER(self->container), self->split_scroller);
@@ -98,10 +313,13 @@ LSComponent* ls_component_splits_new(void)
 /**
  * Destructor
  *
- * @param self The component to destroy
+ * @param self_ The component to destroy
  */
-static void splits_delete(LSComponent* self)
+static void splits_delete(LSComponent* self_)
 {
+    LSSplits* self = (LSSplits*)self_;
+    g_signal_handlers_disconnect_by_data(self->split_scroller, self);
+    free_all(self);
     free(self);
 }
 
@@ -116,40 +334,26 @@ static GtkWidget* splits_widget(LSComponent* self)
     return ((LSSplits*)self)->container;
 }
 
-static void splits_trailer(LSComponent* self_)
+/**
+ * Returns how many rows fit in the splits list.
+ *
+ * @param self The splits component.
+ * @return The number of rows, at least one.
+ */
+static unsigned int visible_rows(LSSplits* self)
 {
-    LSSplits* self = (LSSplits*)self_;
-    int height, split_h, last = self->split_count - 1;
-    double curr_scroll = gtk_adjustment_get_value(self->split_adjust);
-    double scroll_max = gtk_adjustment_get_upper(self->split_adjust);
-    double page_size = gtk_adjustment_get_page_size(self->split_adjust);
-    g_object_ref(self->split_rows[last]);
-    split_h = gtk_widget_get_allocated_height(self->split_titles[last]);
-    height = gtk_widget_get_allocated_height(self->splits);
-    if (gtk_widget_get_parent(self->split_rows[last]) == self->splits) {
-        if (curr_scroll + page_size < scroll_max) {
-            // move last split to split_last
-            gtk_container_remove(GTK_CONTAINER(self->splits),
-                self->split_rows[last]);
-            gtk_container_add(GTK_CONTAINER(self->split_last),
-                self->split_rows[last]);
-            gtk_widget_show(self->split_last);
-        }
-    } else {
-        if (curr_scroll + page_size == scroll_max) {
-            // move last split to split box
-            gtk_container_remove(GTK_CONTAINER(self->split_last),
-                self->split_rows[last]);
-            gtk_container_add(GTK_CONTAINER(self->splits),
-                self->split_rows[last]);
-            gtk_adjustment_set_upper(self->split_adjust,
-                scroll_max + height);
-            gtk_adjustment_set_value(self->split_adjust,
-                curr_scroll + split_h);
-            gtk_widget_hide(self->split_last);
+    int row_height = 0;
+    if (self->row_count) {
+        row_height = gtk_widget_get_allocated_height(self->rows[0].row);
+        if (row_height <= 1) {
+            // Not allocated yet
+            gtk_widget_get_preferred_height(self->rows[0].row, &row_height, NULL);
         }
     }
-    g_object_unref(self->split_rows[last]);
+    if (row_height <= 0 || self->scroller_height < row_height) {
+        return 1;
+    }
+    return self->scroller_height / row_height;
 }
 
 /**
@@ -165,54 +369,24 @@ static void splits_show_game(LSComponent* self_, const ls_game* game,
     LSSplits* self = (LSSplits*)self_;
     char str[256];
     self->split_count = game->split_count;
-
-    self->split_rows = calloc(self->split_count, sizeof(GtkWidget*));
-    if (!self->split_rows)
-        return;
-
-    self->split_titles = calloc(self->split_count, sizeof(GtkWidget*));
-    if (!self->split_titles) {
-        free_all(self);
-        return;
-    }
-
-    self->split_icons = calloc(self->split_count, sizeof(GtkWidget*));
-    if (!self->split_icons) {
-        free_all(self);
-        return;
-    }
-
-    self->split_deltas = calloc(self->split_count, sizeof(GtkWidget*));
-    if (!self->split_deltas) {
-        free_all(self);
+    self->game = game;
+    self->has_icons = game->contains_icons;
+    self->icon_generation = ls_icon_cache_generation();
+    self->offset = 0;
+
+    self->title_classes = calloc(self->split_count, sizeof(char*));
+    if (!self->title_classes) {
+        self->split_count = 0;
         return;
     }
 
-    self->split_times = calloc(self->split_count, sizeof(GtkWidget*));
-    if (!self->split_times) {
-        free_all(self);
-        return;
-    }
-
-    GString* icons_css_src = g_string_new(".split-icon { background-repeat: no-repeat; background-position: center; min-width: 20px; min-height: 20px; background-size: 20px; margin-right: 4px; }");
-
     for (unsigned int i = 0; i < self->split_count; ++i) {
-        self->split_rows[i] = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
-        add_class(self->split_rows[i], "split");
-        gtk_widget_set_hexpand(self->split_rows[i], TRUE);
-        gtk_container_add(GTK_CONTAINER(self->splits),
-            self->split_rows[i]);
-
-        self->split_titles[i] = gtk_label_new(game->split_titles[i]);
-        add_class(self->split_titles[i], "split-title");
-        gtk_widget_set_halign(self->split_titles[i], GTK_ALIGN_START);
-        gtk_widget_set_hexpand(self->split_titles[i], TRUE);
-
         if (game->split_titles[i]
             && strlen(game->split_titles[i])) {
             char* c = &str[12];
             strcpy(str, "split-title-");
-            strcpy(c, game->split_titles[i]);
+            strncpy(c, game->split_titles[i], sizeof(str) - 13);
+            str[sizeof(str) - 1] = '\0';
             do {
                 if (!isalnum(*c)) {
                     *c = '-';
@@ -220,75 +394,25 @@ static void splits_show_game(LSComponent* self_, const ls_game* game,
                     *c = tolower(*c);
                 }
             } while (*++c != '\0');
-            {
-                add_class(self->split_rows[i], str);
-            }
-        }
-
-        if (game->contains_icons) {
-            if (game->split_icon_paths[i]) {
-                // g_string_append_printf(icons_css_src, ".split:nth-child(%d) .split-icon { background-image: url('%s'); }", i+1, game->split_icon_paths[i]);
-                g_string_append_printf(
-                    icons_css_src,
-                    ".%s .split-icon { background-image: url('%s'); }",
-                    str, game->split_icon_paths[i]);
-            }
-            self->split_icons[i] = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
-            add_class(self->split_icons[i], "split-icon");
-            // set size but allow to dinamically change it from css with min-width and min-height
-            gtk_widget_set_size_request(self->split_icons[i], 20, 20);
-            gtk_container_add(GTK_CONTAINER(self->split_rows[i]), self->split_icons[i]);
-            gtk_widget_show(self->split_icons[i]);
-        }
-        gtk_container_add(GTK_CONTAINER(self->split_rows[i]), self->split_titles[i]);
-
-        self->split_deltas[i] = gtk_label_new(NULL);
-        add_class(self->split_deltas[i], "split-delta");
-        gtk_widget_set_size_request(self->split_deltas[i], 1, -1);
-        gtk_container_add(GTK_CONTAINER(self->split_rows[i]),
-            self->split_deltas[i]);
-
-        self->split_times[i] = gtk_label_new(NULL);
-        add_class(self->split_times[i], "split-time");
-        gtk_widget_set_halign(self->split_times[i], GTK_ALIGN_END);
-        gtk_container_add(GTK_CONTAINER(self->split_rows[i]),
-            self->split_times[i]);
-
-        if (game->split_times[i]) {
-            ls_split_string(str, game->split_times[i], 0);
-            gtk_label_set_text(GTK_LABEL(self->split_times[i]), str);
+            self->title_classes[i] = strdup(str);
         }
-
-        gtk_widget_show_all(self->split_rows[i]);
     }
 
-    if (self->icons_css_provider) {
-        // remove old css provider
-        gtk_style_context_remove_provider_for_screen(
-            gdk_screen_get_default(),
-            GTK_STYLE_PROVIDER(self->icons_css_provider));
-        g_object_unref(self->icons_css_provider);
-        self->icons_css_provider = NULL;
-    }
-
-    if (icons_css_src->len > 0) {
-        self->icons_css_provider = gtk_css_provider_new();
-        gtk_css_provider_load_from_data(
-            self->icons_css_provider,
-            icons_css_src->str,
-            icons_css_src->len,
-            NULL);
-        // add new css provider
-        gtk_style_context_add_provider_for_screen(
-            gdk_screen_get_default(),
-            GTK_STYLE_PROVIDER(self->icons_css_provider),
-            GTK_STYLE_PROVIDER_PRIORITY_USER);
-        g_string_free(icons_css_src, TRUE);
+    if (self->split_count) {
+        // One row to measure, the rest are created as they fit
+        self->rows = calloc(1, sizeof(LSSplitRow));
+        if (self->rows) {
+            row_init(self, &self->rows[0], self->splits);
+            row_bind(self, &self->rows[0], game, 0);
+            self->row_count = 1;
+        }
+        row_init(self, &self->last_row, self->split_last);
     }
 
+    // Draw every row on the next frame
+    self->generation = timer->generation - 1;
+    gtk_adjustment_set_value(self->split_adjust, 0);
     gtk_widget_show(self->splits);
-    if (self->split_count)
-        splits_trailer(self_);
 }
 
 /**
@@ -299,20 +423,115 @@ static void splits_show_game(LSComponent* self_, const ls_game* game,
 static void splits_clear_game(LSComponent* self_)
 {
     LSSplits* self = (LSSplits*)self_;
-    int i;
     gtk_widget_hide(self->splits);
     gtk_widget_hide(self->split_last);
-    for (i = self->split_count - 1; i >= 0; --i) {
-        gtk_container_remove(
-            GTK_CONTAINER(gtk_widget_get_parent(self->split_rows[i])),
-            self->split_rows[i]);
-    }
-    gtk_adjustment_set_value(self->split_adjust, 0);
     free_all(self);
+    gtk_adjustment_set_value(self->split_adjust, 0);
     self->split_count = 0;
+    self->offset = 0;
+}
+
+/**
+ * Returns the split times the rows are compared against, when they aren't
+ * the ones of the window.
+ *
+ * @param self The splits component.
+ * @param game The game struct instance.
+ * @param timer The timer instance.
+ *
+ * @return The cumulative split times, NULL to use the comparison of the timer.
+ */
+static const long long* splits_comparison(const LSSplits* self, const ls_game* game, const ls_timer* timer)
+{
+    if (self->comparison == LS_COMPARISON_COUNT) {
+        return NULL;
+    }
+    // Like the window, the personal best stands in until the history is ready
+    const ls_comparisons* comparisons = timer->comparisons;
+    if (comparisons && comparisons->split_count == game->split_count && comparisons->split_times[self->comparison]) {
+        return comparisons->split_times[self->comparison];
+    }
+    return game->split_times;
+}
+
+/**
+ * Calculates the delta of a split against a comparison, like the timer does.
+ *
+ * @param timer The timer instance.
+ * @param comparison The cumulative split times to compare against.
+ * @param i The index of the split.
+ *
+ * @return The delta, 0 if the split or the comparison time is unknown.
+ */
+static long long split_delta(const ls_timer* timer, const long long* comparison, unsigned int i)
+{
+    if (!timer->split_times[i] || !comparison[i] || comparison[i] == LLONG_MAX) {
+        return 0;
+    }
+    return timer->split_times[i] - comparison[i];
 }
 
 #define SHOW_DELTA_THRESHOLD (-30 * 1000000LL)
+/**
+ * Draws the split a row is showing, if it changed since the row was last drawn.
+ *
+ * @param row The row.
+ * @param timer The timer instance.
+ * @param comparison The cumulative split times to compare against, NULL for the comparison of the timer.
+ * @param redraw_all Whether the whole run changed.
+ */
+static void row_draw(LSSplitRow* row, const ls_timer* timer, const long long* comparison, bool redraw_all)
+{
+    const unsigned int i = row->split;
+    char str[256];
+    if (!row->dirty && !redraw_all && timer->split_generations[i] == row->split_generation) {
+        return;
+    }
+    row->dirty = false;
+    row->split_generation = timer->split_generations[i];
+
+    set_class(row->row, "current-split", i == timer->curr_split && timer->started);
+
+    const long long* comparison_splits = comparison ? comparison : timer->comparison_splits;
+    const long long time = i < timer->curr_split ? timer->split_times[i] : comparison_splits[i];
+    set_class(row->time, "done", i < timer->curr_split);
+    set_class(row->time, "time", time);
+    if (time) {
+        ls_split_string(str, time, 0);
+        set_label_text(row->time, str);
+    } else {
+        set_label_text(row->time, "-");
+    }
+
+    long long delta = timer->split_deltas[i];
+    int info = timer->split_info[i];
+    if (comparison) {
+        delta = split_delta(timer, comparison, i);
+        info &= ~(LS_INFO_BEHIND_TIME | LS_INFO_LOSING_TIME);
+        if (delta > 0) {
+            info |= LS_INFO_BEHIND_TIME;
+        }
+        if (delta > (i ? split_delta(timer, comparison, i - 1) : 0)) {
+            info |= LS_INFO_LOSING_TIME;
+        }
+    }
+    const bool show_delta = i < timer->curr_split || delta >= SHOW_DELTA_THRESHOLD;
+    if (!show_delta) {
+        info = 0;
+    }
+    set_class(row->delta, "best-split", info & LS_INFO_BEST_SPLIT);
+    set_class(row->delta, "best-segment", info & LS_INFO_BEST_SEGMENT);
+    set_class(row->delta, "behind", info & LS_INFO_BEHIND_TIME);
+    set_class(row->delta, "losing", info & LS_INFO_LOSING_TIME);
+    set_class(row->delta, "delta", show_delta && delta);
+    if (show_delta && delta) {
+        ls_delta_string(str, delta);
+        set_label_text(row->delta, str);
+    } else {
+        set_label_text(row->delta, "");
+    }
+}
+
 /**
  * Function to execute when ls_app_window_draw is executed.
  *
@@ -323,153 +542,125 @@ static void splits_clear_game(LSComponent* self_)
 static void splits_draw(LSComponent* self_, const ls_game* game, const ls_timer* timer)
 {
     LSSplits* self = (LSSplits*)self_;
-    char str[256];
-    for (unsigned int i = 0; i < self->split_count; ++i) {
-        if (i == timer->curr_split
-            && timer->started) {
-            add_class(self->split_rows[i], "current-split");
-        } else {
-            remove_class(self->split_rows[i], "current-split");
-        }
-
-        remove_class(self->split_times[i], "time");
-        remove_class(self->split_times[i], "done");
-
-        // Set split_times label to -
-        gtk_label_set_text(GTK_LABEL(self->split_times[i]), "-");
+    if (!self->split_count || !self->row_count) {
+        return;
+    }
 
-        if (i < timer->curr_split) {
-            add_class(self->split_times[i], "done");
-            if (timer->split_times[i]) {
-                add_class(self->split_times[i], "time");
-                ls_split_string(str, timer->split_times[i], 0);
-                gtk_label_set_text(GTK_LABEL(self->split_times[i]), str);
+    const unsigned int rows = visible_rows(self);
+    if (self->split_count <= rows) {
+        self->offset = 0;
+    } else if (self->offset > self->split_count - rows) {
+        self->offset = self->split_count - rows;
+    }
+    const unsigned int shown = self->split_count - self->offset < rows ? self->split_count - self->offset : rows;
+
+    // Create the rows that fit but don't exist yet
+    if (shown > self->row_count) {
+        LSSplitRow* new_rows = realloc(self->rows, shown * sizeof(LSSplitRow));
+        if (new_rows) {
+            self->rows = new_rows;
+            for (unsigned int k = self->row_count; k < shown; ++k) {
+                row_init(self, &self->rows[k], self->splits);
             }
-        } else if (game->split_times[i]) {
-            add_class(self->split_times[i], "time");
-            ls_split_string(str, game->split_times[i], 0);
-            gtk_label_set_text(GTK_LABEL(self->split_times[i]), str);
+            self->row_count = shown;
         }
+    }
 
-        remove_class(self->split_deltas[i], "best-split");
-        remove_class(self->split_deltas[i], "best-segment");
-        remove_class(self->split_deltas[i], "behind");
-        remove_class(self->split_deltas[i], "losing");
-        remove_class(self->split_deltas[i], "delta");
-        gtk_label_set_text(GTK_LABEL(self->split_deltas[i]), "");
-        if (i < timer->curr_split
-            || timer->split_deltas[i] >= SHOW_DELTA_THRESHOLD) {
-            if (timer->split_info[i] & LS_INFO_BEST_SPLIT) {
-                add_class(self->split_deltas[i], "best-split");
-            }
-            if (timer->split_info[i] & LS_INFO_BEST_SEGMENT) {
-                add_class(self->split_deltas[i], "best-segment");
-            }
-            if (timer->split_info[i] & LS_INFO_BEHIND_TIME) {
-                add_class(self->split_deltas[i], "behind");
-                if (timer->split_info[i]
-                    & LS_INFO_LOSING_TIME) {
-                    add_class(self->split_deltas[i], "losing");
-                }
-            } else {
-                remove_class(self->split_deltas[i], "behind");
-                if (timer->split_info[i]
-                    & LS_INFO_LOSING_TIME) {
-                    add_class(self->split_deltas[i], "losing");
-                }
-            }
-            if (timer->split_deltas[i]) {
-                add_class(self->split_deltas[i], "delta");
-                ls_delta_string(str, timer->split_deltas[i]);
-                gtk_label_set_text(GTK_LABEL(self->split_deltas[i]), str);
+    // Pick up the icons decoded since the last frame
+    const unsigned long icon_generation = ls_icon_cache_generation();
+    if (icon_generation != self->icon_generation) {
+        self->icon_generation = icon_generation;
+        for (unsigned int k = 0; k < self->row_count; ++k) {
+            if (self->rows[k].split >= 0) {
+                row_set_icon(self, &self->rows[k]);
             }
         }
+        if (self->last_row.split >= 0) {
+            row_set_icon(self, &self->last_row);
+        }
+    }
+
+    // Any change to the run may affect every row, otherwise only rows whose split changed
+    const bool redraw_all = timer->generation != self->generation;
+    self->generation = timer->generation;
+    const long long* comparison = splits_comparison(self, game, timer);
+    for (unsigned int k = 0; k < self->row_count; ++k) {
+        LSSplitRow* row = &self->rows[k];
+        if (k < shown) {
+            row_bind(self, row, game, self->offset + k);
+            row_draw(row, timer, comparison, redraw_all);
+            gtk_widget_show(row->row);
+        } else {
+            // Kept around, in case the list grows again
+            gtk_widget_hide(row->row);
+        }
+    }
+
+    // Pin the last split below the list while it's scrolled out
+    const bool pinned = self->offset + shown < self->split_count;
+    if (pinned) {
+        row_bind(self, &self->last_row, game, self->split_count - 1);
+        row_draw(&self->last_row, timer, comparison, redraw_all);
+        gtk_widget_show(self->split_last);
+    } else {
+        gtk_widget_hide(self->split_last);
     }
 
     // keep split sizes in sync
-    if (self->split_count) {
-        int width;
-        int time_width = 0, delta_width = 0;
-        for (unsigned int i = 0; i < self->split_count; ++i) {
-            width = gtk_widget_get_allocated_width(self->split_deltas[i]);
-            if (width > delta_width) {
-                delta_width = width;
-            }
-            width = gtk_widget_get_allocated_width(self->split_times[i]);
-            if (width > time_width) {
-                time_width = width;
-            }
+    int width;
+    int time_width = 0, delta_width = 0;
+    const unsigned int count = pinned ? shown + 1 : shown;
+    for (unsigned int k = 0; k < count; ++k) {
+        const LSSplitRow* row = k < shown ? &self->rows[k] : &self->last_row;
+        width = gtk_widget_get_allocated_width(row->delta);
+        if (width > delta_width) {
+            delta_width = width;
         }
-        for (unsigned int i = 0; i < self->split_count; ++i) {
-            if (delta_width) {
-                gtk_widget_set_size_request(
-                    self->split_deltas[i], delta_width, -1);
-            }
-            if (time_width) {
-                width = gtk_widget_get_allocated_width(
-                    self->split_times[i]);
-                gtk_widget_set_margin_start(self->split_times[i],
-                    /*WINDOW_PAD*/ 8 * 2 + (time_width - width));
-            }
+        width = gtk_widget_get_allocated_width(row->time);
+        if (width > time_width) {
+            time_width = width;
+        }
+    }
+    for (unsigned int k = 0; k < count; ++k) {
+        const LSSplitRow* row = k < shown ? &self->rows[k] : &self->last_row;
+        if (delta_width) {
+            gtk_widget_set_size_request(row->delta, delta_width, -1);
+        }
+        if (time_width) {
+            width = gtk_widget_get_allocated_width(row->time);
+            gtk_widget_set_margin_start(row->time,
+                /*WINDOW_PAD*/ 8 * 2 + (time_width - width));
         }
     }
-
-    if (self->split_count)
-        splits_trailer(self_);
 }
 
 /**
  * Scrolls to the current split if it's not visible.
  *
+ * Keeps the previous and the next split visible too, when they fit.
+ *
  * @param self_ The splits component itself.
  * @param timer The timer instance.
  */
 static void splits_scroll_to_split(LSComponent* self_, const ls_timer* timer)
 {
     LSSplits* self = (LSSplits*)self_;
-    int split_x, split_y;
-    int split_h;
-    int scroller_h;
-    double curr_scroll;
-    double min_scroll, max_scroll;
 
-    if (timer->game->split_count == 0)
+    if (self->split_count == 0)
         return;
 
-    unsigned int prev = timer->curr_split ? timer->curr_split - 1 : 0;
-    unsigned int curr = timer->curr_split;
-    unsigned int next = timer->curr_split + 1;
-    if (prev < 0) {
-        prev = 0;
-    }
-    if (curr >= self->split_count) {
-        curr = self->split_count - 1;
-    }
-    if (next >= self->split_count) {
-        next = self->split_count - 1;
-    }
-    curr_scroll = gtk_adjustment_get_value(self->split_adjust);
-    gtk_widget_translate_coordinates(
-        self->split_titles[prev],
-        self->split_viewport,
-        0, 0, &split_x, &split_y);
-    scroller_h = gtk_widget_get_allocated_height(self->split_scroller);
-    split_h = gtk_widget_get_allocated_height(self->split_titles[prev]);
-    if (curr != next && curr != prev) {
-        split_h += gtk_widget_get_allocated_height(self->split_titles[curr]);
-    }
-    if (next != prev) {
-        int h = gtk_widget_get_allocated_height(self->split_titles[next]);
-        if (split_h + h < scroller_h) {
-            split_h += h;
-        }
+    const unsigned int rows = visible_rows(self);
+    const unsigned int curr = timer->curr_split < self->split_count ? timer->curr_split : self->split_count - 1;
+    unsigned int prev = curr ? curr - 1 : 0;
+    unsigned int next = curr + 1 < self->split_count ? curr + 1 : curr;
+    if (next - prev >= rows) {
+        // Not enough room for all three, the current split matters most
+        prev = next = curr;
     }
-    min_scroll = split_y + curr_scroll - scroller_h + split_h;
-    max_scroll = split_y + curr_scroll;
-    if (curr_scroll > max_scroll) {
-        gtk_adjustment_set_value(self->split_adjust, max_scroll);
-    } else if (curr_scroll < min_scroll) {
-        gtk_adjustment_set_value(self->split_adjust, min_scroll);
+    if (prev < self->offset) {
+        self->offset = prev;
+    } else if (next >= self->offset + rows) {
+        self->offset = next + 1 - rows;
     }
 }
 
@@ -21,7 +21,7 @@ extern LSComponentOps ls_title_operations; // defined at the end of the file
 /**
  * Constructor
  */
-LSComponent* ls_component_title_new(void)
+LSComponent* ls_component_title_new(const char* arg)
 {
     LSTitle* self;
 
@@ -141,7 +141,7 @@ static void title_draw(LSComponent* self_, const ls_game* game, const ls_timer*
     strcpy(combi_str, finished_str);
     strcat(combi_str, "/");
     strcat(combi_str, attempt_str);
-    gtk_label_set_text(GTK_LABEL(self->attempt_count), combi_str);
+    set_label_text(self->attempt_count, combi_str);
 }
 
 LSComponentOps ls_title_operations = {
@@ -20,7 +20,7 @@ extern LSComponentOps ls_wr_operations;
 /**
  * Constructor
  */
-LSComponent* ls_component_wr_new(void)
+LSComponent* ls_component_wr_new(const char* arg)
 {
     LSWr* self;
 
@@ -124,7 +124,7 @@ static void wr_draw(LSComponent* self_, const ls_game* game,
         } else {
             ls_time_string(str, game->world_record);
         }
-        gtk_label_set_text(GTK_LABEL(self->world_record), str);
+        set_label_text(self->world_record, str);
     }
 }
 
@@ -34,6 +34,18 @@ gboolean button_right_click(GtkWidget* widget, GdkEventButton* event, gpointer a
             gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(menu_enable_auto_splitter), atomic_load(&auto_splitter_enabled));
             GtkWidget* menu_enable_win_on_top = gtk_check_menu_item_new_with_label("Always on Top");
             gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(menu_enable_win_on_top), win->opts.win_on_top);
+            GtkWidget* menu_comparison = gtk_menu_item_new_with_label("Compare Against");
+            GtkWidget* menu_comparisons = gtk_menu_new();
+            GSList* comparison_group = NULL;
+            for (int i = 0; i < LS_COMPARISON_COUNT; ++i) {
+                GtkWidget* item = gtk_radio_menu_item_new_with_label(comparison_group, ls_comparison_names[i]);
+                comparison_group = gtk_radio_menu_item_get_group(GTK_RADIO_MENU_ITEM(item));
+                gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(item), (ls_comparison_type)i == win->comparison);
+                g_object_set_data(G_OBJECT(item), "comparison", GINT_TO_POINTER(i));
+                g_signal_connect(item, "toggled", G_CALLBACK(menu_set_comparison), app);
+                gtk_menu_shell_append(GTK_MENU_SHELL(menu_comparisons), item);
+            }
+            gtk_menu_item_set_submenu(GTK_MENU_ITEM(menu_comparison), menu_comparisons);
             GtkWidget* menu_reload = gtk_menu_item_new_with_label("Reload");
             GtkWidget* menu_close = gtk_menu_item_new_with_label("Close");
             GtkWidget* menu_settings = gtk_menu_item_new_with_label("Settings");
@@ -47,6 +59,7 @@ gboolean button_right_click(GtkWidget* widget, GdkEventButton* event, gpointer a
             gtk_menu_shell_append(GTK_MENU_SHELL(menu), menu_open_auto_splitter);
             gtk_menu_shell_append(GTK_MENU_SHELL(menu), menu_enable_auto_splitter);
             gtk_menu_shell_append(GTK_MENU_SHELL(menu), gtk_separator_menu_item_new());
+            gtk_menu_shell_append(GTK_MENU_SHELL(menu), menu_comparison);
             gtk_menu_shell_append(GTK_MENU_SHELL(menu), menu_reload);
             gtk_menu_shell_append(GTK_MENU_SHELL(menu), menu_close);
             gtk_menu_shell_append(GTK_MENU_SHELL(menu), gtk_separator_menu_item_new());
@@ -118,3 +118,54 @@ bool display_confirm_reset_dialog(void)
     gtk_widget_destroy(dialog);
     return response == GTK_RESPONSE_YES;
 }
+
+bool display_confirm_restore_dialog(void)
+{
+    GtkApplication* app = GTK_APPLICATION(g_application_get_default());
+    GtkWindow* win = NULL;
+    if (app != NULL) {
+        win = gtk_application_get_active_window(app);
+    }
+    GtkWidget* dialog = gtk_message_dialog_new(
+        GTK_WINDOW(win),
+        GTK_DIALOG_MODAL,
+        GTK_MESSAGE_QUESTION,
+        GTK_BUTTONS_YES_NO,
+        "LibreSplit was closed while a run was in progress.\n\n"
+        "Do you want to restore it?");
+    gtk_window_set_title(GTK_WINDOW(dialog), "Restore Run?");
+
+    gint response = gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+    return response == GTK_RESPONSE_YES;
+}
+
+/**
+ * Tells the user a file couldn't be saved.
+ *
+ * @param data The path of the file, freed here.
+ *
+ * @return False, to remove the function from the queue.
+ */
+gboolean display_save_error_dialog(gpointer data)
+{
+    char* path = data;
+    GtkApplication* app = GTK_APPLICATION(g_application_get_default());
+    GtkWindow* win = NULL;
+    if (app != NULL) {
+        win = gtk_application_get_active_window(app);
+    }
+    GtkWidget* dialog = gtk_message_dialog_new(
+        GTK_WINDOW(win),
+        GTK_DIALOG_DESTROY_WITH_PARENT,
+        GTK_MESSAGE_ERROR,
+        GTK_BUTTONS_OK,
+        "LibreSplit couldn't save\n%s\n\n"
+        "Check that the disk isn't full and that the folder is writable.",
+        path);
+    gtk_window_set_title(GTK_WINDOW(dialog), "Save Failed");
+    g_signal_connect(dialog, "response", G_CALLBACK(gtk_widget_destroy), NULL);
+    gtk_widget_show_all(dialog);
+    g_free(path);
+    return FALSE;
+}
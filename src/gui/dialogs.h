@@ -8,3 +8,7 @@ gboolean display_non_capable_mem_read_dialog(gpointer data);
 bool display_root_warning_dialog(void);
 
 bool display_confirm_reset_dialog(void);
+
+bool display_confirm_restore_dialog(void);
+
+gboolean display_save_error_dialog(gpointer data);
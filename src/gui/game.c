@@ -26,6 +26,7 @@ void ls_app_window_clear_game(LSAppWindow* win)
     }
 
     ls_app_load_theme_with_fallback(win, cfg.libresplit.theme.value.s, cfg.libresplit.theme_variant.value.s);
+    ls_app_window_request_draw(GTK_WIDGET(win));
 }
 
 /**
@@ -65,17 +66,18 @@ void ls_app_window_show_game(LSAppWindow* win)
 
     gtk_widget_show(win->box);
     gtk_widget_hide(win->welcome_box->box);
+    ls_app_window_request_draw(GTK_WIDGET(win));
 }
 
-gpointer save_game_thread(gpointer data)
-{
-    ls_game* game = data;
-    ls_game_save(game);
-    return NULL;
-}
-
+/**
+ * Saves the split file without blocking the GUI.
+ *
+ * The game is serialized right away, so later changes to it won't race
+ * with the write, which happens on the saver thread.
+ *
+ * @param game The game to save.
+ */
 void save_game(ls_game* game)
 {
-    GThread* thread = g_thread_new("save_game", save_game_thread, game);
-    g_thread_unref(thread);
+    ls_game_save(game);
 }
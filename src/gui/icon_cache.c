@@ -0,0 +1,265 @@
+/** \file icon_cache.c
+ *
+ * Cache of the decoded split icons.
+ *
+ * Icons are decoded once, on a worker thread, to fit in LS_ICON_SIZE and
+ * kept for the whole session, keyed by path and modification time. Asking
+ * for an icon never touches the disk on the calling thread: it's either
+ * ready, or it will be, and the cache generation changes when it is.
+ */
+#include "icon_cache.h"
+#include "src/gui/app_window.h"
+#include "src/logging.h"
+
+#include <linux/prctl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+
+/**
+ * @brief A cached icon.
+ */
+typedef struct LSIcon {
+    char* path; /*!< The path, as written in the split file */
+    time_t mtime; /*!< Modification time of the file when it was decoded */
+    GdkPixbuf* pixbuf; /*!< The decoded icon, NULL until decoded or if it can't be */
+    bool queued; /*!< Whether the icon waits to be (re)decoded */
+    struct LSIcon* next_job; /*!< Next icon waiting to be decoded */
+} LSIcon;
+
+/**
+ * The cache, shared by the main thread and the worker.
+ */
+static struct {
+    GHashTable* icons; /*!< LSIcon by path */
+    LSIcon* head; /*!< Icons waiting to be decoded */
+    LSIcon* tail;
+    bool refresh; /*!< Whether the worker should look for changed icons */
+    bool active;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} cache = {
+    .active = true,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+/*! Bumped every time an icon gets decoded */
+static atomic_ulong generation = 0;
+
+/**
+ * Queues an icon for decoding. The cache lock must be held.
+ *
+ * @param icon The icon.
+ */
+static void queue_icon(LSIcon* icon)
+{
+    if (icon->queued) {
+        return;
+    }
+    icon->queued = true;
+    icon->next_job = NULL;
+    if (cache.tail) {
+        cache.tail->next_job = icon;
+    } else {
+        cache.head = icon;
+    }
+    cache.tail = icon;
+    pthread_cond_signal(&cache.cond);
+}
+
+/**
+ * Returns an icon, asking the worker to decode it if it's not cached yet.
+ *
+ * @param path The path of the icon, as written in the split file.
+ *
+ * @return A new reference to the icon, or NULL if it's not ready yet.
+ */
+GdkPixbuf* ls_icon_cache_get(const char* path)
+{
+    GdkPixbuf* pixbuf = NULL;
+    pthread_mutex_lock(&cache.lock);
+    if (!cache.icons) {
+        cache.icons = g_hash_table_new(g_str_hash, g_str_equal);
+    }
+    LSIcon* icon = g_hash_table_lookup(cache.icons, path);
+    if (!icon) {
+        icon = calloc(1, sizeof(LSIcon));
+        if (icon) {
+            icon->path = strdup(path);
+            g_hash_table_insert(cache.icons, icon->path, icon);
+            queue_icon(icon);
+        }
+    } else if (icon->pixbuf) {
+        pixbuf = g_object_ref(icon->pixbuf);
+    }
+    pthread_mutex_unlock(&cache.lock);
+    return pixbuf;
+}
+
+/**
+ * Returns the cache generation, which changes every time an icon is ready.
+ *
+ * @return The generation.
+ */
+unsigned long ls_icon_cache_generation(void)
+{
+    return atomic_load(&generation);
+}
+
+/**
+ * Asks the worker to decode again the icons that changed on disk.
+ * Meant for when a split file is (re)opened, not for resets.
+ */
+void ls_icon_cache_refresh(void)
+{
+    pthread_mutex_lock(&cache.lock);
+    cache.refresh = true;
+    pthread_cond_signal(&cache.cond);
+    pthread_mutex_unlock(&cache.lock);
+}
+
+/**
+ * Asks the worker thread to exit.
+ */
+void ls_icon_cache_close(void)
+{
+    pthread_mutex_lock(&cache.lock);
+    cache.active = false;
+    pthread_cond_signal(&cache.cond);
+    pthread_mutex_unlock(&cache.lock);
+}
+
+/**
+ * Returns the file an icon path refers to.
+ *
+ * @param path The path, as written in the split file, may be a file:// URI.
+ *
+ * @return The file name, to be freed with g_free.
+ */
+static char* icon_filename(const char* path)
+{
+    if (g_str_has_prefix(path, "file://")) {
+        char* filename = g_filename_from_uri(path, NULL, NULL);
+        if (filename) {
+            return filename;
+        }
+    }
+    return g_strdup(path);
+}
+
+/**
+ * Returns the modification time of an icon file.
+ *
+ * @param filename The file.
+ *
+ * @return The modification time, 0 if the file doesn't exist.
+ */
+static time_t icon_mtime(const char* filename)
+{
+    struct stat st;
+    if (stat(filename, &st) == -1) {
+        return 0;
+    }
+    return st.st_mtime;
+}
+
+/**
+ * Queues the icons whose file changed since they were decoded.
+ *
+ * Runs on the worker with the cache lock held, which is released while the
+ * files are checked so slow storage never blocks ls_icon_cache_get.
+ */
+static void refresh_icons(void)
+{
+    GHashTableIter iter;
+    gpointer value;
+    if (!cache.icons) {
+        return;
+    }
+    // Icons are never removed, so they stay valid without the lock
+    const guint count = g_hash_table_size(cache.icons);
+    LSIcon** icons = g_new(LSIcon*, count);
+    time_t* mtimes = g_new(time_t, count);
+    guint i = 0;
+    g_hash_table_iter_init(&iter, cache.icons);
+    while (i < count && g_hash_table_iter_next(&iter, NULL, &value)) {
+        icons[i++] = value;
+    }
+    pthread_mutex_unlock(&cache.lock);
+
+    for (guint j = 0; j < i; j++) {
+        char* filename = icon_filename(icons[j]->path);
+        mtimes[j] = icon_mtime(filename);
+        g_free(filename);
+    }
+
+    pthread_mutex_lock(&cache.lock);
+    for (guint j = 0; j < i; j++) {
+        if (mtimes[j] != icons[j]->mtime) {
+            queue_icon(icons[j]);
+        }
+    }
+    g_free(icons);
+    g_free(mtimes);
+}
+
+/**
+ * The icon cache worker thread, decodes the queued icons.
+ *
+ * @param arg Unused.
+ */
+void* ls_icon_cache_thread(void* arg)
+{
+    prctl(PR_SET_NAME, "LS Icons", 0, 0, 0);
+
+    pthread_mutex_lock(&cache.lock);
+    while (1) {
+        while (cache.head == NULL && !cache.refresh && cache.active) {
+            pthread_cond_wait(&cache.cond, &cache.lock);
+        }
+        if (!cache.active) {
+            break;
+        }
+        if (cache.refresh) {
+            cache.refresh = false;
+            refresh_icons();
+            continue;
+        }
+
+        LSIcon* icon = cache.head;
+        cache.head = icon->next_job;
+        if (!cache.head) {
+            cache.tail = NULL;
+        }
+        // Icons are never removed, so the path stays valid
+        char* filename = icon_filename(icon->path);
+        pthread_mutex_unlock(&cache.lock);
+
+        GError* error = NULL;
+        const time_t mtime = icon_mtime(filename);
+        GdkPixbuf* pixbuf = gdk_pixbuf_new_from_file_at_scale(filename, LS_ICON_SIZE, LS_ICON_SIZE, TRUE, &error);
+        if (!pixbuf) {
+            LOG_WARNF("Cannot load split icon %s: %s", filename, error->message);
+            g_error_free(error);
+        }
+        g_free(filename);
+
+        pthread_mutex_lock(&cache.lock);
+        GdkPixbuf* old = icon->pixbuf;
+        icon->pixbuf = pixbuf;
+        icon->mtime = mtime;
+        icon->queued = false;
+        atomic_fetch_add(&generation, 1);
+        if (old) {
+            g_object_unref(old);
+        }
+        // The window may be idle, it has to draw the icon
+        ls_app_wake();
+    }
+    pthread_mutex_unlock(&cache.lock);
+    return NULL;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <stdbool.h>
+
+#define LS_ICON_SIZE 64 /*!< Icons are decoded to fit in a square this big, then scaled when drawn */
+
+GdkPixbuf* ls_icon_cache_get(const char* path);
+unsigned long ls_icon_cache_generation(void);
+void ls_icon_cache_refresh(void);
+
+void ls_icon_cache_close(void);
+void* ls_icon_cache_thread(void* arg);
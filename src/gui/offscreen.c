@@ -0,0 +1,340 @@
+/** \file offscreen.c
+ *
+ * Offscreen renderer, for streaming setups.
+ *
+ * When LIBRESPLIT_OFFSCREEN_SHM or LIBRESPLIT_OFFSCREEN_PIPE is set, the
+ * components are moved into a GtkOffscreenWindow instead of being shown.
+ * GTK still lays them out and paints them with the theme, and their draw
+ * ops still run, but the frames end up in shared memory or a pipe rather
+ * than on screen. It works on any display, Xvfb included.
+ *
+ * - LIBRESPLIT_OFFSCREEN_SHM: file to map the latest frame into, put it in
+ *   /dev/shm to keep it in memory.
+ * - LIBRESPLIT_OFFSCREEN_PIPE: file or FIFO to write every frame to. Frames
+ *   are dropped while the reader is behind.
+ * - LIBRESPLIT_OFFSCREEN_RATE: frames per second, 30 by default, at most 1000.
+ * - LIBRESPLIT_OFFSCREEN_SIZE: size of the frames, as WIDTHxHEIGHT.
+ */
+#include "offscreen.h"
+#include "src/gui/utils.h"
+#include "src/logging.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/limits.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define OFFSCREEN_DEFAULT_RATE 30
+#define OFFSCREEN_MAX_RATE 1000 /*!< Frames are at least a millisecond apart */
+
+/**
+ * The offscreen renderer state.
+ */
+static struct {
+    GtkWidget* window; /*!< The offscreen window holding the components, NULL if not active */
+    guint source; /*!< The source publishing the frames, 0 once stopped */
+    bool damaged; /*!< Whether GTK painted the window since the last frame */
+    uint64_t frame; /*!< Frames published so far */
+
+    int shm_fd; /*!< The shared memory file, -1 if not used */
+    void* shm; /*!< The shared memory file, mapped */
+    size_t shm_size; /*!< Size of the mapping */
+
+    char pipe_path[PATH_MAX]; /*!< The pipe, empty if not used */
+    int pipe_fd; /*!< The pipe, -1 until a reader shows up */
+    unsigned char* buffer; /*!< Frame being written to the pipe */
+    size_t buffer_capacity;
+    size_t pending; /*!< Bytes of the frame to write, 0 if it's all written */
+    size_t written; /*!< Bytes of the frame already written */
+} offscreen = {
+    .shm_fd = -1,
+    .pipe_fd = -1,
+};
+
+/**
+ * Copies the offscreen window into a frame.
+ *
+ * @param source The surface GTK painted the window on.
+ * @param header Where to write the frame, with room for the pixels after it.
+ * @param width Width of the frame.
+ * @param height Height of the frame.
+ * @param stride Stride of the frame.
+ */
+static void render(cairo_surface_t* source, ls_offscreen_header* header, int width, int height, int stride)
+{
+    header->magic = LS_OFFSCREEN_MAGIC;
+    header->width = width;
+    header->height = height;
+    header->stride = stride;
+    header->reserved = 0;
+    header->frame = offscreen.frame;
+    header->time = g_get_monotonic_time();
+
+    cairo_surface_t* target = cairo_image_surface_create_for_data(
+        (unsigned char*)(header + 1), CAIRO_FORMAT_ARGB32, width, height, stride);
+    cairo_t* cr = cairo_create(target);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_surface(cr, source, 0, 0);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+    cairo_surface_destroy(target);
+}
+
+/**
+ * Publishes a frame in shared memory, growing it if needed.
+ *
+ * @param source The surface GTK painted the window on.
+ * @param width Width of the frame.
+ * @param height Height of the frame.
+ * @param stride Stride of the frame.
+ */
+static void publish_shm(cairo_surface_t* source, int width, int height, int stride)
+{
+    const size_t size = sizeof(ls_offscreen_header) + (size_t)stride * height;
+    if (size > offscreen.shm_size) {
+        if (offscreen.shm) {
+            munmap(offscreen.shm, offscreen.shm_size);
+            offscreen.shm = NULL;
+            offscreen.shm_size = 0;
+        }
+        if (ftruncate(offscreen.shm_fd, size) == -1) {
+            LOG_ERRF("Cannot resize the offscreen shared memory: %s", strerror(errno));
+            return;
+        }
+        void* shm = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, offscreen.shm_fd, 0);
+        if (shm == MAP_FAILED) {
+            LOG_ERRF("Cannot map the offscreen shared memory: %s", strerror(errno));
+            return;
+        }
+        offscreen.shm = shm;
+        offscreen.shm_size = size;
+    }
+
+    ls_offscreen_header* header = offscreen.shm;
+    header->sequence++;
+    atomic_thread_fence(memory_order_release);
+    render(source, header, width, height, stride);
+    atomic_thread_fence(memory_order_release);
+    header->sequence++;
+}
+
+/**
+ * Writes as much of the pending frame as the pipe takes without blocking.
+ */
+static void flush_pipe(void)
+{
+    while (offscreen.written < offscreen.pending) {
+        const ssize_t n = write(offscreen.pipe_fd, offscreen.buffer + offscreen.written,
+            offscreen.pending - offscreen.written);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                return;
+            }
+            // The reader is gone, wait for another one
+            close(offscreen.pipe_fd);
+            offscreen.pipe_fd = -1;
+            break;
+        }
+        offscreen.written += n;
+    }
+    offscreen.pending = 0;
+    offscreen.written = 0;
+}
+
+/**
+ * Writes a frame to the pipe, unless the previous one is still pending.
+ *
+ * @param source The surface GTK painted the window on.
+ * @param width Width of the frame.
+ * @param height Height of the frame.
+ * @param stride Stride of the frame.
+ */
+static void publish_pipe(cairo_surface_t* source, int width, int height, int stride)
+{
+    if (offscreen.pending) {
+        return;
+    }
+    if (offscreen.pipe_fd < 0) {
+        // Fails until a reader opens the FIFO
+        offscreen.pipe_fd = open(offscreen.pipe_path, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+        if (offscreen.pipe_fd < 0) {
+            return;
+        }
+    }
+
+    const size_t size = sizeof(ls_offscreen_header) + (size_t)stride * height;
+    if (size > offscreen.buffer_capacity) {
+        unsigned char* buffer = realloc(offscreen.buffer, size);
+        if (!buffer) {
+            LOG_ERR("Cannot allocate memory for an offscreen frame");
+            return;
+        }
+        offscreen.buffer = buffer;
+        offscreen.buffer_capacity = size;
+    }
+    ls_offscreen_header* header = (ls_offscreen_header*)offscreen.buffer;
+    header->sequence = 0;
+    render(source, header, width, height, stride);
+    offscreen.pending = size;
+    offscreen.written = 0;
+    flush_pipe();
+}
+
+/**
+ * Draws the components and publishes what GTK painted since last time.
+ *
+ * @param data The LibreSplit window.
+ */
+static gboolean offscreen_frame(gpointer data)
+{
+    LSAppWindow* win = data;
+
+    // GTK paints the changes on the next frame of the offscreen window,
+    // they get published on the next call
+    ls_app_window_draw(win);
+
+    if (offscreen.pending) {
+        flush_pipe();
+    }
+    if (!offscreen.damaged) {
+        return G_SOURCE_CONTINUE;
+    }
+    cairo_surface_t* source = gtk_offscreen_window_get_surface(GTK_OFFSCREEN_WINDOW(offscreen.window));
+    if (!source) {
+        return G_SOURCE_CONTINUE;
+    }
+    offscreen.damaged = false;
+    offscreen.frame++;
+
+    const int width = gtk_widget_get_allocated_width(offscreen.window);
+    const int height = gtk_widget_get_allocated_height(offscreen.window);
+    const int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, width);
+    if (offscreen.shm_fd >= 0) {
+        publish_shm(source, width, height, stride);
+    }
+    if (offscreen.pipe_path[0]) {
+        publish_pipe(source, width, height, stride);
+    }
+    ls_app_window_shown(win);
+    return G_SOURCE_CONTINUE;
+}
+
+/**
+ * Notes that GTK painted the offscreen window.
+ *
+ * @param widget The offscreen window.
+ * @param event The damage event.
+ * @param data Unused.
+ *
+ * @return FALSE, to let other handlers run.
+ */
+static gboolean offscreen_damaged(GtkWidget* widget, GdkEvent* event, gpointer data)
+{
+    offscreen.damaged = true;
+    return FALSE;
+}
+
+/**
+ * Tells the components the size of the frames changed.
+ *
+ * @param widget The offscreen window.
+ * @param allocation Its new size.
+ * @param data The LibreSplit window.
+ */
+static void offscreen_size_allocate(GtkWidget* widget, GdkRectangle* allocation, gpointer data)
+{
+    ls_app_window_resize_components(data, allocation->width, allocation->height);
+}
+
+/**
+ * Stops publishing frames when the LibreSplit window goes away.
+ *
+ * @param widget The LibreSplit window.
+ * @param data Unused.
+ */
+static void offscreen_stop(GtkWidget* widget, gpointer data)
+{
+    if (offscreen.source) {
+        g_source_remove(offscreen.source);
+        offscreen.source = 0;
+    }
+}
+
+/**
+ * Starts rendering offscreen if the environment asks for it.
+ *
+ * The components of the window are moved to an offscreen window, so the
+ * LibreSplit window should then not be shown.
+ *
+ * @param win The LibreSplit window.
+ *
+ * @return true if rendering offscreen.
+ */
+bool ls_offscreen_start(LSAppWindow* win)
+{
+    const char* shm_path = getenv("LIBRESPLIT_OFFSCREEN_SHM");
+    const char* pipe_path = getenv("LIBRESPLIT_OFFSCREEN_PIPE");
+    const char* rate_env = getenv("LIBRESPLIT_OFFSCREEN_RATE");
+    const char* size_env = getenv("LIBRESPLIT_OFFSCREEN_SIZE");
+    int rate = OFFSCREEN_DEFAULT_RATE;
+    int width, height;
+
+    if (!shm_path && !pipe_path) {
+        return false;
+    }
+    if (rate_env && atoi(rate_env) > 0) {
+        rate = atoi(rate_env);
+        if (rate > OFFSCREEN_MAX_RATE) {
+            rate = OFFSCREEN_MAX_RATE;
+        }
+    }
+    if (shm_path) {
+        offscreen.shm_fd = open(shm_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (offscreen.shm_fd < 0) {
+            LOG_ERRF("Cannot open the offscreen shared memory %s: %s", shm_path, strerror(errno));
+        }
+    }
+    if (pipe_path && strlen(pipe_path) < sizeof(offscreen.pipe_path)) {
+        strcpy(offscreen.pipe_path, pipe_path);
+        // A reader going away must not kill LibreSplit
+        signal(SIGPIPE, SIG_IGN);
+    }
+
+    offscreen.window = gtk_offscreen_window_new();
+    add_class(offscreen.window, "window");
+    add_class(offscreen.window, "main-window");
+    if (size_env && sscanf(size_env, "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+        gtk_widget_set_size_request(offscreen.window, width, height);
+    }
+
+    g_object_ref(win->container);
+    gtk_container_remove(GTK_CONTAINER(win), win->container);
+    gtk_container_add(GTK_CONTAINER(offscreen.window), win->container);
+    g_object_unref(win->container);
+
+    g_signal_connect(offscreen.window, "damage-event", G_CALLBACK(offscreen_damaged), NULL);
+    g_signal_connect(offscreen.window, "size-allocate", G_CALLBACK(offscreen_size_allocate), win);
+    gtk_widget_show(offscreen.window);
+
+    // The source holds a reference, as the window may be destroyed before it's removed
+    offscreen.source = g_timeout_add_full(G_PRIORITY_DEFAULT, 1000 / rate, offscreen_frame,
+        g_object_ref(win), g_object_unref);
+    g_signal_connect(win, "destroy", G_CALLBACK(offscreen_stop), NULL);
+    return true;
+}
+
+/**
+ * Tells whether the components are rendered offscreen.
+ *
+ * @return true if rendering offscreen.
+ */
+bool ls_offscreen_active(void)
+{
+    return offscreen.window != NULL;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "src/gui/app_window.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LS_OFFSCREEN_MAGIC 0x4246534c /*!< "LSFB" when read as bytes */
+
+/**
+ * @brief Header of the frames published by the offscreen renderer.
+ *
+ * Pixels follow the header, 32 bits each in BGRA order with premultiplied
+ * alpha, rows being stride bytes apart.
+ *
+ * In shared memory the header and pixels are those of the latest frame.
+ * Readers should read sequence before and after copying the pixels, and
+ * try again if it changed or is odd, as it's odd while a frame is written.
+ * Through a pipe, every frame is written as its header then its pixels.
+ */
+typedef struct ls_offscreen_header {
+    uint32_t magic; /*!< LS_OFFSCREEN_MAGIC */
+    uint32_t width; /*!< Width of the frame, in pixels */
+    uint32_t height; /*!< Height of the frame, in pixels */
+    uint32_t stride; /*!< Bytes from the start of a row to the next */
+    uint32_t sequence; /*!< Odd while the frame is being written */
+    uint32_t reserved;
+    uint64_t frame; /*!< Number of the frame, starting from 1 */
+    int64_t time; /*!< Monotonic time the frame was published at, in microseconds */
+} ls_offscreen_header;
+
+bool ls_offscreen_start(LSAppWindow* win);
+bool ls_offscreen_active(void);
@@ -1,9 +1,12 @@
 #include "theming.h"
 #include "src/gui/app_window.h"
+#include "src/settings/utils.h"
 #include <linux/limits.h>
 #include <string.h>
 #include <sys/stat.h>
 
+#define THEME_RELOAD_DELAY 100 /*!< How long the theme file must stay unchanged before a reload, in ms */
+
 static inline const unsigned char* fallback_css_data(void)
 {
     return _binary____src_fallback_css_start;
@@ -77,25 +80,336 @@ static void apply_reset_rules(LSAppWindow* win, GError** gerror)
         sizeof(reset_rules), gerror);
 }
 /**
- * Loads a specific theme, with a fallback to the default theme
+ * Appends an url to minified CSS, made absolute since the CSS is loaded
+ * from memory and GTK can't resolve relative urls anymore.
+ *
+ * @param out The minified CSS.
+ * @param css The url, quoted or not.
+ * @param len The length of the url.
+ * @param dir The directory of the theme.
+ */
+static void append_url(GString* out, const char* css, size_t len, const char* dir)
+{
+    char* arg = g_strstrip(g_strndup(css, len));
+    len = strlen(arg);
+    if (len >= 2 && (arg[0] == '"' || arg[0] == '\'') && arg[len - 1] == arg[0]) {
+        arg[len - 1] = '\0';
+        memmove(arg, arg + 1, len - 1);
+    }
+    if (!g_uri_parse_scheme(arg) && !g_path_is_absolute(arg)) {
+        char* path = g_build_filename(dir, arg, NULL);
+        char* uri = g_filename_to_uri(path, NULL, NULL);
+        g_string_append_printf(out, "\"%s\"", uri ? uri : path);
+        g_free(uri);
+        g_free(path);
+    } else {
+        g_string_append_printf(out, "\"%s\"", arg);
+    }
+    g_free(arg);
+}
+
+/**
+ * Skips a quoted string.
+ *
+ * @param css The string, on its opening quote.
+ *
+ * @return Where the string ends, after its closing quote.
+ */
+static const char* skip_string(const char* css)
+{
+    const char quote = *css++;
+    while (*css && *css != quote) {
+        css += css[0] == '\\' && css[1] ? 2 : 1;
+    }
+    return *css ? css + 1 : css;
+}
+
+/**
+ * Minifies CSS: drops comments and whitespace that doesn't matter.
+ *
+ * @param css The CSS.
+ * @param dir The directory of the theme, to resolve relative urls.
+ * @param imports Where to store whether the CSS imports other files.
+ *
+ * @return The minified CSS, to be freed with g_free.
+ */
+static char* css_minify(const char* css, const char* dir, bool* imports)
+{
+    GString* out = g_string_sized_new(strlen(css));
+    bool space = false;
+    *imports = false;
+    while (*css) {
+        if (css[0] == '/' && css[1] == '*') {
+            const char* end = strstr(css + 2, "*/");
+            css = end ? end + 2 : css + strlen(css);
+            continue;
+        }
+        if (g_ascii_isspace(*css)) {
+            space = true;
+            css++;
+            continue;
+        }
+        // Whitespace is only kept between words, descendant selectors for instance
+        if (space && out->len && !strchr("{};,>", out->str[out->len - 1]) && !strchr("{};,>", *css)) {
+            g_string_append_c(out, ' ');
+        }
+        space = false;
+        if (*css == '"' || *css == '\'') {
+            const char* start = css;
+            css = skip_string(css);
+            g_string_append_len(out, start, css - start);
+        } else if (g_ascii_strncasecmp(css, "url(", 4) == 0) {
+            const char* end = strchr(css + 4, ')');
+            if (!end) {
+                g_string_append(out, css);
+                break;
+            }
+            g_string_append(out, "url(");
+            append_url(out, css + 4, end - (css + 4), dir);
+            css = end;
+        } else if (g_ascii_strncasecmp(css, "@import", 7) == 0) {
+            *imports = true;
+            g_string_append(out, "@import ");
+            css += 7;
+            while (g_ascii_isspace(*css)) {
+                css++;
+            }
+            // The bare string form is an url too
+            if (*css == '"' || *css == '\'') {
+                const char* start = css;
+                css = skip_string(css);
+                append_url(out, start, css - start, dir);
+            }
+        } else {
+            g_string_append_c(out, *css++);
+        }
+    }
+    return g_string_free(out, FALSE);
+}
+
+/**
+ * Loads CSS into a new style provider, which replaces the current one
+ * only if the CSS parses.
  *
  * @param win The LibreSplit window.
- * @param name The name of the theme to load.
- * @param variant The variant of the theme to load.
+ * @param css The CSS.
+ * @param len The length of the CSS, -1 if it's NUL terminated.
+ * @param what What the CSS is, for error messages.
+ *
+ * @return true if the CSS was loaded.
  */
-void ls_app_load_theme_with_fallback(LSAppWindow* win, const char* name, const char* variant)
+static bool load_css(LSAppWindow* win, const char* css, gssize len, const char* what)
 {
-    char path[PATH_MAX];
+    GError* gerror = NULL;
+    GtkCssProvider* style = gtk_css_provider_new();
+    gtk_css_provider_load_from_data(style, css, len, &gerror);
+    if (gerror != NULL) {
+        g_printerr("Error loading %s: %s\n", what, gerror->message);
+        g_error_free(gerror);
+        g_object_unref(style);
+        return false;
+    }
 
-    // Remove old style
+    GdkScreen* screen = gdk_display_get_default_screen(win->display);
     if (win->style) {
-        gtk_style_context_remove_provider_for_screen(
-            gdk_screen_get_default(),
-            GTK_STYLE_PROVIDER(win->style));
+        gtk_style_context_remove_provider_for_screen(screen, GTK_STYLE_PROVIDER(win->style));
         g_object_unref(win->style);
-        win->style = NULL;
     }
+    win->style = style;
+    gtk_style_context_add_provider_for_screen(
+        screen,
+        GTK_STYLE_PROVIDER(win->style),
+        GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+    return true;
+}
 
+/**
+ * Returns the path of the last good, minified copy of a theme.
+ *
+ * The copy is named after the theme file and a hash of its full path, so
+ * variants or themes of the same name in different directories don't
+ * share it.
+ *
+ * @param path The theme file.
+ * @param out_path Pointer to a string onto which the path will be copied.
+ */
+static void theme_cache_path(const char* path, char* out_path)
+{
+    char data_path[PATH_MAX];
+    char* name = g_path_get_basename(path);
+    char* hash = g_compute_checksum_for_string(G_CHECKSUM_SHA1, path, -1);
+    get_libresplit_data_folder_path(data_path);
+    snprintf(out_path, PATH_MAX, "%s/theme-cache/%.200s-%s", data_path, name, hash);
+    g_free(hash);
+    g_free(name);
+}
+
+/**
+ * Tells whether a file was modified after another one.
+ *
+ * @param a The status of the first file.
+ * @param b The status of the second file.
+ *
+ * @return true if the first file is newer.
+ */
+static bool newer(const struct stat* a, const struct stat* b)
+{
+    if (a->st_mtim.tv_sec != b->st_mtim.tv_sec) {
+        return a->st_mtim.tv_sec > b->st_mtim.tv_sec;
+    }
+    return a->st_mtim.tv_nsec > b->st_mtim.tv_nsec;
+}
+
+/**
+ * Loads a theme file, through its minified copy when it's up to date.
+ *
+ * If the theme doesn't parse, its last good version is loaded instead.
+ * Themes importing other files aren't cached, since the copy couldn't
+ * tell when those change.
+ *
+ * @param win The LibreSplit window.
+ * @param path The theme file.
+ *
+ * @return true if a version of the theme was loaded.
+ */
+static bool load_theme_file(LSAppWindow* win, const char* path)
+{
+    char cache_path[PATH_MAX];
+    struct stat theme_st, cache_st;
+    char* css = NULL;
+    bool loaded = false;
+
+    theme_cache_path(path, cache_path);
+    const bool cached = stat(cache_path, &cache_st) == 0;
+    if (stat(path, &theme_st) == 0 && cached && newer(&cache_st, &theme_st)
+        && g_file_get_contents(cache_path, &css, NULL, NULL)) {
+        loaded = load_css(win, css, -1, "cached theme CSS");
+        g_free(css);
+        css = NULL;
+        if (loaded) {
+            return true;
+        }
+    }
+
+    if (g_file_get_contents(path, &css, NULL, NULL)) {
+        bool imports;
+        char* dir = g_path_get_dirname(path);
+        char* minified = css_minify(css, dir, &imports);
+        loaded = load_css(win, minified, -1, "custom theme CSS");
+        if (imports) {
+            // An older copy would be taken as up to date
+            remove(cache_path);
+        } else if (loaded && !g_file_set_contents(cache_path, minified, -1, NULL)) {
+            printf("Cannot save the minified theme to %s\n", cache_path);
+        }
+        g_free(minified);
+        g_free(dir);
+        g_free(css);
+        css = NULL;
+    }
+
+    if (!loaded && cached && g_file_get_contents(cache_path, &css, NULL, NULL)) {
+        loaded = load_css(win, css, -1, "last good theme CSS");
+        if (loaded) {
+            printf("Using the last good version of the theme\n");
+        }
+        g_free(css);
+    }
+    return loaded;
+}
+
+/**
+ * Reloads the theme once its file stopped changing.
+ *
+ * @param data The LibreSplit window.
+ */
+static gboolean reload_theme(gpointer data)
+{
+    LSAppWindow* win = data;
+    win->theme_reload = 0;
+    // On failure the current version stays, no need to fall back
+    load_theme_file(win, win->theme_path);
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * Schedules a reload when the theme file changes.
+ *
+ * @param monitor The file monitor.
+ * @param file The theme file.
+ * @param other_file Unused.
+ * @param event What happened to the file.
+ * @param data The LibreSplit window.
+ */
+static void theme_changed(GFileMonitor* monitor, GFile* file, GFile* other_file,
+    GFileMonitorEvent event, gpointer data)
+{
+    LSAppWindow* win = data;
+    if (event != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT && event != G_FILE_MONITOR_EVENT_CREATED) {
+        return;
+    }
+    // Editors may write a file in several steps, wait for them to be done.
+    // The low priority keeps the reload behind the timer updates.
+    if (win->theme_reload) {
+        g_source_remove(win->theme_reload);
+    }
+    win->theme_reload = g_timeout_add_full(G_PRIORITY_LOW, THEME_RELOAD_DELAY, reload_theme, win, NULL);
+}
+
+/**
+ * Stops watching the theme file.
+ *
+ * @param win The LibreSplit window.
+ */
+void ls_app_window_unwatch_theme(LSAppWindow* win)
+{
+    if (win->theme_reload) {
+        g_source_remove(win->theme_reload);
+        win->theme_reload = 0;
+    }
+    if (win->theme_monitor) {
+        g_signal_handlers_disconnect_by_data(win->theme_monitor, win);
+        g_file_monitor_cancel(win->theme_monitor);
+        g_object_unref(win->theme_monitor);
+        win->theme_monitor = NULL;
+    }
+    win->theme_path[0] = '\0';
+}
+
+/**
+ * Watches a theme file, to reload it when it changes.
+ *
+ * @param win The LibreSplit window.
+ * @param path The theme file.
+ */
+static void watch_theme(LSAppWindow* win, const char* path)
+{
+    GError* gerror = NULL;
+    ls_app_window_unwatch_theme(win);
+    GFile* file = g_file_new_for_path(path);
+    win->theme_monitor = g_file_monitor_file(file, G_FILE_MONITOR_NONE, NULL, &gerror);
+    g_object_unref(file);
+    if (!win->theme_monitor) {
+        g_printerr("Cannot watch the theme for changes: %s\n", gerror->message);
+        g_error_free(gerror);
+        return;
+    }
+    strcpy(win->theme_path, path);
+    g_signal_connect(win->theme_monitor, "changed", G_CALLBACK(theme_changed), win);
+}
+
+/**
+ * Loads a specific theme, with a fallback to the default theme
+ *
+ * The theme is then watched, and reloaded when it changes.
+ *
+ * @param win The LibreSplit window.
+ * @param name The name of the theme to load.
+ * @param variant The variant of the theme to load.
+ */
+void ls_app_load_theme_with_fallback(LSAppWindow* win, const char* name, const char* variant)
+{
+    char path[PATH_MAX];
     GError* gerror = NULL;
 
     // If reset rules have never been loaded, create them
@@ -109,49 +423,19 @@ void ls_app_load_theme_with_fallback(LSAppWindow* win, const char* name, const c
         }
     }
 
-    if (!win->style) {
-        win->style = gtk_css_provider_new();
-    }
-
     const bool found = ls_app_window_find_theme(win, name, variant, path);
-    bool error = false;
 
     if (!found) {
         printf("Theme not found: \"%s\" (variant: \"%s\")\n", name ? name : "", variant ? variant : "");
+    } else if (win->theme_monitor && strcmp(path, win->theme_path) == 0) {
+        // Already loaded, and reloaded whenever it changed
+        return;
+    } else if (load_theme_file(win, path)) {
+        watch_theme(win, path);
+        return;
     }
 
-    if (found) {
-        GdkScreen* screen = gdk_display_get_default_screen(win->display);
-        gtk_style_context_add_provider_for_screen(
-            screen,
-            GTK_STYLE_PROVIDER(win->style),
-            GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
-        gtk_css_provider_load_from_path(
-            GTK_CSS_PROVIDER(win->style),
-            path, &gerror);
-        if (gerror != NULL) {
-            g_printerr("Error loading custom theme CSS: %s\n", gerror->message);
-            error = true;
-            g_error_free(gerror);
-            gerror = NULL;
-        }
-    }
-
-    if (!found || error) {
-        // Load default theme from embedded CSS as fallback
-        GdkScreen* screen = gdk_display_get_default_screen(win->display);
-        gtk_style_context_add_provider_for_screen(
-            screen,
-            GTK_STYLE_PROVIDER(win->style),
-            GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
-        gtk_css_provider_load_from_data(
-            GTK_CSS_PROVIDER(win->style),
-            (const char*)fallback_css_data(),
-            (gssize)fallback_css_data_len(), &gerror);
-        if (gerror != NULL) {
-            g_printerr("Error loading default theme CSS: %s\n", gerror->message);
-            g_error_free(gerror);
-            gerror = NULL;
-        }
-    }
+    // Load default theme from embedded CSS as fallback
+    ls_app_window_unwatch_theme(win);
+    load_css(win, (const char*)fallback_css_data(), (gssize)fallback_css_data_len(), "default theme CSS");
 }
@@ -14,6 +14,7 @@ void timer_stop_and_reset(LSAppWindow* win)
     if (!win->timer)
         return;
 
+    ls_app_window_wake(win);
     if (win->timer->running) {
         ls_timer_stop(win->timer);
     }
@@ -42,6 +43,7 @@ void timer_start_split(LSAppWindow* win)
     if (!win->timer)
         return;
 
+    ls_app_window_wake(win);
     if (!win->timer->started) { // To start again a reset needs to happen
         if (ls_timer_start(win->timer)) {
             save_game(win->game);
@@ -68,6 +70,7 @@ void timer_start(LSAppWindow* win)
     if (!win->timer)
         return;
 
+    ls_app_window_wake(win);
     if (win->timer->running)
         return; // Timer is already running, do nothing
 
@@ -93,11 +96,12 @@ void timer_stop_or_reset(LSAppWindow* win)
     if (!win->timer)
         return;
 
+    ls_app_window_wake(win);
     if (win->timer->running) {
         ls_timer_stop(win->timer);
     } else {
-        // Restart LASR on reset
-        restart_auto_splitter();
+        // Get LASR ready for the next attempt
+        reset_auto_splitter();
 
         if (ls_timer_reset(win->timer)) {
             ls_app_window_clear_game(win);
@@ -125,6 +129,7 @@ void timer_cancel_run(LSAppWindow* win)
     if (!win->timer)
         return;
 
+    ls_app_window_wake(win);
     if (ls_timer_cancel(win->timer)) {
         ls_app_window_clear_game(win);
         ls_app_window_show_game(win);
@@ -149,6 +154,7 @@ void timer_skip(LSAppWindow* win)
     if (!win->timer)
         return;
 
+    ls_app_window_wake(win);
     ls_timer_skip(win->timer);
     for (GList* l = win->components; l != NULL; l = l->next) {
         LSComponent* component = l->data;
@@ -168,6 +174,7 @@ void timer_unsplit(LSAppWindow* win)
     if (!win->timer)
         return;
 
+    ls_app_window_wake(win);
     ls_timer_unsplit(win->timer);
 
     for (GList* l = win->components; l != NULL; l = l->next) {
@@ -188,6 +195,7 @@ void timer_split(LSAppWindow* win)
     if (!win->timer)
         return;
 
+    ls_app_window_wake(win);
     ls_timer_split(win->timer);
 
     for (GList* l = win->components; l != NULL; l = l->next) {
@@ -208,8 +216,24 @@ void timer_pause(LSAppWindow* win)
     if (!win->timer)
         return;
 
+    ls_app_window_wake(win);
+    timer_pause_at(win, ls_timer_now(win->timer));
+}
+
+/**
+ * Pauses the timer into a paused/loading state, since a given time
+ *
+ * @param win The LibreSplit window
+ * @param time When the load started, according to the timer clock
+ */
+void timer_pause_at(LSAppWindow* win, long long time)
+{
+    if (!win->timer)
+        return;
+
+    ls_app_window_wake(win);
     if (win->timer->running) {
-        ls_timer_pause(win->timer);
+        ls_timer_pause_at(win->timer, time);
     }
 
     for (GList* l = win->components; l != NULL; l = l->next) {
@@ -230,8 +254,24 @@ void timer_unpause(LSAppWindow* win)
     if (!win->timer)
         return;
 
+    ls_app_window_wake(win);
+    timer_unpause_at(win, ls_timer_now(win->timer));
+}
+
+/**
+ * Resumes the timer from a paused/loading state, since a given time
+ *
+ * @param win The LibreSplit window
+ * @param time When the load ended, according to the timer clock
+ */
+void timer_unpause_at(LSAppWindow* win, long long time)
+{
+    if (!win->timer)
+        return;
+
+    ls_app_window_wake(win);
     if (win->timer->running) {
-        ls_timer_unpause(win->timer);
+        ls_timer_unpause_at(win->timer, time);
     }
 
     for (GList* l = win->components; l != NULL; l = l->next) {
@@ -252,6 +292,7 @@ void timer_stop(LSAppWindow* win)
     if (!win->timer)
         return;
 
+    ls_app_window_wake(win);
     if (win->timer->running) {
         ls_timer_stop(win->timer);
     }
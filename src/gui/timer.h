@@ -9,5 +9,7 @@ void timer_unsplit(LSAppWindow* win);
 void timer_skip(LSAppWindow* win);
 void timer_pause(LSAppWindow* win);
 void timer_unpause(LSAppWindow* win);
+void timer_pause_at(LSAppWindow* win, long long time);
+void timer_unpause_at(LSAppWindow* win, long long time);
 void timer_stop(LSAppWindow* win);
 void timer_split(LSAppWindow* win);
@@ -1,4 +1,6 @@
 #include <gtk/gtk.h>
+#include <stdbool.h>
+#include <string.h>
 
 /**
  * Adds a styling class to a GTK Widget.
@@ -21,3 +23,42 @@ void remove_class(GtkWidget* widget, const char* class)
 {
     gtk_style_context_remove_class(gtk_widget_get_style_context(widget), class);
 }
+
+/**
+ * Adds or removes a styling class from a GTK Widget,
+ * only touching the widget if the class actually changes.
+ *
+ * Restyling is expensive, so adding and removing the same class
+ * on every frame must be avoided.
+ *
+ * @param widget The widget to change
+ * @param class The class to add or remove
+ * @param enabled Whether the widget should have the class
+ */
+void set_class(GtkWidget* widget, const char* class, bool enabled)
+{
+    GtkStyleContext* context = gtk_widget_get_style_context(widget);
+    const bool has_class = gtk_style_context_has_class(context, class);
+    if (has_class != enabled) {
+        if (enabled) {
+            gtk_style_context_add_class(context, class);
+        } else {
+            gtk_style_context_remove_class(context, class);
+        }
+    }
+}
+
+/**
+ * Sets the text of a GTK Label, only if it actually changes.
+ *
+ * Setting the text queues a relayout, even when it's the same.
+ *
+ * @param label The label to change
+ * @param text The new text
+ */
+void set_label_text(GtkWidget* label, const char* text)
+{
+    if (strcmp(gtk_label_get_text(GTK_LABEL(label)), text) != 0) {
+        gtk_label_set_text(GTK_LABEL(label), text);
+    }
+}
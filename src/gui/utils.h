@@ -1,7 +1,12 @@
 #pragma once
 
 #include <gtk/gtk.h>
+#include <stdbool.h>
 
 void add_class(GtkWidget* widget, const char* class);
 
 void remove_class(GtkWidget* widget, const char* class);
+
+void set_class(GtkWidget* widget, const char* class, bool enabled);
+
+void set_label_text(GtkWidget* label, const char* text);
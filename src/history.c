@@ -0,0 +1,558 @@
+/** \file history.c
+ * Run history store.
+ *
+ * Every split file gets its own append-only history file holding compact
+ * binary records of the runs, plus an index file made of fixed size entries
+ * (date, completion state, final time and where the run record is). Saving a
+ * run appends one record and one index entry, querying the history maps the
+ * index, so neither depends on how many runs were saved before.
+ *
+ * Both files live in the runs subdirectory, named after the split file and a
+ * hash of its path: runs/<split file name>-<hash>.lsh and .lsi.
+ */
+#include "history.h"
+#include "logging.h"
+#include "settings/utils.h"
+#include "timer.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <jansson.h>
+#include <libgen.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Hashes a string with 64 bit FNV-1a.
+ *
+ * @param string The string to hash.
+ *
+ * @return The hash.
+ */
+static uint64_t fnv1a(const char* string)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char* c = string; *c; c++) {
+        hash ^= (unsigned char)*c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * Builds the paths of the history and index files of a split file.
+ *
+ * @param split_file The path of the split file.
+ * @param history_path Where to copy the history file path, PATH_MAX long.
+ * @param index_path Where to copy the index file path, PATH_MAX long.
+ */
+void ls_history_paths(const char* split_file, char* history_path, char* index_path)
+{
+    char real_path[PATH_MAX];
+    char base_name[PATH_MAX];
+    char runs_path[PATH_MAX];
+
+    // Different paths to the same file must share the history
+    if (!realpath(split_file, real_path)) {
+        strncpy(real_path, split_file, sizeof(real_path) - 1);
+        real_path[sizeof(real_path) - 1] = '\0';
+    }
+    strcpy(base_name, real_path);
+    char* name = basename(base_name);
+    char* extension = strrchr(name, '.');
+    if (extension && extension != name) {
+        *extension = '\0';
+    }
+
+    get_libresplit_folder_path(runs_path);
+    strncat(runs_path, "/runs", sizeof(runs_path) - strlen(runs_path) - 1);
+
+    const uint64_t hash = fnv1a(real_path);
+    snprintf(history_path, PATH_MAX, "%s/%.200s-%016llx.lsh", runs_path, name, (unsigned long long)hash);
+    snprintf(index_path, PATH_MAX, "%s/%.200s-%016llx.lsi", runs_path, name, (unsigned long long)hash);
+}
+
+/**
+ * Allocates an empty run, with room for its split and segment times.
+ *
+ * @param split_count The number of splits of the run.
+ *
+ * @return The run, to be freed with ls_history_run_free, or NULL on error.
+ */
+ls_history_run* ls_history_run_new(unsigned int split_count)
+{
+    // A single allocation for the run and both arrays
+    ls_history_run* run = calloc(1, sizeof(ls_history_run) + 2 * split_count * sizeof(long long));
+    if (!run) {
+        return NULL;
+    }
+    run->header.magic = LS_HISTORY_RECORD_MAGIC;
+    run->header.split_count = split_count;
+    run->split_times = (long long*)(run + 1);
+    run->segment_times = run->split_times + split_count;
+    return run;
+}
+
+/**
+ * Frees a run.
+ *
+ * @param run The run to free.
+ */
+void ls_history_run_free(ls_history_run* run)
+{
+    free(run);
+}
+
+/**
+ * Opens a history or index file, writing its header if it's new.
+ *
+ * @param path The file path.
+ * @param magic The magic number the file must start with.
+ *
+ * @return The file descriptor, or -1 on error.
+ */
+static int open_store(const char* path, uint32_t magic)
+{
+    const int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        return -1;
+    }
+    ls_history_file_header header;
+    const ssize_t read_size = pread(fd, &header, sizeof(header), 0);
+    if (read_size == 0) {
+        header.magic = magic;
+        header.version = LS_HISTORY_VERSION;
+        if (pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) {
+            close(fd);
+            return -1;
+        }
+    } else if (read_size != sizeof(header) || header.magic != magic || header.version != LS_HISTORY_VERSION) {
+        LOG_ERRF("%s is not a valid LibreSplit history file", path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Appends a run to the history of a split file.
+ *
+ * Writes the run record first and its index entry last, so a run
+ * only becomes visible once it's completely on disk.
+ *
+ * @param split_file The path of the split file the run belongs to.
+ * @param run The run to append.
+ * @param position Where to store the position of the run in the history, may be NULL.
+ *
+ * @return Zero on success, non-zero otherwise.
+ */
+int ls_history_append(const char* split_file, const ls_history_run* run, size_t* position)
+{
+    char history_path[PATH_MAX];
+    char index_path[PATH_MAX];
+    struct stat st;
+    int error = 0;
+
+    ls_history_paths(split_file, history_path, index_path);
+    const int history_fd = open_store(history_path, LS_HISTORY_MAGIC);
+    const int index_fd = open_store(index_path, LS_HISTORY_INDEX_MAGIC);
+    if (history_fd == -1 || index_fd == -1) {
+        error = 1;
+        goto history_append_error;
+    }
+
+    // Append the record
+    if (fstat(history_fd, &st) == -1) {
+        error = 1;
+        goto history_append_error;
+    }
+    const off_t offset = st.st_size;
+    const size_t times_size = run->header.split_count * sizeof(long long);
+    if (pwrite(history_fd, &run->header, sizeof(run->header), offset) != sizeof(run->header)
+        || pwrite(history_fd, run->split_times, times_size, offset + sizeof(run->header)) != (ssize_t)times_size
+        || pwrite(history_fd, run->segment_times, times_size, offset + sizeof(run->header) + times_size) != (ssize_t)times_size
+        || fdatasync(history_fd) == -1) {
+        error = 1;
+        goto history_append_error;
+    }
+
+    // Then index it, overwriting any entry torn by a crash
+    if (fstat(index_fd, &st) == -1) {
+        error = 1;
+        goto history_append_error;
+    }
+    const size_t count = (st.st_size - sizeof(ls_history_file_header)) / sizeof(ls_history_index_entry);
+    const ls_history_index_entry entry = {
+        .offset = offset,
+        .date = run->header.date,
+        .final_time = run->header.final_time,
+        .flags = run->header.flags,
+        .splits_reached = run->header.splits_reached,
+    };
+    const off_t entry_offset = sizeof(ls_history_file_header) + count * sizeof(entry);
+    if (pwrite(index_fd, &entry, sizeof(entry), entry_offset) != sizeof(entry)
+        || ftruncate(index_fd, entry_offset + sizeof(entry)) == -1
+        || fdatasync(index_fd) == -1) {
+        error = 1;
+        goto history_append_error;
+    }
+    if (position) {
+        *position = count;
+    }
+
+history_append_error:
+    if (error) {
+        LOG_ERRF("Cannot append run to %s", history_path);
+    }
+    if (history_fd != -1) {
+        close(history_fd);
+    }
+    if (index_fd != -1) {
+        close(index_fd);
+    }
+    return error;
+}
+
+/**
+ * Opens the history of a split file for reading.
+ *
+ * @param history The history to initialize.
+ * @param split_file The path of the split file.
+ *
+ * @return Zero on success (an empty history if there is none yet), non-zero otherwise.
+ */
+int ls_history_open(ls_history* history, const char* split_file)
+{
+    char history_path[PATH_MAX];
+    char index_path[PATH_MAX];
+    struct stat st;
+
+    memset(history, 0, sizeof(ls_history));
+    history->fd = -1;
+
+    ls_history_paths(split_file, history_path, index_path);
+    const int index_fd = open(index_path, O_RDONLY | O_CLOEXEC);
+    if (index_fd == -1) {
+        // No runs saved yet
+        return 0;
+    }
+    history->fd = open(history_path, O_RDONLY | O_CLOEXEC);
+    if (history->fd == -1 || fstat(index_fd, &st) == -1) {
+        close(index_fd);
+        ls_history_close(history);
+        return 1;
+    }
+    // Records are written before their index entries, so this covers every indexed run
+    struct stat history_st;
+    if (fstat(history->fd, &history_st) == -1) {
+        close(index_fd);
+        ls_history_close(history);
+        return 1;
+    }
+    history->size = history_st.st_size;
+
+    if ((size_t)st.st_size > sizeof(ls_history_file_header)) {
+        history->map_size = st.st_size;
+        history->map = mmap(NULL, history->map_size, PROT_READ, MAP_SHARED, index_fd, 0);
+        if (history->map == MAP_FAILED) {
+            history->map = NULL;
+            close(index_fd);
+            ls_history_close(history);
+            return 1;
+        }
+        const ls_history_file_header* header = history->map;
+        if (header->magic == LS_HISTORY_INDEX_MAGIC && header->version == LS_HISTORY_VERSION) {
+            history->entries = (const ls_history_index_entry*)(header + 1);
+            history->count = (st.st_size - sizeof(ls_history_file_header)) / sizeof(ls_history_index_entry);
+        }
+    }
+    close(index_fd);
+    return 0;
+}
+
+/**
+ * Closes a history opened with ls_history_open.
+ *
+ * @param history The history to close.
+ */
+void ls_history_close(ls_history* history)
+{
+    if (history->map) {
+        munmap(history->map, history->map_size);
+    }
+    if (history->fd != -1) {
+        close(history->fd);
+    }
+    memset(history, 0, sizeof(ls_history));
+    history->fd = -1;
+}
+
+/**
+ * Finds the first run that ended at or after a date.
+ *
+ * Runs are appended in chronological order, so this is a binary search.
+ *
+ * @param history The history to search.
+ * @param date The date, in seconds since the epoch.
+ *
+ * @return The index of the run, or the number of runs if there is none.
+ */
+size_t ls_history_find_date(const ls_history* history, time_t date)
+{
+    size_t low = 0;
+    size_t high = history->count;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (history->entries[mid].date < date) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * Reads a complete run from the history.
+ *
+ * The record must fit before the next one (or the end of the file) and
+ * agree with its index entry, so a corrupted split count can't make it
+ * read past the record.
+ *
+ * @param history The history to read from.
+ * @param index The index of the run, 0 being the oldest.
+ * @param split_count The number of splits of the split file, runs saved
+ * with another number of splits are skipped.
+ *
+ * @return The run, to be freed with ls_history_run_free, or NULL on error
+ * or if it has another number of splits.
+ */
+ls_history_run* ls_history_read_run(const ls_history* history, size_t index, unsigned int split_count)
+{
+    ls_history_record_header header;
+    if (index >= history->count) {
+        return NULL;
+    }
+    const ls_history_index_entry* entry = &history->entries[index];
+    const uint64_t offset = entry->offset;
+    // A crash may have left a torn record between two indexed ones
+    uint64_t end = history->size;
+    if (index + 1 < history->count && history->entries[index + 1].offset > offset
+        && history->entries[index + 1].offset < end) {
+        end = history->entries[index + 1].offset;
+    }
+    if (offset < sizeof(ls_history_file_header) || offset + sizeof(header) > end
+        || pread(history->fd, &header, sizeof(header), offset) != sizeof(header)
+        || header.magic != LS_HISTORY_RECORD_MAGIC
+        || offset + sizeof(header) + 2 * (uint64_t)header.split_count * sizeof(long long) > end
+        || header.splits_reached > header.split_count
+        || header.date != entry->date || header.final_time != entry->final_time
+        || header.flags != entry->flags || header.splits_reached != entry->splits_reached) {
+        LOG_ERRF("Corrupted run record %zu in history", index);
+        return NULL;
+    }
+    if (header.split_count != split_count) {
+        // The split file changed since the run was saved
+        return NULL;
+    }
+
+    ls_history_run* run = ls_history_run_new(header.split_count);
+    if (!run) {
+        return NULL;
+    }
+    run->header = header;
+    const ssize_t times_size = 2 * header.split_count * sizeof(long long);
+    if (pread(history->fd, run->split_times, times_size, offset + sizeof(header)) != times_size) {
+        ls_history_run_free(run);
+        return NULL;
+    }
+    return run;
+}
+
+/**
+ * Compares two directory entries by name, used to sort the legacy
+ * run files by date.
+ */
+static int compare_names(const void* a, const void* b)
+{
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+/**
+ * Compares two strings that may be missing.
+ *
+ * @param a The first string, may be NULL.
+ * @param b The second string, may be NULL.
+ *
+ * @return True if both are missing or equal.
+ */
+static bool same_string(const char* a, const char* b)
+{
+    return (!a && !b) || (a && b && strcmp(a, b) == 0);
+}
+
+/**
+ * Converts a legacy JSON run file into a history run.
+ *
+ * @param json The legacy run.
+ * @param game_splits The splits array of the split file.
+ * @param date When the run ended.
+ *
+ * @return The run, or NULL if its splits aren't the ones of the split file.
+ */
+static ls_history_run* run_from_json(json_t* json, json_t* game_splits, time_t date)
+{
+    json_t* splits = json_object_get(json, "splits");
+    const unsigned int split_count = json_array_size(game_splits);
+    if (!json_is_array(splits) || json_array_size(splits) != split_count) {
+        return NULL;
+    }
+    // Other split files of the same game may have as many splits
+    for (unsigned int i = 0; i < split_count; ++i) {
+        if (!same_string(json_string_value(json_object_get(json_array_get(splits, i), "title")),
+                json_string_value(json_object_get(json_array_get(game_splits, i), "title")))) {
+            return NULL;
+        }
+    }
+    ls_history_run* run = ls_history_run_new(split_count);
+    if (!run) {
+        return NULL;
+    }
+    run->header.date = date;
+    run->header.final_time = ls_time_value(json_string_value(json_object_get(json, "final_time")));
+    const char* reason = json_string_value(json_object_get(json, "reason"));
+    if (reason && strcmp(reason, "FINISHED") == 0) {
+        run->header.flags |= LS_HISTORY_COMPLETED;
+    }
+    for (unsigned int i = 0; i < split_count; ++i) {
+        json_t* split = json_array_get(splits, i);
+        // Only reached splits have a time key, even if null
+        if (json_object_get(split, "time")) {
+            run->header.splits_reached = i + 1;
+        }
+        run->split_times[i] = ls_time_value(json_string_value(json_object_get(split, "time")));
+        run->segment_times[i] = ls_time_value(json_string_value(json_object_get(split, "segment")));
+    }
+    return run;
+}
+
+/**
+ * Imports the legacy runs/run_*.json files of a split file into its history.
+ *
+ * Only done when the split file has no history yet. Legacy files don't say
+ * which split file they belong to, so runs are matched by game title and
+ * split titles. Imported files are moved to runs/migrated. The history is
+ * created even if no run matched, so the legacy files are only looked at
+ * the first time a split file is opened.
+ *
+ * @param split_file The path of the split file.
+ *
+ * @return The number of imported runs, -1 on error.
+ */
+int ls_history_migrate(const char* split_file)
+{
+    char history_path[PATH_MAX];
+    char index_path[PATH_MAX];
+    char runs_path[PATH_MAX];
+    char migrated_path[PATH_MAX];
+    struct stat st;
+    int imported = 0;
+
+    ls_history_paths(split_file, history_path, index_path);
+    if (stat(index_path, &st) == 0) {
+        // Already has a history
+        return 0;
+    }
+
+    json_t* game = json_load_file(split_file, 0, NULL);
+    if (!game) {
+        return -1;
+    }
+    const char* title = json_string_value(json_object_get(game, "title"));
+    json_t* game_splits = json_object_get(game, "splits");
+
+    get_libresplit_folder_path(runs_path);
+    strncat(runs_path, "/runs", sizeof(runs_path) - strlen(runs_path) - 1);
+    snprintf(migrated_path, sizeof(migrated_path), "%s/migrated", runs_path);
+
+    // Collect the legacy files, their names sort chronologically
+    DIR* dir = opendir(runs_path);
+    char** names = NULL;
+    size_t name_count = 0;
+    struct dirent* entry;
+    while (dir && (entry = readdir(dir)) != NULL) {
+        const size_t length = strlen(entry->d_name);
+        if (strncmp(entry->d_name, "run_", 4) != 0 || length < 5 || strcmp(entry->d_name + length - 5, ".json") != 0) {
+            continue;
+        }
+        char** grown = realloc(names, (name_count + 1) * sizeof(char*));
+        if (!grown) {
+            break;
+        }
+        names = grown;
+        names[name_count] = strdup(entry->d_name);
+        if (names[name_count]) {
+            name_count++;
+        }
+    }
+    if (dir) {
+        closedir(dir);
+    }
+    if (name_count) {
+        qsort(names, name_count, sizeof(char*), compare_names);
+    }
+
+    for (size_t i = 0; i < name_count; ++i) {
+        char path[PATH_MAX];
+        char new_path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", runs_path, names[i]);
+
+        json_t* json = json_load_file(path, 0, NULL);
+        const char* run_title = json ? json_string_value(json_object_get(json, "title")) : NULL;
+        if (json && same_string(title, run_title)) {
+            struct tm tm = { 0 };
+            time_t date = 0;
+            if (sscanf(names[i], "run_%d-%d-%d_%d-%d-%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec) == 6) {
+                tm.tm_year -= 1900;
+                tm.tm_mon -= 1;
+                tm.tm_isdst = -1;
+                date = mktime(&tm);
+            } else if (stat(path, &st) == 0) {
+                date = st.st_mtime;
+            }
+            ls_history_run* run = run_from_json(json, game_splits, date);
+            if (run && ls_history_append(split_file, run, NULL) == 0) {
+                mkdir(migrated_path, 0755);
+                snprintf(new_path, sizeof(new_path), "%s/%s", migrated_path, names[i]);
+                rename(path, new_path);
+                imported++;
+            }
+            ls_history_run_free(run);
+        }
+        if (json) {
+            json_decref(json);
+        }
+        free(names[i]);
+    }
+    free(names);
+    json_decref(game);
+
+    // Create the history even if no run matched, it marks the split file as migrated
+    const int history_fd = open_store(history_path, LS_HISTORY_MAGIC);
+    const int index_fd = open_store(index_path, LS_HISTORY_INDEX_MAGIC);
+    if (history_fd != -1) {
+        close(history_fd);
+    }
+    if (index_fd != -1) {
+        close(index_fd);
+    }
+
+    if (imported) {
+        LOG_DEBUGF("Imported %d legacy runs into %s", imported, history_path);
+    }
+    return imported;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <linux/limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#define LS_HISTORY_MAGIC 0x4C534853 /*!< "LSHS", history file */
+#define LS_HISTORY_INDEX_MAGIC 0x4C534849 /*!< "LSHI", index file */
+#define LS_HISTORY_RECORD_MAGIC 0x4C535252 /*!< "LSRR", marks every run record */
+#define LS_HISTORY_VERSION 1
+
+#define LS_HISTORY_COMPLETED (1 << 0) /*!< The run reached the last split */
+
+/**
+ * @brief Header of both the history and the index files.
+ */
+typedef struct ls_history_file_header {
+    uint32_t magic; /*!< LS_HISTORY_MAGIC or LS_HISTORY_INDEX_MAGIC */
+    uint32_t version; /*!< LS_HISTORY_VERSION */
+} ls_history_file_header;
+
+/**
+ * @brief A fixed size entry of the index, one per run.
+ */
+typedef struct ls_history_index_entry {
+    uint64_t offset; /*!< Offset of the run record in the history file */
+    int64_t date; /*!< When the run ended, in seconds since the epoch */
+    int64_t final_time; /*!< Final (load removed) time of the run */
+    uint32_t flags; /*!< LS_HISTORY_* flags */
+    uint32_t splits_reached; /*!< Number of splits done before the run ended */
+} ls_history_index_entry;
+
+/**
+ * @brief Header of a run record in the history file.
+ * Followed by split_count split times, then split_count segment times.
+ */
+typedef struct ls_history_record_header {
+    uint32_t magic; /*!< Always LS_HISTORY_RECORD_MAGIC */
+    uint32_t split_count; /*!< Number of splits of the run */
+    int64_t date; /*!< When the run ended, in seconds since the epoch */
+    int64_t final_time; /*!< Final (load removed) time of the run */
+    uint32_t flags; /*!< LS_HISTORY_* flags */
+    uint32_t splits_reached; /*!< Number of splits done before the run ended */
+} ls_history_record_header;
+
+/**
+ * @brief A single run, as stored in the history.
+ */
+typedef struct ls_history_run {
+    ls_history_record_header header; /*!< Summary of the run */
+    long long* split_times; /*!< Split times, 0 if the split was skipped or not reached */
+    long long* segment_times; /*!< Segment times, 0 if unknown */
+} ls_history_run;
+
+/**
+ * @brief A read-only view over the history of a split file.
+ * Runs appended after opening it are not visible.
+ */
+typedef struct ls_history {
+    int fd; /*!< The history file */
+    uint64_t size; /*!< Size of the history file when it was opened */
+    const ls_history_index_entry* entries; /*!< The mapped index entries */
+    size_t count; /*!< Number of runs in the history */
+    size_t map_size; /*!< Size of the index mapping */
+    void* map; /*!< The index mapping */
+} ls_history;
+
+void ls_history_paths(const char* split_file, char* history_path, char* index_path);
+
+ls_history_run* ls_history_run_new(unsigned int split_count);
+void ls_history_run_free(ls_history_run* run);
+
+int ls_history_append(const char* split_file, const ls_history_run* run, size_t* position);
+int ls_history_migrate(const char* split_file);
+
+int ls_history_open(ls_history* history, const char* split_file);
+void ls_history_close(ls_history* history);
+size_t ls_history_find_date(const ls_history* history, time_t date);
+ls_history_run* ls_history_read_run(const ls_history* history, size_t index, unsigned int split_count);
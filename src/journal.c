@@ -0,0 +1,284 @@
+/** \file journal.c
+ * Crash-safe journal of the run in progress.
+ *
+ * Timer events are appended to a memory-mapped file in the data folder, so
+ * recording them costs a handful of stores into the page cache. The kernel
+ * writes the pages back on its own and even if LibreSplit crashes, the data
+ * is already in the page cache. A periodic asynchronous msync makes sure the
+ * journal also survives a machine crash without ever blocking the caller.
+ *
+ * The file is sized for a whole run when it's opened, and only grown from
+ * the heartbeat, so recording an event never makes a system call.
+ */
+#include "journal.h"
+#include "logging.h"
+#include "settings/utils.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define JOURNAL_INITIAL_CAPACITY 4096 /*!< Records that fit in a new journal file */
+#define JOURNAL_SYNC_INTERVAL 1000000 /*!< Microseconds between two heartbeat syncs */
+
+static int journal_fd = -1; /*!< File descriptor of the journal file */
+static LSJournalHeader* journal = NULL; /*!< The mapped journal file */
+static size_t journal_size = 0; /*!< Size of the mapping, in bytes */
+static int64_t last_sync = 0; /*!< Monotonic time of the last heartbeat sync */
+static bool journal_full = false; /*!< Whether an event was dropped since the journal last grew */
+
+/**
+ * Returns the size of a journal file able to contain some records.
+ *
+ * @param capacity The number of records.
+ *
+ * @return The file size, in bytes.
+ */
+static size_t journal_file_size(uint64_t capacity)
+{
+    return sizeof(LSJournalHeader) + capacity * sizeof(LSJournalRecord);
+}
+
+/**
+ * Returns the current wall clock time, used to know how long
+ * LibreSplit was down before restoring a run.
+ *
+ * @return The current time since the epoch, in microseconds.
+ */
+int64_t ls_journal_wall_now(void)
+{
+    struct timespec timespec;
+    clock_gettime(CLOCK_REALTIME, &timespec);
+    return timespec.tv_sec * 1000000LL + timespec.tv_nsec / 1000;
+}
+
+/**
+ * Opens and maps the journal file, creating it if needed.
+ *
+ * @return Zero on success, non-zero otherwise.
+ */
+static int journal_map(void)
+{
+    if (journal) {
+        return 0;
+    }
+
+    char path[PATH_MAX];
+    struct stat st;
+    get_libresplit_data_folder_path(path);
+    strncat(path, "/run.journal", sizeof(path) - strlen(path) - 1);
+
+    journal_fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (journal_fd == -1) {
+        LOG_ERRF("Cannot open the run journal %s", path);
+        return 1;
+    }
+    if (fstat(journal_fd, &st) == -1) {
+        goto journal_map_error;
+    }
+
+    // A file too small to be valid is (re)initialized from scratch, a smaller
+    // one is extended, keeping the run it may contain
+    const bool fresh = (size_t)st.st_size < sizeof(LSJournalHeader);
+    journal_size = journal_file_size(JOURNAL_INITIAL_CAPACITY);
+    if ((size_t)st.st_size > journal_size) {
+        journal_size = st.st_size;
+    } else if ((size_t)st.st_size < journal_size && ftruncate(journal_fd, journal_size) == -1) {
+        goto journal_map_error;
+    }
+
+    journal = mmap(NULL, journal_size, PROT_READ | PROT_WRITE, MAP_SHARED, journal_fd, 0);
+    if (journal == MAP_FAILED) {
+        journal = NULL;
+        goto journal_map_error;
+    }
+
+    const uint64_t capacity = (journal_size - sizeof(LSJournalHeader)) / sizeof(LSJournalRecord);
+    if (fresh || journal->magic != LS_JOURNAL_MAGIC || journal->version != LS_JOURNAL_VERSION
+        || journal->count > capacity) {
+        memset(journal, 0, sizeof(LSJournalHeader));
+        journal->magic = LS_JOURNAL_MAGIC;
+        journal->version = LS_JOURNAL_VERSION;
+        journal->state = LS_JOURNAL_IDLE;
+    }
+    journal->capacity = capacity;
+    return 0;
+
+journal_map_error:
+    LOG_ERRF("Cannot map the run journal %s", path);
+    close(journal_fd);
+    journal_fd = -1;
+    return 1;
+}
+
+/**
+ * Doubles the capacity of the journal file.
+ *
+ * Never called while recording an event, only from the heartbeat.
+ *
+ * @return Zero on success, non-zero otherwise.
+ */
+static int journal_grow(void)
+{
+    const uint64_t capacity = journal->capacity * 2;
+    const size_t size = journal_file_size(capacity);
+    if (ftruncate(journal_fd, size) == -1) {
+        return 1;
+    }
+    void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, journal_fd, 0);
+    if (mapping == MAP_FAILED) {
+        return 1;
+    }
+    munmap(journal, journal_size);
+    journal = mapping;
+    journal_size = size;
+    journal->capacity = capacity;
+    return 0;
+}
+
+/**
+ * Starts journaling a new run, discarding any previous one.
+ *
+ * @param split_file The path of the split file being run.
+ * @param split_count The number of splits in the split file.
+ */
+void ls_journal_begin(const char* split_file, unsigned int split_count)
+{
+    if (journal_map()) {
+        return;
+    }
+    journal->count = 0;
+    journal->split_count = split_count;
+    strncpy(journal->split_file, split_file, sizeof(journal->split_file) - 1);
+    journal->split_file[sizeof(journal->split_file) - 1] = '\0';
+    memset(&journal->heartbeat, 0, sizeof(journal->heartbeat));
+    journal->state = LS_JOURNAL_RUNNING;
+}
+
+/**
+ * Appends an event to the journal of the run in progress.
+ *
+ * @param record The event to append.
+ */
+void ls_journal_record(const LSJournalRecord* record)
+{
+    if (!journal || journal->state == LS_JOURNAL_IDLE) {
+        return;
+    }
+    if (journal->count == journal->capacity) {
+        // The heartbeat grows the file long before that, unless it failed
+        if (!journal_full) {
+            LOG_ERR("Run journal is full, cannot record any more events");
+            journal_full = true;
+        }
+        return;
+    }
+    LSJournalRecord* records = (LSJournalRecord*)(journal + 1);
+    records[journal->count] = *record;
+    // Only count the record once it's fully written
+    __atomic_store_n(&journal->count, journal->count + 1, __ATOMIC_RELEASE);
+    journal->heartbeat = *record;
+}
+
+/**
+ * Updates the latest known state of the run in progress.
+ *
+ * Meant to be called on every timer step, the write-back is only scheduled
+ * once in a while, along with the recorded events. The file is grown then
+ * too, once it's three quarters full.
+ *
+ * @param record The current timer state.
+ */
+void ls_journal_heartbeat(const LSJournalRecord* record)
+{
+    if (!journal || journal->state == LS_JOURNAL_IDLE) {
+        return;
+    }
+    journal->heartbeat = *record;
+    if (record->time - last_sync >= JOURNAL_SYNC_INTERVAL) {
+        if (journal->count >= journal->capacity / 4 * 3 && journal_grow() == 0) {
+            journal_full = false;
+        }
+        msync(journal, journal_size, MS_ASYNC);
+        last_sync = record->time;
+    }
+}
+
+/**
+ * Changes the state of the journaled run.
+ *
+ * @param state The new state of the run.
+ */
+void ls_journal_set_state(LSJournalState state)
+{
+    if (!journal) {
+        return;
+    }
+    journal->state = state;
+    msync(journal, journal_size, MS_ASYNC);
+}
+
+/**
+ * Checks whether the journal contains an unfinished run for a split file.
+ *
+ * @param split_file The path of the split file.
+ * @param split_count The number of splits in the split file.
+ *
+ * @return True if there is a run that can be restored.
+ */
+bool ls_journal_pending(const char* split_file, unsigned int split_count)
+{
+    if (journal_map()) {
+        return false;
+    }
+    return journal->state == LS_JOURNAL_RUNNING
+        && journal->count > 0
+        && journal->split_count == split_count
+        && strcmp(journal->split_file, split_file) == 0;
+}
+
+/**
+ * Returns the events of the journaled run.
+ *
+ * @param count Where to store the number of events.
+ *
+ * @return The array of events, owned by the journal.
+ */
+const LSJournalRecord* ls_journal_records(size_t* count)
+{
+    if (!journal) {
+        *count = 0;
+        return NULL;
+    }
+    *count = journal->count;
+    return (const LSJournalRecord*)(journal + 1);
+}
+
+/**
+ * Returns the latest known state of the journaled run.
+ *
+ * @return The last heartbeat, owned by the journal.
+ */
+const LSJournalRecord* ls_journal_last_heartbeat(void)
+{
+    return journal ? &journal->heartbeat : NULL;
+}
+
+/**
+ * Writes back and unmaps the journal.
+ */
+void ls_journal_close(void)
+{
+    if (!journal) {
+        return;
+    }
+    msync(journal, journal_size, MS_SYNC);
+    munmap(journal, journal_size);
+    close(journal_fd);
+    journal = NULL;
+    journal_fd = -1;
+}
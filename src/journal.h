@@ -0,0 +1,57 @@
+#pragma once
+
+#include <linux/limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LS_JOURNAL_MAGIC 0x4C534A4E /*!< "LSJN" */
+#define LS_JOURNAL_VERSION 2
+
+/**
+ * @brief The state of the run recorded in the journal.
+ */
+typedef enum LSJournalState {
+    LS_JOURNAL_IDLE, /*!< No run in progress, nothing to restore */
+    LS_JOURNAL_RUNNING, /*!< A run is in progress */
+    LS_JOURNAL_FINISHED, /*!< The run reached the last split */
+} LSJournalState;
+
+/**
+ * @brief A single timer event, as stored in the journal.
+ */
+typedef struct LSJournalRecord {
+    uint32_t event; /*!< One of ls_timer_event_type */
+    uint32_t padding;
+    int64_t time; /*!< Monotonic time of the event, in microseconds */
+    int64_t value; /*!< Event argument */
+    int64_t wall; /*!< Wall clock time of the event, in microseconds */
+    int64_t game_time; /*!< Timer game time when the event happened */
+} LSJournalRecord;
+
+/**
+ * @brief The journal file header, records follow right after it.
+ */
+typedef struct LSJournalHeader {
+    uint32_t magic; /*!< Always LS_JOURNAL_MAGIC */
+    uint32_t version; /*!< Layout version, LS_JOURNAL_VERSION */
+    uint32_t state; /*!< One of LSJournalState */
+    uint32_t split_count; /*!< Number of splits of the split file, used as sanity check */
+    uint64_t count; /*!< Number of records in the journal */
+    uint64_t capacity; /*!< Number of records that fit in the file */
+    char split_file[PATH_MAX]; /*!< The split file the run belongs to */
+    LSJournalRecord heartbeat; /*!< Latest timer state, overwritten every step */
+} LSJournalHeader;
+
+void ls_journal_begin(const char* split_file, unsigned int split_count);
+void ls_journal_record(const LSJournalRecord* record);
+void ls_journal_heartbeat(const LSJournalRecord* record);
+void ls_journal_set_state(LSJournalState state);
+
+bool ls_journal_pending(const char* split_file, unsigned int split_count);
+const LSJournalRecord* ls_journal_records(size_t* count);
+const LSJournalRecord* ls_journal_last_heartbeat(void);
+
+void ls_journal_close(void);
+
+int64_t ls_journal_wall_now(void);
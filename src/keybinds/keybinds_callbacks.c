@@ -13,6 +13,7 @@ void keybind_stop_reset(const char* str, LSAppWindow* win)
     // ^ since it shows a dialog, such dialog would stop the event processing,
     // ^ locking up LibreSplit or potentially the entire DE when global_hotkeys is enabled.
     win->delayed_handlers.stop_reset = true;
+    ls_app_window_wake(win);
 }
 
 void keybind_cancel(const char* str, LSAppWindow* win)
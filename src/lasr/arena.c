@@ -0,0 +1,201 @@
+/** \file arena.c
+ *
+ * Allocator of the Lua state of the auto splitter.
+ */
+#include "arena.h"
+
+#include <lauxlib.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Finds the size class of a block.
+ *
+ * @param size The size of the block, not 0.
+ *
+ * @return The index of the free list of blocks that size, or
+ *         LASR_ARENA_CLASSES if the block is too big for the arena.
+ */
+static size_t size_class(size_t size)
+{
+    const size_t index = (size - 1) / LASR_ARENA_GRANULE;
+    return index < LASR_ARENA_CLASSES ? index : LASR_ARENA_CLASSES;
+}
+
+/**
+ * Takes a small block from the arena.
+ *
+ * @param arena The arena.
+ * @param index The size class of the block.
+ *
+ * @return The block, NULL if out of memory.
+ */
+static void* arena_take(lasr_arena* arena, size_t index)
+{
+    void* block = arena->free[index];
+    if (block) {
+        memcpy(&arena->free[index], block, sizeof(void*));
+        return block;
+    }
+
+    const size_t size = (index + 1) * LASR_ARENA_GRANULE;
+    if (arena->left < size) {
+        char* chunk = malloc(LASR_ARENA_CHUNK);
+        if (!chunk) {
+            return NULL;
+        }
+        memcpy(chunk, &arena->chunks, sizeof(void*));
+        arena->chunks = chunk;
+        // The link takes a whole granule, to keep the blocks aligned
+        arena->next = chunk + LASR_ARENA_GRANULE;
+        arena->left = LASR_ARENA_CHUNK - LASR_ARENA_GRANULE;
+    }
+    block = arena->next;
+    arena->next += size;
+    arena->left -= size;
+    return block;
+}
+
+/**
+ * Gives a small block back to the arena.
+ *
+ * @param arena The arena.
+ * @param block The block.
+ * @param index The size class of the block.
+ */
+static void arena_give(lasr_arena* arena, void* block, size_t index)
+{
+    memcpy(block, &arena->free[index], sizeof(void*));
+    arena->free[index] = block;
+}
+
+/**
+ * Reallocates a block from the arena, or from malloc if it's big.
+ *
+ * @param arena The arena.
+ * @param ptr The block, NULL to allocate one.
+ * @param osize The size of the block, 0 if NULL.
+ * @param nsize The new size of the block, not 0.
+ *
+ * @return The block, NULL if out of memory.
+ */
+static void* arena_realloc(lasr_arena* arena, void* ptr, size_t osize, size_t nsize)
+{
+    const size_t old_class = ptr ? size_class(osize) : LASR_ARENA_CLASSES;
+    const size_t new_class = size_class(nsize);
+
+    if (ptr && old_class == new_class && new_class < LASR_ARENA_CLASSES) {
+        return ptr; // Still fits
+    }
+    if ((!ptr || old_class == LASR_ARENA_CLASSES) && new_class == LASR_ARENA_CLASSES) {
+        void* block = realloc(ptr, nsize);
+        // Shrinking must not fail, the bigger block will do
+        return block || nsize > osize ? block : ptr;
+    }
+
+    void* block = new_class < LASR_ARENA_CLASSES ? arena_take(arena, new_class) : malloc(nsize);
+    if (!block) {
+        return nsize > osize ? NULL : ptr;
+    }
+    if (ptr) {
+        memcpy(block, ptr, osize < nsize ? osize : nsize);
+        if (old_class < LASR_ARENA_CLASSES) {
+            arena_give(arena, ptr, old_class);
+        } else {
+            free(ptr);
+        }
+    }
+    return block;
+}
+
+/**
+ * The lua_Alloc of the arena.
+ *
+ * @param ud The lasr_arena.
+ * @param ptr The block to reallocate or free, NULL to allocate one.
+ * @param osize The size of the block.
+ * @param nsize The new size of the block, 0 to free it.
+ *
+ * @return The block, NULL if freed or out of memory.
+ */
+void* lasr_arena_alloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+    lasr_arena* arena = ud;
+    if (!ptr) {
+        osize = 0;
+    }
+
+    if (nsize > osize) {
+        if (arena->limit && arena->used + (nsize - osize) > arena->limit) {
+            return NULL;
+        }
+        arena->allocations++;
+    }
+
+    void* block;
+    if (arena->alloc) {
+        block = arena->alloc(arena->ud, ptr, osize, nsize);
+    } else if (nsize == 0) {
+        const size_t index = size_class(osize);
+        if (index < LASR_ARENA_CLASSES) {
+            arena_give(arena, ptr, index);
+        } else {
+            free(ptr);
+        }
+        block = NULL;
+    } else {
+        block = arena_realloc(arena, ptr, osize, nsize);
+    }
+
+    if (block || nsize == 0) {
+        arena->used = arena->used - osize + nsize;
+        if (arena->used > arena->peak) {
+            arena->peak = arena->used;
+        }
+    }
+    return block;
+}
+
+/**
+ * Creates a Lua state allocating from an arena.
+ *
+ * LuaJIT refuses custom allocators on some 64 bit builds, the state then
+ * keeps its own allocator, wrapped by the arena.
+ *
+ * @param arena The arena, zeroed, which must outlive the state.
+ *
+ * @return The Lua state, NULL if out of memory.
+ */
+lua_State* lasr_arena_newstate(lasr_arena* arena)
+{
+    lua_State* L = lua_newstate(lasr_arena_alloc, arena);
+    if (L) {
+        return L;
+    }
+
+    L = luaL_newstate();
+    if (!L) {
+        return NULL;
+    }
+    arena->alloc = lua_getallocf(L, &arena->ud);
+    lua_setallocf(L, lasr_arena_alloc, arena);
+    return L;
+}
+
+/**
+ * Frees the memory of an arena, once its Lua state is closed.
+ *
+ * @param arena The arena.
+ */
+void lasr_arena_release(lasr_arena* arena)
+{
+    void* chunk = arena->chunks;
+    while (chunk) {
+        void* next;
+        memcpy(&next, chunk, sizeof(void*));
+        free(chunk);
+        chunk = next;
+    }
+    memset(arena, 0, sizeof(*arena));
+}
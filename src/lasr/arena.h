@@ -0,0 +1,36 @@
+#pragma once
+
+#include <lua.h>
+#include <stddef.h>
+
+#define LASR_ARENA_CHUNK (64 * 1024) /*!< Size of the chunks small blocks are carved from */
+#define LASR_ARENA_GRANULE 16 /*!< Small blocks are a multiple of this size, and aligned to it */
+#define LASR_ARENA_CLASSES 16 /*!< Sizes of small blocks, the biggest being LASR_ARENA_CLASSES * LASR_ARENA_GRANULE */
+
+/**
+ * @brief The memory of the Lua state of an auto splitter.
+ *
+ * Small blocks, most Lua objects, are carved from big chunks and recycled
+ * through a free list per size, so the script rarely reaches malloc.
+ * Bigger blocks go to malloc. Everything is accounted, and allocations fail
+ * past the limit, like when the system runs out of memory.
+ *
+ * When LuaJIT doesn't accept a custom allocator, the arena only wraps its
+ * own, for the accounting and the limit.
+ */
+typedef struct lasr_arena {
+    void* chunks; /*!< Chunks allocated so far, linked through their first word */
+    char* next; /*!< Unused part of the last chunk */
+    size_t left; /*!< Size of the unused part of the last chunk */
+    void* free[LASR_ARENA_CLASSES]; /*!< Freed small blocks of each size, linked through their first word */
+    lua_Alloc alloc; /*!< Allocator wrapped instead, NULL to use the arena */
+    void* ud; /*!< User data of the wrapped allocator */
+    size_t used; /*!< Bytes allocated by the Lua state */
+    size_t peak; /*!< Most bytes allocated at once */
+    size_t limit; /*!< Allocations fail past this many bytes, 0 for no limit */
+    unsigned long allocations; /*!< Blocks allocated or grown so far */
+} lasr_arena;
+
+lua_State* lasr_arena_newstate(lasr_arena* arena);
+void* lasr_arena_alloc(void* ud, void* ptr, size_t osize, size_t nsize);
+void lasr_arena_release(lasr_arena* arena);
@@ -5,11 +5,18 @@
 #include "auto-splitter.h"
 
 #include "./maps/maps.h"
+#include "arena.h"
+#include "bytecode.h"
 #include "functions.h"
+#include "sampler.h"
 #include "utils.h"
+#include "src/gui/app_window.h"
+#include "src/stats.h"
 
 #include <lauxlib.h>
 #include <lua.h>
+#include <errno.h>
+#include <luajit.h>
 #include <lualib.h>
 #include <signal.h>
 #include <stdbool.h>
@@ -17,7 +24,6 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <time.h>
-#include <unistd.h>
 
 char auto_splitter_file[PATH_MAX]; /*!< The loaded auto splitter file path */
 int refresh_rate = 60; /*!< The Auto Splitter's refresh rate applied */
@@ -43,11 +49,14 @@ atomic_bool call_start = false; /*!< True if the auto splitter is requesting for
 atomic_bool call_split = false; /*!< True if the auto splitter is requesting to split */
 atomic_bool toggle_loading = false;
 atomic_bool call_reset = false; /*!< True if the auto splitter is requesting a run reset */
+atomic_bool auto_splitter_reset = false; /*!< True if the timer was reset, so the auto splitter should get ready for a new attempt */
 atomic_bool run_using_game_time_call; /*!< True if startup has run and a new value for using game time has been set by the auto splitter */
 atomic_bool run_using_game_time; /*!< True if the auto splitter is requesting to use game time, false for real time */
 atomic_bool run_started = false; /*!< Wheter a run was started or not, same as timer->started but accessible from the auto splitter thread */
 atomic_bool run_running = false; /*!< Wheter we are running or not, same as timer->running but accessible from the auto splitter thread */
 bool prev_is_loading; /*!< The previous frame "is_loading" state */
+#define LASR_MEMORY_LIMIT 256 /*!< Default of memoryLimit, in MiB */
+static int memory_limit = LASR_MEMORY_LIMIT; /*!< Most memory the script may use, in MiB, 0 for no limit */
 
 /**
  * Disable possibly dangerous functions in LASR.
@@ -71,6 +80,95 @@ static const char* disabled_functions[] = {
     NULL
 };
 
+/**
+ * Registry references to the LASR functions the auto splitter defines,
+ * LUA_NOREF for the ones it doesn't.
+ */
+typedef struct lasr_hooks {
+    int state;
+    int start;
+    int split;
+    int is_loading;
+    int startup;
+    int reset;
+    int update;
+    int game_time;
+    int on_reset;
+} lasr_hooks;
+
+/**
+ * How often one of the LASR functions runs.
+ */
+typedef struct lasr_rate {
+    long long period; /*!< Time between two calls, in nanoseconds */
+    long long due; /*!< Monotonic time of the next call, in nanoseconds */
+} lasr_rate;
+
+/**
+ * How often each of the LASR functions called every cycle runs.
+ *
+ * They default to refreshRate, and the `rates` table of the script can
+ * set them one by one. The cycles run as often as the fastest of them.
+ */
+typedef struct lasr_rates {
+    lasr_rate state;
+    lasr_rate update;
+    lasr_rate game_time;
+    lasr_rate start;
+    lasr_rate split;
+    lasr_rate is_loading;
+    lasr_rate reset;
+    long long period; /*!< Time between two cycles, in nanoseconds */
+} lasr_rates;
+
+/**
+ * How long one of the LASR functions called every cycle may run.
+ */
+typedef struct lasr_budget {
+    long long warn; /*!< Calls running longer are reported, in nanoseconds */
+    long long abort; /*!< Calls running longer are aborted, in nanoseconds */
+    unsigned long overruns; /*!< Calls that ran longer than warn */
+    unsigned long aborts; /*!< Calls that were aborted */
+} lasr_budget;
+
+/**
+ * How long each of the LASR functions called every cycle may run.
+ *
+ * By default a call is reported when it runs longer than a cycle, and
+ * aborted after LASR_BUDGET_ABORT_MS. The `budgets` table of the script
+ * can change both, for every function or for a single one.
+ */
+typedef struct lasr_budgets {
+    lasr_budget state;
+    lasr_budget update;
+    lasr_budget game_time;
+    lasr_budget start;
+    lasr_budget split;
+    lasr_budget is_loading;
+    lasr_budget reset;
+} lasr_budgets;
+
+#define LASR_BUDGET_ABORT_MS 500 /*!< Default time after which a call is aborted */
+#define LASR_BUDGET_INSTRUCTIONS 1000 /*!< Lua instructions between two checks of the time */
+
+static long long budget_deadline; /*!< When the call running must be aborted, in nanoseconds */
+static bool budget_exceeded; /*!< Whether the last call with a budget was aborted */
+
+/**
+ * Garbage collection of the Lua state, paced by the auto splitter.
+ *
+ * The collector is stopped, so it never runs in the middle of a function.
+ * Instead, it runs in steps after the functions of each cycle, until the
+ * next cycle gets close. A new collection starts once the memory in use
+ * doubled since the last one ended, like the collector would on its own.
+ */
+typedef struct lasr_gc {
+    bool collecting; /*!< Whether a collection is in progress */
+    size_t threshold; /*!< Memory in use that starts the next collection, in bytes */
+} lasr_gc;
+
+#define LASR_GC_MIN_THRESHOLD (1024 * 1024) /*!< Collections don't start below this much memory in use */
+
 /**
  * Check if the game process exists and is running.
  *
@@ -119,6 +217,7 @@ static const lasr_function luac_functions[] = {
     { "getMaps", getMaps },
     { "str2ida", str2ida },
     { "md5sum", md5sum },
+    { "sampleLoading", sample_loading },
     { NULL, NULL }
 };
 
@@ -167,125 +266,140 @@ void disable_functions(lua_State* L, const char** functions)
 }
 
 /**
-    Generic function to call lua functions
-    Signatures are something like `disb>s`
-    1. d = double
-    2. i = int
-    3. s = string
-    4. b = boolean
-    5. > = return separator
-
-    Example: `call_va("functionName", "dd>d", x, y, &z);`
-    Calls "functionName" with two doubles as parameters (x and y), returning a double in z
-*/
-bool call_va(lua_State* L, const char* func, const char* sig, ...)
+ * Returns the monotonic time.
+ *
+ * @return The time, in nanoseconds.
+ */
+static long long monotonic_time(void)
 {
-    va_list vl;
-    int narg, nres; /* number of arguments and results */
-
-    va_start(vl, sig);
-    lua_getglobal(L, func); /* get function */
-
-    /* push arguments */
-    narg = 0;
-    while (*sig) { /* push arguments */
-        switch (*sig++) {
-            case 'd': /* double argument */
-                lua_pushnumber(L, va_arg(vl, double));
-                break;
-
-            case 'i': /* int argument */
-                lua_pushnumber(L, va_arg(vl, int));
-                break;
-
-            case 's': /* string argument */
-                lua_pushstring(L, va_arg(vl, char*));
-                break;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
 
-            case 'b':
-                lua_pushboolean(L, va_arg(vl, int));
-                break;
+/**
+ * Count hook aborting the function running once it's over its budget.
+ *
+ * LuaJIT doesn't run hooks inside compiled code, so the JIT compiler is
+ * turned off while functions with a budget run, see jit_off().
+ *
+ * @param L The Lua State
+ * @param ar Unused
+ */
+static void budget_hook(lua_State* L, lua_Debug* ar)
+{
+    if (monotonic_time() > budget_deadline) {
+        budget_exceeded = true;
+        luaL_error(L, "aborted, over its time budget");
+    }
+}
 
-            case '>':
-                break;
+/**
+ * Turns the JIT compiler off for good, so the budget hook can interrupt
+ * any loop. Auto splitters mostly wait on LibreSplit's functions, the
+ * interpreter is fast enough for them.
+ *
+ * @param L The Lua State
+ */
+static void jit_off(lua_State* L)
+{
+    luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_OFF);
+    // Keep the script from turning it back on
+    lua_getglobal(L, LUA_JITLIBNAME);
+    if (lua_istable(L, -1)) {
+        lua_pushnil(L);
+        lua_setfield(L, -2, "on");
+    }
+    lua_pop(L, 1); // Remove 'jit' from the stack
+}
 
-            default:
-                printf("invalid option (%c)\n", *(sig - 1));
-                va_end(vl);
-                return false;
+/**
+ * Accounts a call against the budget of its function, logging overruns.
+ *
+ * Overruns are logged the first time and then every power of two, so a
+ * function that always runs late doesn't flood the log.
+ *
+ * @param budget The budget of the function.
+ * @param name The name of the function.
+ * @param duration How long the call ran, in nanoseconds.
+ */
+static void check_budget(lasr_budget* budget, const char* name, long long duration)
+{
+    if (budget_exceeded) {
+        budget->aborts++;
+        printf("[budget] %s() aborted after %.1f ms, over its budget of %.1f ms (%lu times)\n",
+            name, duration / 1e6, budget->abort / 1e6, budget->aborts);
+    } else if (duration > budget->warn) {
+        budget->overruns++;
+        if ((budget->overruns & (budget->overruns - 1)) == 0) {
+            printf("[budget] %s() ran for %.1f ms, over its budget of %.1f ms (%lu times)\n",
+                name, duration / 1e6, budget->warn / 1e6, budget->overruns);
         }
-        if (*(sig - 1) == '>')
-            break;
-        narg++;
-        luaL_checkstack(L, 1, "too many arguments");
     }
+}
 
-    /* do the call */
-    nres = strlen(sig); /* number of expected results */
-    if (lua_pcall(L, narg, nres, 0) != LUA_OK) {
-        const char* err = lua_tostring(L, -1);
-        printf("error running function '%s': %s\n", func, err);
-        va_end(vl);
-        return false;
+/**
+ * Calls one of the LASR functions of the script, without arguments.
+ *
+ * @param L The Lua State
+ * @param hook Registry reference to the function.
+ * @param name The name of the function, for error messages.
+ * @param nresults The number of results to leave on the stack.
+ * @param budget How long the function may run, NULL if it may run forever.
+ *
+ * @return True on success, the results are on the stack.
+ */
+static bool call_hook(lua_State* L, int hook, const char* name, int nresults, lasr_budget* budget)
+{
+    long long start = 0;
+    if (budget) {
+        start = monotonic_time();
+        budget_deadline = start + budget->abort;
+        budget_exceeded = false;
+        lua_sethook(L, budget_hook, LUA_MASKCOUNT, LASR_BUDGET_INSTRUCTIONS);
     }
-
-    /* retrieve results */
-    nres = -nres; /* stack index of first result */
-    /* check if there's a return value */
-    if (!lua_isnil(L, nres)) {
-        while (*sig) { /* get results */
-            switch (*sig++) {
-                case 'd': /* double result */
-                    if (!lua_isnumber(L, nres)) {
-                        printf("function '%s' wrong result type, expected double\n", func);
-                        va_end(vl);
-                        return false;
-                    }
-                    *va_arg(vl, double*) = lua_tonumber(L, nres);
-                    break;
-
-                case 'i': /* int result */
-                    if (!lua_isnumber(L, nres)) {
-                        printf("function '%s' wrong result type, expected int\n", func);
-                        va_end(vl);
-                        return false;
-                    }
-                    *va_arg(vl, int*) = lua_tointeger(L, nres);
-                    break;
-
-                case 's': /* string result */
-                    if (!lua_isstring(L, nres)) {
-                        printf("function '%s' wrong result type, expected string\n", func);
-                        va_end(vl);
-                        return false;
-                    }
-                    *va_arg(vl, const char**) = lua_tostring(L, nres);
-                    break;
-
-                case 'b':
-                    if (!lua_isboolean(L, nres)) {
-                        printf("function '%s' wrong result type, expected boolean\n", func);
-                        va_end(vl);
-                        return false;
-                    }
-                    *va_arg(vl, bool*) = lua_toboolean(L, nres);
-                    break;
-
-                default:
-                    printf("invalid option (%c)\n", *(sig - 1));
-                    va_end(vl);
-                    return false;
-            }
-            nres++;
+    lua_rawgeti(L, LUA_REGISTRYINDEX, hook);
+    const int status = lua_pcall(L, 0, nresults, 0);
+    if (budget) {
+        lua_sethook(L, NULL, 0, 0);
+        check_budget(budget, name, monotonic_time() - start);
+    }
+    if (status != LUA_OK) {
+        if (!budget || !budget_exceeded) {
+            printf("error running function '%s': %s\n", name, lua_tostring(L, -1));
         }
-    } else {
-        va_end(vl);
+        lua_pop(L, 1); // Remove the error message from the stack
         return false;
     }
-    va_end(vl);
     return true;
 }
 
+/**
+ * Calls one of the LASR functions of the script that return a boolean.
+ *
+ * @param L The Lua State
+ * @param hook Registry reference to the function.
+ * @param name The name of the function, for error messages.
+ * @param budget How long the function may run.
+ * @param result Where to store the result.
+ *
+ * @return True if the function returned a boolean.
+ */
+static bool call_bool_hook(lua_State* L, int hook, const char* name, lasr_budget* budget, bool* result)
+{
+    if (!call_hook(L, hook, name, 1, budget)) {
+        return false;
+    }
+    const int type = lua_type(L, -1);
+    if (type == LUA_TBOOLEAN) {
+        *result = lua_toboolean(L, -1);
+    } else if (type != LUA_TNIL) {
+        printf("function '%s' wrong result type, expected boolean\n", name);
+    }
+    lua_pop(L, 1); // Remove the return value from the stack
+    return type == LUA_TBOOLEAN;
+}
+
 /**
  * The startup() LASR function.
  *
@@ -293,11 +407,11 @@ bool call_va(lua_State* L, const char* func, const char* sig, ...)
  * setting the internal parameters for the execution of the autosplitter.
  *
  * @param L The Lua State
+ * @param hooks The functions the script defines.
  */
-void startup(lua_State* L)
+static void startup(lua_State* L, const lasr_hooks* hooks)
 {
-    lua_getglobal(L, "startup");
-    lua_pcall(L, 0, 0, 0);
+    call_hook(L, hooks->startup, "startup", 0, NULL);
 
     lua_getglobal(L, "refreshRate");
     if (lua_isnumber(L, -1)) {
@@ -312,6 +426,12 @@ void startup(lua_State* L)
     }
     lua_pop(L, 1); // Remove 'mapsCacheCycles' from the stack
 
+    lua_getglobal(L, "memoryLimit");
+    if (lua_isnumber(L, -1) && lua_tointeger(L, -1) >= 0) {
+        memory_limit = lua_tointeger(L, -1);
+    }
+    lua_pop(L, 1); // Remove 'memoryLimit' from the stack
+
     lua_getglobal(L, "useGameTime");
     if (lua_isboolean(L, -1)) {
         use_game_time = lua_toboolean(L, -1);
@@ -322,6 +442,7 @@ void startup(lua_State* L)
         atomic_store(&run_using_game_time_call, true);
     }
     lua_pop(L, 1); // Remove 'useGameTime' from the stack
+    ls_app_wake();
 }
 
 /**
@@ -330,10 +451,12 @@ void startup(lua_State* L)
  * Executes the code in the state() function of the auto splitter.
  *
  * @param L The Lua State
+ * @param hooks The functions the script defines.
+ * @param budget How long the function may run.
  */
-void state(lua_State* L)
+static void state(lua_State* L, const lasr_hooks* hooks, lasr_budget* budget)
 {
-    call_va(L, "state", "");
+    call_hook(L, hooks->state, "state", 0, budget);
 }
 
 /**
@@ -342,10 +465,12 @@ void state(lua_State* L)
  * Executes the code in the update() function of the auto splitter.
  *
  * @param L The Lua State
+ * @param hooks The functions the script defines.
+ * @param budget How long the function may run.
  */
-void update(lua_State* L)
+static void update(lua_State* L, const lasr_hooks* hooks, lasr_budget* budget)
 {
-    call_va(L, "update", "");
+    call_hook(L, hooks->update, "update", 0, budget);
 }
 
 /**
@@ -355,17 +480,19 @@ void update(lua_State* L)
  * and stores the whether the run has started.
  *
  * @param L The Lua State
+ * @param hooks The functions the script defines.
+ * @param budget How long the function may run.
  */
-void start(lua_State* L)
+static void start(lua_State* L, const lasr_hooks* hooks, lasr_budget* budget)
 {
     bool ret;
-    if (call_va(L, "start", ">b", &ret)) {
+    if (call_bool_hook(L, hooks->start, "start", budget, &ret)) {
         if (ret) {
             atomic_store(&run_started, true);
             atomic_store(&call_start, true);
+            ls_app_wake();
         }
     }
-    lua_pop(L, 1); // Remove the return value from the stack
 }
 
 /**
@@ -374,14 +501,18 @@ void start(lua_State* L)
  * Executes the code in the split() function of the auto splitter.
  *
  * @param L The Lua State
+ * @param hooks The functions the script defines.
+ * @param budget How long the function may run.
  */
-void split(lua_State* L)
+static void split(lua_State* L, const lasr_hooks* hooks, lasr_budget* budget)
 {
     bool ret;
-    if (call_va(L, "split", ">b", &ret)) {
+    if (call_bool_hook(L, hooks->split, "split", budget, &ret)) {
         atomic_store(&call_split, ret);
+        if (ret) {
+            ls_app_wake();
+        }
     }
-    lua_pop(L, 1); // Remove the return value from the stack
 }
 
 /**
@@ -391,17 +522,19 @@ void split(lua_State* L)
  * allowing for load time removal.
  *
  * @param L The Lua State
+ * @param hooks The functions the script defines.
+ * @param budget How long the function may run.
  */
-void is_loading(lua_State* L)
+static void is_loading(lua_State* L, const lasr_hooks* hooks, lasr_budget* budget)
 {
     bool loading;
-    if (call_va(L, "isLoading", ">b", &loading)) {
+    if (call_bool_hook(L, hooks->is_loading, "isLoading", budget, &loading)) {
         if (loading != prev_is_loading) {
             atomic_store(&toggle_loading, true);
             prev_is_loading = !prev_is_loading;
+            ls_app_wake();
         }
     }
-    lua_pop(L, 1); // Remove the return value from the stack
 }
 
 /**
@@ -411,20 +544,22 @@ void is_loading(lua_State* L)
  * resetting the internal state of the timer to a pre-start situation.
  *
  * @param L The Lua State
+ * @param hooks The functions the script defines.
+ * @param budget How long the function may run.
  */
-void reset(lua_State* L)
+static void reset(lua_State* L, const lasr_hooks* hooks, lasr_budget* budget)
 {
     bool shouldReset;
-    if (call_va(L, "reset", ">b", &shouldReset)) {
+    if (call_bool_hook(L, hooks->reset, "reset", budget, &shouldReset)) {
         if (shouldReset) {
 
             atomic_store(&call_reset, true);
             // Assume these happen instantly to avoid any desync
             atomic_store(&run_started, false);
             atomic_store(&run_running, false);
+            ls_app_wake();
         }
     }
-    lua_pop(L, 1); // Remove the return value from the stack
 }
 
 /**
@@ -434,126 +569,539 @@ void reset(lua_State* L)
  * converting the game time found from the game's memory.
  *
  * @param L The Lua State
+ * @param hooks The functions the script defines.
+ * @param budget How long the function may run.
  */
-void gameTime(lua_State* L)
+static void gameTime(lua_State* L, const lasr_hooks* hooks, lasr_budget* budget)
 {
-    int gameTime;
-    if (call_va(L, "gameTime", ">i", &gameTime)) {
+    if (!call_hook(L, hooks->game_time, "gameTime", 1, budget)) {
+        return;
+    }
+    if (lua_isnumber(L, -1)) {
+        const int gameTime = lua_tointeger(L, -1);
         // Convert gameTime from milliseconds to the expected time format and update the timer
         atomic_store(&game_time_value, (long long)gameTime * 1000);
         atomic_store(&update_game_time, true);
+        ls_app_wake();
+    } else if (!lua_isnil(L, -1)) {
+        printf("function 'gameTime' wrong result type, expected int\n");
     }
     lua_pop(L, 1); // Remove the return value from the stack
 }
 
+/**
+ * The onReset() LASR function.
+ *
+ * Executes the code in the onReset() function of the auto splitter,
+ * letting it clear its own state when the timer is reset.
+ *
+ * @param L The Lua State
+ * @param hooks The functions the script defines.
+ */
+static void on_reset(lua_State* L, const lasr_hooks* hooks)
+{
+    call_hook(L, hooks->on_reset, "onReset", 0, NULL);
+}
+
+/**
+ * Takes a reference to a function defined by the script.
+ *
+ * @param L The Lua State
+ * @param name The name of the function
+ *
+ * @return The registry reference, LUA_NOREF if there is no such function.
+ */
+static int function_ref(lua_State* L, const char* name)
+{
+    lua_getglobal(L, name);
+    if (!lua_isfunction(L, -1)) {
+        lua_pop(L, 1); // Remove the value from the stack
+        return LUA_NOREF;
+    }
+    return luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+/**
+ * Releases the references to the functions of the script.
+ *
+ * @param L The Lua State
+ * @param hooks The references to release, set to LUA_NOREF.
+ */
+static void release_hooks(lua_State* L, lasr_hooks* hooks)
+{
+    int* refs[] = {
+        &hooks->state, &hooks->start, &hooks->split, &hooks->is_loading, &hooks->startup,
+        &hooks->reset, &hooks->update, &hooks->game_time, &hooks->on_reset
+    };
+    for (size_t i = 0; i < sizeof(refs) / sizeof(refs[0]); ++i) {
+        luaL_unref(L, LUA_REGISTRYINDEX, *refs[i]);
+        *refs[i] = LUA_NOREF;
+    }
+}
+
+/**
+ * Finds which LASR functions the script defines.
+ *
+ * The functions are looked up once, rather than by name every cycle,
+ * so a script that replaces one of them later keeps calling the one it
+ * defined when it ran, until the next reset.
+ *
+ * @param L The Lua State
+ * @param hooks Where to store what was found, the previous references
+ *              are released.
+ */
+static void find_hooks(lua_State* L, lasr_hooks* hooks)
+{
+    release_hooks(L, hooks);
+    hooks->state = function_ref(L, "state");
+    hooks->start = function_ref(L, "start");
+    hooks->split = function_ref(L, "split");
+    hooks->is_loading = function_ref(L, "isLoading");
+    hooks->startup = function_ref(L, "startup");
+    hooks->reset = function_ref(L, "reset");
+    hooks->update = function_ref(L, "update");
+    hooks->game_time = function_ref(L, "gameTime");
+    hooks->on_reset = function_ref(L, "onReset");
+}
+
+/**
+ * Executes the compiled script.
+ *
+ * @param L The Lua State
+ * @param chunk Registry reference to the compiled script.
+ *
+ * @return True on success.
+ */
+static bool run_chunk(lua_State* L, int chunk)
+{
+    lua_rawgeti(L, LUA_REGISTRYINDEX, chunk);
+    if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
+        // Error executing the file
+        const char* error_msg = lua_tostring(L, -1);
+        fprintf(stderr, "Lua runtime error: %s\n", error_msg);
+        lua_pop(L, 1); // Remove the error message from the stack
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Checks whether the script file changed since it was loaded.
+ *
+ * @param path The path of the script.
+ * @param loaded The status of the file when it was loaded.
+ *
+ * @return True if the file changed or can't be read anymore.
+ */
+static bool script_changed(const char* path, const struct stat* loaded)
+{
+    struct stat st;
+    if (stat(path, &st) == -1) {
+        return true;
+    }
+    return st.st_ino != loaded->st_ino || st.st_size != loaded->st_size
+        || st.st_mtim.tv_sec != loaded->st_mtim.tv_sec || st.st_mtim.tv_nsec != loaded->st_mtim.tv_nsec;
+}
+
+/**
+ * Reads how often each LASR function should run.
+ *
+ * Functions missing from the `rates` table, or when there's no such
+ * table, run at refreshRate. Every function is due on the next cycle.
+ *
+ * @param L The Lua State
+ * @param hooks The functions the script defines.
+ * @param rates Where to store the rates.
+ */
+static void read_rates(lua_State* L, const lasr_hooks* hooks, lasr_rates* rates)
+{
+    const struct {
+        const char* name;
+        int hook;
+        lasr_rate* rate;
+    } functions[] = {
+        { "state", hooks->state, &rates->state },
+        { "update", hooks->update, &rates->update },
+        { "gameTime", hooks->game_time, &rates->game_time },
+        { "start", hooks->start, &rates->start },
+        { "split", hooks->split, &rates->split },
+        { "isLoading", hooks->is_loading, &rates->is_loading },
+        { "reset", hooks->reset, &rates->reset },
+    };
+    const long long refresh_period = 1000000000LL / refresh_rate;
+
+    lua_getglobal(L, "rates");
+    const bool has_rates = lua_istable(L, -1);
+    rates->period = 0;
+    for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); ++i) {
+        long long period = refresh_period;
+        if (has_rates) {
+            lua_getfield(L, -1, functions[i].name);
+            if (lua_isnumber(L, -1) && lua_tonumber(L, -1) > 0) {
+                period = (long long)(1000000000. / lua_tonumber(L, -1));
+            }
+            lua_pop(L, 1); // Remove the rate from the stack
+        }
+        functions[i].rate->period = period;
+        functions[i].rate->due = 0;
+        if (functions[i].hook != LUA_NOREF && (!rates->period || period < rates->period)) {
+            rates->period = period;
+        }
+    }
+    lua_pop(L, 1); // Remove 'rates' from the stack
+
+    if (!rates->period) {
+        rates->period = refresh_period;
+    }
+}
+
+/**
+ * Reads a budget from a table of the script.
+ *
+ * @param L The Lua State, with the table on top.
+ * @param budget Where to store the times found, the others are left as is.
+ */
+static void read_budget(lua_State* L, lasr_budget* budget)
+{
+    lua_getfield(L, -1, "warn");
+    if (lua_isnumber(L, -1) && lua_tonumber(L, -1) > 0) {
+        budget->warn = (long long)(lua_tonumber(L, -1) * 1e6);
+    }
+    lua_pop(L, 1); // Remove 'warn' from the stack
+    lua_getfield(L, -1, "abort");
+    if (lua_isnumber(L, -1) && lua_tonumber(L, -1) > 0) {
+        budget->abort = (long long)(lua_tonumber(L, -1) * 1e6);
+    }
+    lua_pop(L, 1); // Remove 'abort' from the stack
+}
+
+/**
+ * Reads how long each LASR function may run.
+ *
+ * The `budgets` table of the script has times in milliseconds: `warn` and
+ * `abort` apply to every function, and a table named after a function,
+ * with its own `warn` and `abort`, applies to that function only.
+ * The counts of overruns and aborts are kept.
+ *
+ * @param L The Lua State
+ * @param budgets Where to store the budgets.
+ * @param cycle Time between two cycles, the default warning time, in nanoseconds.
+ */
+static void read_budgets(lua_State* L, lasr_budgets* budgets, long long cycle)
+{
+    const struct {
+        const char* name;
+        lasr_budget* budget;
+    } functions[] = {
+        { "state", &budgets->state },
+        { "update", &budgets->update },
+        { "gameTime", &budgets->game_time },
+        { "start", &budgets->start },
+        { "split", &budgets->split },
+        { "isLoading", &budgets->is_loading },
+        { "reset", &budgets->reset },
+    };
+    lasr_budget defaults = { cycle, LASR_BUDGET_ABORT_MS * 1000000LL, 0, 0 };
+
+    lua_getglobal(L, "budgets");
+    const bool has_budgets = lua_istable(L, -1);
+    if (has_budgets) {
+        read_budget(L, &defaults);
+    }
+    for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); ++i) {
+        functions[i].budget->warn = defaults.warn;
+        functions[i].budget->abort = defaults.abort;
+        if (has_budgets) {
+            lua_getfield(L, -1, functions[i].name);
+            if (lua_istable(L, -1)) {
+                read_budget(L, functions[i].budget);
+            }
+            lua_pop(L, 1); // Remove the budget of the function from the stack
+        }
+    }
+    lua_pop(L, 1); // Remove 'budgets' from the stack
+}
+
+/**
+ * Logs how many calls of each LASR function went over their budget.
+ *
+ * @param budgets The budgets.
+ */
+static void report_budgets(const lasr_budgets* budgets)
+{
+    const struct {
+        const char* name;
+        const lasr_budget* budget;
+    } functions[] = {
+        { "state", &budgets->state },
+        { "update", &budgets->update },
+        { "gameTime", &budgets->game_time },
+        { "start", &budgets->start },
+        { "split", &budgets->split },
+        { "isLoading", &budgets->is_loading },
+        { "reset", &budgets->reset },
+    };
+    for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); ++i) {
+        const lasr_budget* budget = functions[i].budget;
+        if (budget->overruns || budget->aborts) {
+            printf("[budget] %s(): %lu calls over budget, %lu aborted\n",
+                functions[i].name, budget->overruns, budget->aborts);
+        }
+    }
+}
+
+/**
+ * Checks whether a LASR function should run in the current cycle.
+ *
+ * When it should, its next call is scheduled one period later, or one
+ * period after this cycle if it missed calls.
+ *
+ * @param rate How often the function runs.
+ * @param now When the current cycle was due, in nanoseconds.
+ * @param cycle Time between two cycles, in nanoseconds. Calls due less
+ *              than half a cycle from now run now rather than a cycle late.
+ *
+ * @return True if the function should run.
+ */
+static bool rate_due(lasr_rate* rate, long long now, long long cycle)
+{
+    if (now + cycle / 2 < rate->due) {
+        return false;
+    }
+    rate->due += rate->period;
+    if (rate->due <= now) {
+        rate->due = now + rate->period;
+    }
+    return true;
+}
+
+/**
+ * Gets the auto splitter ready for a new attempt, after the timer was reset.
+ *
+ * The Lua state, the process and the addresses found by the script are kept.
+ * Scripts that define onReset() get it called and keep everything else.
+ * Other scripts may rely on their top level code to initialize their state
+ * for every attempt, so it runs again, followed by startup(), but the
+ * script is not read nor compiled again.
+ *
+ * @param L The Lua State
+ * @param hooks The functions the script defines, updated if it runs again.
+ * @param rates How often they run, updated if the script runs again.
+ * @param budgets How long they may run, updated if the script runs again.
+ * @param chunk Registry reference to the compiled script.
+ *
+ * @return True on success, false if the script failed.
+ */
+static bool warm_reset(lua_State* L, lasr_hooks* hooks, lasr_rates* rates, lasr_budgets* budgets, int chunk)
+{
+    // The timer isn't loading anymore
+    prev_is_loading = false;
+    lasr_sampler_resync();
+    maps_clearCache();
+    maps_cache_cycles_value = maps_cache_cycles;
+
+    if (hooks->on_reset != LUA_NOREF) {
+        on_reset(L, hooks);
+        // The timer forgot whether to use game time
+        atomic_store(&run_using_game_time, use_game_time);
+        atomic_store(&run_using_game_time_call, true);
+        ls_app_wake();
+        return true;
+    }
+    if (!run_chunk(L, chunk)) {
+        return false;
+    }
+    find_hooks(L, hooks);
+    if (hooks->startup != LUA_NOREF) {
+        startup(L, hooks);
+    }
+    read_rates(L, hooks, rates);
+    read_budgets(L, budgets, rates->period);
+    return true;
+}
+
+/**
+ * Sleeps until a point in time, rather than for a duration, so the
+ * cycles don't drift by the time spent between them.
+ *
+ * @param deadline The monotonic time to wake up at, in nanoseconds.
+ */
+static void sleep_until(long long deadline)
+{
+    const struct timespec ts = { deadline / 1000000000LL, deadline % 1000000000LL };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        // Interrupted by a signal, keep sleeping
+    }
+}
+
+/**
+ * Collects garbage in the time left before the next cycle.
+ *
+ * When the script is close to its memory limit, the garbage is collected
+ * all at once, even if it delays the next cycle.
+ *
+ * @param L The Lua State
+ * @param gc The state of the collection.
+ * @param arena The memory of the Lua State.
+ * @param until When to stop, on the monotonic clock, in nanoseconds.
+ *              At least one step is taken.
+ */
+static void collect_garbage(lua_State* L, lasr_gc* gc, const lasr_arena* arena, long long until)
+{
+    if (arena->limit && arena->used > arena->limit / 4 * 3) {
+        lua_gc(L, LUA_GCCOLLECT, 0);
+        gc->collecting = false;
+    } else if (gc->collecting || arena->used >= gc->threshold) {
+        gc->collecting = true;
+        do {
+            if (lua_gc(L, LUA_GCSTEP, 0)) {
+                gc->collecting = false;
+                break;
+            }
+        } while (monotonic_time() < until);
+    } else {
+        return;
+    }
+    if (!gc->collecting) {
+        gc->threshold = arena->used * 2 > LASR_GC_MIN_THRESHOLD ? arena->used * 2 : LASR_GC_MIN_THRESHOLD;
+    }
+    // Stepping lets the collector run on its own again
+    lua_gc(L, LUA_GCSTOP, 0);
+}
+
 /**
  * Loads the auto splitter Lua file and executes the auto splitter.
+ *
+ * @return True if the auto splitter should be loaded again right away,
+ *         because its file changed.
  */
-void run_auto_splitter(void)
+bool run_auto_splitter(void)
 {
-    lua_State* L = luaL_newstate();
+    // The arena counts the allocations, a cycle of a well behaved script shouldn't make any
+    lasr_arena arena = { 0 };
+    memory_limit = LASR_MEMORY_LIMIT;
+    arena.limit = (size_t)memory_limit << 20;
+    lua_State* L = lasr_arena_newstate(&arena);
+    if (!L) {
+        fprintf(stderr, "Cannot create the Lua state of the auto splitter\n");
+        atomic_store(&auto_splitter_enabled, false);
+        return false;
+    }
     luaL_openlibs(L);
     disable_functions(L, disabled_functions);
     push_lasr_functions(L, luac_functions);
 
     char current_file[PATH_MAX];
     strcpy(current_file, auto_splitter_file);
+    struct stat script_stat;
+    bool reload = false;
 
     // Load the Lua file
-    if (luaL_loadfile(L, auto_splitter_file) != LUA_OK) {
+    if (stat(current_file, &script_stat) == -1 || lasr_load_script(L, current_file) != LUA_OK) {
         // Error loading the file
-        const char* error_msg = lua_tostring(L, -1);
-        lua_pop(L, 1); // Remove the error message from the stack
-        fprintf(stderr, "Lua syntax error: %s\n", error_msg);
+        if (lua_gettop(L)) {
+            const char* error_msg = lua_tostring(L, -1);
+            fprintf(stderr, "Lua syntax error: %s\n", error_msg);
+        } else {
+            fprintf(stderr, "Cannot read the auto splitter %s\n", current_file);
+        }
         lua_close(L);
+        lasr_arena_release(&arena);
         atomic_store(&auto_splitter_enabled, false);
-        return;
+        return false;
     }
+    // Keep the compiled script, to run it again on reset
+    const int chunk = luaL_ref(L, LUA_REGISTRYINDEX);
 
     // Execute the Lua file
-    if (lua_pcall(L, 0, LUA_MULTRET, 0) != LUA_OK) {
-        // Error executing the file
-        const char* error_msg = lua_tostring(L, -1);
-        lua_pop(L, 1); // Remove the error message from the stack
-        fprintf(stderr, "Lua runtime error: %s\n", error_msg);
+    if (!run_chunk(L, chunk)) {
+        lasr_sampler_stop();
         lua_close(L);
+        lasr_arena_release(&arena);
         atomic_store(&auto_splitter_enabled, false);
-        return;
+        return false;
     }
 
-    lua_getglobal(L, "state");
-    bool state_exists = lua_isfunction(L, -1);
-    lua_pop(L, 1); // Remove 'state' from the stack
-
-    lua_getglobal(L, "start");
-    bool start_exists = lua_isfunction(L, -1);
-    lua_pop(L, 1); // Remove 'start' from the stack
-
-    lua_getglobal(L, "split");
-    bool split_exists = lua_isfunction(L, -1);
-    lua_pop(L, 1); // Remove 'split' from the stack
-
-    lua_getglobal(L, "isLoading");
-    bool is_loading_exists = lua_isfunction(L, -1);
-    lua_pop(L, 1); // Remove 'isLoading' from the stack
-
-    lua_getglobal(L, "startup");
-    bool startup_exists = lua_isfunction(L, -1);
-    lua_pop(L, 1); // Remove 'startup' from the stack
-
-    lua_getglobal(L, "reset");
-    bool reset_exists = lua_isfunction(L, -1);
-    lua_pop(L, 1); // Remove 'reset' from the stack
-
-    lua_getglobal(L, "update");
-    bool update_exists = lua_isfunction(L, -1);
-    lua_pop(L, 1); // Remove 'update' from the stack
-
-    lua_getglobal(L, "gameTime");
-    bool gameTime_exists = lua_isfunction(L, -1);
-    lua_pop(L, 1); // Remove 'gameTime' from the stack
+    lasr_hooks hooks = {
+        LUA_NOREF, LUA_NOREF, LUA_NOREF, LUA_NOREF, LUA_NOREF,
+        LUA_NOREF, LUA_NOREF, LUA_NOREF, LUA_NOREF
+    };
+    find_hooks(L, &hooks);
 
-    if (startup_exists) {
-        startup(L);
+    if (hooks.startup != LUA_NOREF) {
+        startup(L, &hooks);
     }
+    lasr_rates rates;
+    read_rates(L, &hooks, &rates);
+    lasr_budgets budgets = { 0 };
+    read_budgets(L, &budgets, rates.period);
+    // From now on, functions run with a budget, and garbage is only collected between cycles
+    jit_off(L);
+    lasr_gc gc = { false, LASR_GC_MIN_THRESHOLD };
+    lua_gc(L, LUA_GCSTOP, 0);
+
+    // A reset asked before the script was loaded is already done
+    atomic_store(&auto_splitter_reset, false);
 
     printf("Refresh rate: %d\n", refresh_rate);
-    int rate = 1000000 / refresh_rate;
 
+    // Each cycle is due one period after the previous one was, however long they take
+    long long deadline = monotonic_time();
     while (1) {
-        struct timespec clock_start;
-        clock_gettime(CLOCK_MONOTONIC, &clock_start);
+        const long long cycle_start = monotonic_time();
+        const unsigned long allocations = arena.allocations;
+        // startup() may change the limit when the script runs again
+        arena.limit = (size_t)memory_limit << 20;
 
         if (!atomic_load(&auto_splitter_enabled) || strcmp(current_file, auto_splitter_file) != 0 || !process_exists() || process.pid == 0) {
             break;
         }
 
-        if (state_exists) {
-            state(L);
+        if (atomic_exchange(&auto_splitter_reset, false)) {
+            if (script_changed(current_file, &script_stat)) {
+                printf("Auto splitter changed, reloading it\n");
+                reload = true;
+                break;
+            }
+            if (!warm_reset(L, &hooks, &rates, &budgets, chunk)) {
+                atomic_store(&auto_splitter_enabled, false);
+                break;
+            }
+        }
+
+        // The pointers to the value the sampler reads may have moved
+        lasr_sampler_update();
+
+        // Once a function is aborted, the cycle is already late: the
+        // functions after it are skipped and run on the next cycle
+        budget_exceeded = false;
+
+        if (!budget_exceeded && hooks.state != LUA_NOREF && rate_due(&rates.state, deadline, rates.period)) {
+            state(L, &hooks, &budgets.state);
         }
 
-        if (update_exists) {
-            update(L);
+        if (!budget_exceeded && hooks.update != LUA_NOREF && rate_due(&rates.update, deadline, rates.period)) {
+            update(L, &hooks, &budgets.update);
         }
 
-        if (gameTime_exists && use_game_time && atomic_load(&run_started) && atomic_load(&run_running)) {
-            gameTime(L);
+        if (!budget_exceeded && hooks.game_time != LUA_NOREF && use_game_time && atomic_load(&run_started) && atomic_load(&run_running) && rate_due(&rates.game_time, deadline, rates.period)) {
+            gameTime(L, &hooks, &budgets.game_time);
         }
 
-        if (start_exists && !atomic_load(&run_started) && !atomic_load(&run_running)) {
-            start(L);
+        if (!budget_exceeded && hooks.start != LUA_NOREF && !atomic_load(&run_started) && !atomic_load(&run_running) && rate_due(&rates.start, deadline, rates.period)) {
+            start(L, &hooks, &budgets.start);
         }
 
-        if (split_exists && atomic_load(&run_started)) {
-            split(L);
+        if (!budget_exceeded && hooks.split != LUA_NOREF && atomic_load(&run_started) && rate_due(&rates.split, deadline, rates.period)) {
+            split(L, &hooks, &budgets.split);
         }
 
-        if (is_loading_exists) {
-            is_loading(L);
+        if (!budget_exceeded && hooks.is_loading != LUA_NOREF && rate_due(&rates.is_loading, deadline, rates.period)) {
+            is_loading(L, &hooks, &budgets.is_loading);
         }
 
-        if (reset_exists && atomic_load(&run_running)) {
-            reset(L);
+        if (!budget_exceeded && hooks.reset != LUA_NOREF && atomic_load(&run_running) && rate_due(&rates.reset, deadline, rates.period)) {
+            reset(L, &hooks, &budgets.reset);
         }
 
         // Clear the memory maps cache if needed
@@ -564,14 +1112,29 @@ void run_auto_splitter(void)
             // printf("Cleared maps cache\n");
         }
 
-        struct timespec clock_end;
-        clock_gettime(CLOCK_MONOTONIC, &clock_end);
-        long long duration = (clock_end.tv_sec - clock_start.tv_sec) * 1000000 + (clock_end.tv_nsec - clock_start.tv_nsec) / 1000;
-        // printf("duration: %llu\n", duration);
-        if (duration < rate) {
-            usleep(rate - duration);
+        const long long cycle_end = monotonic_time();
+        ls_stats_auto_splitter_cycle((cycle_start - deadline) / 1000,
+            (cycle_end - cycle_start) / 1000, arena.allocations - allocations, arena.used, arena.peak);
+
+        // startup() may change the rates when the script runs again
+        const long long period = rates.period;
+        deadline += period;
+        if (cycle_end - deadline >= period) {
+            // Running late: the next cycle starts right away, but the ones
+            // missed are skipped rather than run back to back, which would
+            // only read the same memory again
+            const long long missed = (cycle_end - deadline) / period;
+            deadline += missed * period;
+            ls_stats_auto_splitter_skip(missed);
         }
+        // Keep a quarter of the time left as a margin
+        collect_garbage(L, &gc, &arena, deadline - (deadline - monotonic_time()) / 4);
+        sleep_until(deadline);
     }
 
+    report_budgets(&budgets);
+    lasr_sampler_stop();
     lua_close(L);
+    lasr_arena_release(&arena);
+    return reload;
 }
@@ -17,6 +17,7 @@ extern atomic_bool call_start;
 extern atomic_bool call_split;
 extern atomic_bool toggle_loading;
 extern atomic_bool call_reset;
+extern atomic_bool auto_splitter_reset;
 extern atomic_bool run_using_game_time_call;
 extern atomic_bool run_using_game_time;
 extern atomic_bool run_started;
@@ -32,4 +33,4 @@ struct lasr_function {
 } typedef lasr_function;
 
 void check_directories(void);
-void run_auto_splitter(void);
+bool run_auto_splitter(void);
@@ -0,0 +1,137 @@
+/** \file bytecode.c
+ *
+ * Bytecode cache of the auto splitter scripts.
+ *
+ * Compiled scripts are dumped with lua_dump into the lasr-cache folder of
+ * the data folder, one file per script path, and loaded from there as long
+ * as the size, modification time and hash of the script didn't change.
+ * Scripts can't reach any of this: load and string.dump stay disabled, and
+ * scripts themselves are only ever loaded as text.
+ */
+#include "bytecode.h"
+
+#include "src/settings/utils.h"
+
+#include <glib.h>
+#include <lauxlib.h>
+#include <linux/limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/**
+ * Returns the path of the bytecode cache of a script.
+ *
+ * @param path The path of the script.
+ * @param out_path Where to store the path of the cache, PATH_MAX long.
+ */
+static void cache_path(const char* path, char* out_path)
+{
+    char* key = g_compute_checksum_for_string(G_CHECKSUM_SHA256, path, -1);
+    get_libresplit_data_folder_path(out_path);
+    strcat(out_path, "/lasr-cache/");
+    strncat(out_path, key, PATH_MAX - strlen(out_path) - 1);
+    g_free(key);
+}
+
+/**
+ * lua_Writer appending the dumped bytecode to a GByteArray.
+ */
+static int bytecode_writer(lua_State* L, const void* p, size_t size, void* data)
+{
+    g_byte_array_append(data, p, size);
+    return 0;
+}
+
+/**
+ * Loads the cached bytecode of a script, if it's still valid.
+ *
+ * @param L The Lua State.
+ * @param path The path of the script.
+ * @param cache The path of the cache.
+ * @param header What the header of the cache must be.
+ *
+ * @return True if the script was loaded, its function is then on the stack.
+ */
+static bool load_cache(lua_State* L, const char* path, const char* cache, const lasr_bytecode_header* header)
+{
+    gchar* contents;
+    gsize length;
+    if (!g_file_get_contents(cache, &contents, &length, NULL)) {
+        return false;
+    }
+    bool loaded = false;
+    char chunkname[PATH_MAX + 1];
+    snprintf(chunkname, sizeof(chunkname), "@%s", path);
+    if (length > sizeof(lasr_bytecode_header) && memcmp(contents, header, sizeof(lasr_bytecode_header)) == 0) {
+        // A bytecode from another version of LuaJIT fails to load
+        if (luaL_loadbufferx(L, contents + sizeof(lasr_bytecode_header),
+                length - sizeof(lasr_bytecode_header), chunkname, "b")
+            == LUA_OK) {
+            loaded = true;
+        } else {
+            lua_pop(L, 1); // Remove the error message from the stack
+        }
+    }
+    g_free(contents);
+    return loaded;
+}
+
+/**
+ * Loads an auto splitter script, from the bytecode cache when possible.
+ *
+ * Same as luaL_loadfile, except that the file must be a text script. When
+ * it has to be compiled, its bytecode is saved for the next time.
+ *
+ * @param L The Lua State.
+ * @param path The path of the script.
+ *
+ * @return LUA_OK and the function on the stack on success, an error code
+ *         and the error message on the stack otherwise.
+ */
+int lasr_load_script(lua_State* L, const char* path)
+{
+    gchar* source;
+    gsize length;
+    struct stat st;
+    if (stat(path, &st) == -1 || !g_file_get_contents(path, &source, &length, NULL)) {
+        lua_pushfstring(L, "cannot read %s", path);
+        return LUA_ERRFILE;
+    }
+
+    lasr_bytecode_header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = LASR_BYTECODE_MAGIC;
+    header.version = LASR_BYTECODE_VERSION;
+    header.size = length;
+    header.mtime_sec = st.st_mtim.tv_sec;
+    header.mtime_nsec = st.st_mtim.tv_nsec;
+    char* hash = g_compute_checksum_for_data(G_CHECKSUM_SHA256, (const guchar*)source, length);
+    memcpy(header.hash, hash, sizeof(header.hash));
+    g_free(hash);
+
+    char cache[PATH_MAX];
+    cache_path(path, cache);
+    if (load_cache(L, path, cache, &header)) {
+        g_free(source);
+        return LUA_OK;
+    }
+
+    char chunkname[PATH_MAX + 1];
+    snprintf(chunkname, sizeof(chunkname), "@%s", path);
+    const int result = luaL_loadbufferx(L, source, length, chunkname, "t");
+    g_free(source);
+    if (result != LUA_OK) {
+        return result;
+    }
+
+    GByteArray* bytecode = g_byte_array_new();
+    g_byte_array_append(bytecode, (const guint8*)&header, sizeof(header));
+    if (lua_dump(L, bytecode_writer, bytecode) != 0
+        || !g_file_set_contents(cache, (const gchar*)bytecode->data, bytecode->len, NULL)) {
+        printf("Cannot save the bytecode of %s to %s\n", path, cache);
+    }
+    g_byte_array_free(bytecode, TRUE);
+    return LUA_OK;
+}
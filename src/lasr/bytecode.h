@@ -0,0 +1,22 @@
+#pragma once
+
+#include <lua.h>
+#include <stdint.h>
+
+#define LASR_BYTECODE_MAGIC 0x4C534243 /*!< "LSBC", bytecode cache file */
+#define LASR_BYTECODE_VERSION 1
+
+/**
+ * @brief Header of a bytecode cache file, followed by the bytecode.
+ * The bytecode is only used if all of these match the script.
+ */
+typedef struct lasr_bytecode_header {
+    uint32_t magic; /*!< Always LASR_BYTECODE_MAGIC */
+    uint32_t version; /*!< LASR_BYTECODE_VERSION */
+    int64_t size; /*!< Size of the script */
+    int64_t mtime_sec; /*!< Modification time of the script */
+    int64_t mtime_nsec;
+    char hash[64]; /*!< SHA-256 of the script, in hexadecimal */
+} lasr_bytecode_header;
+
+int lasr_load_script(lua_State* L, const char* path);
@@ -9,6 +9,7 @@
 #include "functions/print_tbl.h"
 #include "functions/process.h"
 #include "functions/readAddress.h"
+#include "functions/sampleLoading.h"
 #include "functions/shallow_copy_tbl.h"
 #include "functions/signature.h"
 #include "functions/sizeOf.h"
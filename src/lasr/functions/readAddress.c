@@ -57,19 +57,12 @@ READ_MEMORY_FUNCTION(bool)
  * Reads an address from memory and interprets it as a string.
  *
  * @param mem_address The memory address to read from.
- * @param buffer_size The size of the buffer to allocate.
+ * @param buffer Where to store the string, room for buffer_size bytes.
+ * @param buffer_size The number of bytes to read.
  * @param err A pointer to an error flag to write to.
- *
- * @return The string read from memory.
  */
-char* read_memory_string(uint64_t mem_address, int buffer_size, int32_t* err)
+void read_memory_string(uint64_t mem_address, char* buffer, int buffer_size, int32_t* err)
 {
-    char* buffer = (char*)malloc(buffer_size);
-    if (buffer == NULL) {
-        // Handle memory allocation failure
-        return NULL;
-    }
-
     struct iovec mem_local;
     struct iovec mem_remote;
 
@@ -87,7 +80,40 @@ char* read_memory_string(uint64_t mem_address, int buffer_size, int32_t* err)
         printf("Error reading process memory: short read of %ld bytes\n", (long)mem_n_read);
         exit(1);
     }
+}
+
+static char scratch_key; /*!< Its address is the registry key of the scratch buffer */
 
+/**
+ * Returns the scratch buffer of a Lua state, for reads that don't fit a number.
+ *
+ * The buffer is a userdata kept in the registry and reused by every read,
+ * it only grows when a read needs more room than any read before, so
+ * reading strings and byte arrays doesn't allocate every cycle.
+ *
+ * @param L The Lua state.
+ * @param size The size needed.
+ *
+ * @return The buffer, valid until the next call.
+ */
+static void* scratch_buffer(lua_State* L, size_t size)
+{
+    lua_pushlightuserdata(L, &scratch_key);
+    lua_rawget(L, LUA_REGISTRYINDEX);
+    void* buffer = lua_touserdata(L, -1);
+    size_t capacity = buffer ? lua_objlen(L, -1) : 0;
+    lua_pop(L, 1);
+    if (capacity >= size) {
+        return buffer;
+    }
+
+    capacity = capacity * 2 > size ? capacity * 2 : size;
+    if (capacity < 256) {
+        capacity = 256;
+    }
+    lua_pushlightuserdata(L, &scratch_key);
+    buffer = lua_newuserdata(L, capacity);
+    lua_rawset(L, LUA_REGISTRYINDEX);
     return buffer;
 }
 
@@ -190,20 +216,17 @@ int readAddress(lua_State* L)
             printf("[readAddress] Invalid string size, please read documentation");
             exit(1);
         }
-        char* value = read_memory_string(address, buffer_size, &error);
-        lua_pushstring(L, value != NULL ? value : "");
-        free(value);
+        char* value = scratch_buffer(L, (size_t)buffer_size + 1);
+        read_memory_string(address, value, buffer_size, &error);
+        value[buffer_size] = '\0';
+        lua_pushstring(L, value);
     } else if (strstr(value_type, "byte")) {
         int array_size = atoi(value_type + 4);
         if (array_size < 1) {
             printf("[readAddress] Invalid byte array size, please read documentation");
             exit(1);
         }
-        uint8_t* results = malloc(array_size * sizeof(uint8_t));
-        if (!results) {
-            printf("[readAddress] Memory allocation failed for byte array.\n");
-            exit(1);
-        }
+        uint8_t* results = scratch_buffer(L, array_size * sizeof(uint8_t));
         for (int j = 0; j < array_size; j++) {
             uint8_t value = read_memory_uint8_t(address + j, &error);
             if (memory_error)
@@ -222,7 +245,6 @@ int readAddress(lua_State* L)
                 lua_rawseti(L, -2, j + 1);
             }
         }
-        free(results);
     } else {
         printf("[readAddress] Invalid value type: %s\n", value_type);
         exit(1);
@@ -1,5 +1,12 @@
 #pragma once
 
 #include <lua.h>
+#include <stdbool.h>
+#include <stdint.h>
 
-int readAddress(lua_State* L);
\ No newline at end of file
+extern bool memory_error;
+
+uint32_t read_memory_uint32_t(uint64_t mem_address, int32_t* err);
+uint64_t read_memory_uint64_t(uint64_t mem_address, int32_t* err);
+
+int readAddress(lua_State* L);
@@ -0,0 +1,186 @@
+#include "sampleLoading.h"
+#include "../sampler.h"
+
+#include <lua.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief A type readAddress knows, as the sampler reads it.
+ */
+typedef struct sample_type {
+    const char* name; /*!< Name of the type, as in readAddress */
+    lasr_sample_kind kind; /*!< How to interpret it */
+    size_t size; /*!< Its size, in bytes */
+} sample_type;
+
+static const sample_type sample_types[] = {
+    { "sbyte", LASR_SAMPLE_SIGNED, 1 },
+    { "byte", LASR_SAMPLE_UNSIGNED, 1 },
+    { "short", LASR_SAMPLE_SIGNED, 2 },
+    { "ushort", LASR_SAMPLE_UNSIGNED, 2 },
+    { "int", LASR_SAMPLE_SIGNED, 4 },
+    { "uint", LASR_SAMPLE_UNSIGNED, 4 },
+    { "long", LASR_SAMPLE_SIGNED, 8 },
+    { "ulong", LASR_SAMPLE_UNSIGNED, 8 },
+    { "float", LASR_SAMPLE_FLOAT, 4 },
+    { "double", LASR_SAMPLE_DOUBLE, 8 },
+    { "bool", LASR_SAMPLE_UNSIGNED, 1 },
+    { NULL, 0, 0 },
+};
+
+static const char* comparisons[] = { "==", "~=", "<", "<=", ">", ">=", NULL };
+
+/**
+ * Reads the pointer path of the value to sample, like the arguments of
+ * readAddress after the type: a module name or an offset from the main
+ * module, then the offsets of the pointers to follow.
+ *
+ * @param L The lua state, with the path table on top.
+ * @param config Where to store the path.
+ *
+ * @return True if the path is valid.
+ */
+static bool read_path(lua_State* L, lasr_sampler_config* config)
+{
+    const size_t length = lua_objlen(L, -1);
+    size_t first = 1;
+
+    lua_rawgeti(L, -1, 1);
+    if (lua_type(L, -1) == LUA_TSTRING) {
+        strncpy(config->module, lua_tostring(L, -1), sizeof(config->module) - 1);
+        config->module[sizeof(config->module) - 1] = '\0';
+        first = 2;
+    } else {
+        config->module[0] = '\0';
+    }
+    lua_pop(L, 1);
+
+    if (length < first || length - first > LASR_SAMPLER_MAX_OFFSETS) {
+        printf("[sampleLoading] The address needs an offset and at most %d pointers to follow.\n", LASR_SAMPLER_MAX_OFFSETS);
+        return false;
+    }
+    config->offset_count = length - first;
+    for (size_t i = first; i <= length; i++) {
+        lua_rawgeti(L, -1, (int)i);
+        if (!lua_isnumber(L, -1)) {
+            printf("[sampleLoading] The offsets of the address must be numbers.\n");
+            lua_pop(L, 1);
+            return false;
+        }
+        config->offsets[i - first] = lua_tointeger(L, -1);
+        lua_pop(L, 1);
+    }
+    return true;
+}
+
+/**
+ * Reads the options of sampleLoading.
+ *
+ * @param L The lua state, with the options table at index 1.
+ * @param config Where to store the options.
+ *
+ * @return True if the options are valid.
+ */
+static bool read_options(lua_State* L, lasr_sampler_config* config)
+{
+    lua_getfield(L, 1, "type");
+    const char* type = lua_isstring(L, -1) ? lua_tostring(L, -1) : "";
+    const sample_type* found = NULL;
+    for (const sample_type* t = sample_types; t->name; t++) {
+        if (strcmp(type, t->name) == 0) {
+            found = t;
+            break;
+        }
+    }
+    lua_pop(L, 1);
+    if (!found) {
+        printf("[sampleLoading] The type must be a number or bool type, as in readAddress.\n");
+        return false;
+    }
+    config->kind = found->kind;
+    config->size = found->size;
+
+    lua_getfield(L, 1, "address");
+    bool valid_path = false;
+    if (lua_istable(L, -1)) {
+        valid_path = read_path(L, config);
+    } else {
+        printf("[sampleLoading] The address must be a table, such as { \"module\", 0x10, 0x8 }.\n");
+    }
+    lua_pop(L, 1);
+    if (!valid_path) {
+        return false;
+    }
+
+    lua_getfield(L, 1, "compare");
+    const char* compare = lua_isstring(L, -1) ? lua_tostring(L, -1) : "==";
+    int i = 0;
+    while (comparisons[i] && strcmp(compare, comparisons[i]) != 0) {
+        i++;
+    }
+    lua_pop(L, 1);
+    if (!comparisons[i]) {
+        printf("[sampleLoading] Invalid comparison: %s\n", compare);
+        return false;
+    }
+    config->compare = (lasr_sample_compare)i;
+
+    lua_getfield(L, 1, "value");
+    if (lua_isboolean(L, -1)) {
+        config->integer = lua_toboolean(L, -1);
+        config->number = config->integer;
+    } else if (lua_isnumber(L, -1)) {
+        config->integer = lua_tointeger(L, -1);
+        config->number = lua_tonumber(L, -1);
+    } else {
+        printf("[sampleLoading] The value must be a number or a boolean.\n");
+        lua_pop(L, 1);
+        return false;
+    }
+    lua_pop(L, 1);
+
+    lua_getfield(L, 1, "rate");
+    config->rate = lua_isnumber(L, -1) ? (int)lua_tointeger(L, -1) : 1000;
+    lua_pop(L, 1);
+    if (config->rate < LASR_SAMPLER_MIN_RATE) {
+        config->rate = LASR_SAMPLER_MIN_RATE;
+    } else if (config->rate > LASR_SAMPLER_MAX_RATE) {
+        config->rate = LASR_SAMPLER_MAX_RATE;
+    }
+    return true;
+}
+
+/**
+ * The lua sampleLoading() function.
+ *
+ * Hands a value telling whether the game is loading to the native sampler,
+ * or stops sampling when called with nil.
+ *
+ * @param L The lua state
+ *
+ * @return Pushes true if the sampler started.
+ */
+int sample_loading(lua_State* L)
+{
+    if (lua_gettop(L) == 0 || lua_isnil(L, 1)) {
+        lasr_sampler_stop();
+        lua_pushboolean(L, 0);
+        return 1;
+    }
+    if (!lua_istable(L, 1)) {
+        printf("[sampleLoading] The argument must be a table of options or nil.\n");
+        lua_pushboolean(L, 0);
+        return 1;
+    }
+
+    lasr_sampler_config config;
+    memset(&config, 0, sizeof(config));
+    if (!read_options(L, &config)) {
+        lua_pushboolean(L, 0);
+        return 1;
+    }
+    lasr_sampler_start(&config);
+    lua_pushboolean(L, 1);
+    return 1;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include <lua.h>
+
+int sample_loading(lua_State* L);
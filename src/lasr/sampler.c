@@ -0,0 +1,288 @@
+/** \file sampler.c
+ *
+ * Native load sampler of the auto splitter.
+ *
+ * A script can hand a pointer path, a comparison and a value to the sampler
+ * with sampleLoading(). Its thread then reads that single value hundreds or
+ * thousands of times per second, with one process_vm_readv per sample, and
+ * queues a timestamped event whenever the game starts or stops loading.
+ * The timer takes the events on its next step and accounts the load from
+ * the time it was sampled, so load removal doesn't depend on the rate of
+ * the script.
+ *
+ * Following the pointer path needs the memory maps of the process, so the
+ * auto splitter thread does it once per cycle and the sampler only reads
+ * the address found.
+ */
+#include "sampler.h"
+#include "functions/readAddress.h"
+#include "src/gui/app_window.h"
+#include "utils.h"
+
+#include <errno.h>
+#include <linux/prctl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <time.h>
+
+/**
+ * @brief The sampler thread and the events it queued.
+ */
+static struct {
+    lasr_sampler_config config; /*!< What to sample, only changed while the thread is stopped */
+    bool started; /*!< Whether the thread exists, only used by the auto splitter thread */
+    pthread_t thread; /*!< The sampler thread */
+    atomic_bool active; /*!< Cleared to make the sampler thread exit */
+    atomic_bool resync; /*!< Set to make the sampler queue the current state, even if unchanged */
+    atomic_uint_least64_t address; /*!< Where the value is, 0 if the path can't be followed */
+    atomic_uint pid; /*!< The process to read from */
+    lasr_load_event events[LASR_SAMPLER_EVENTS]; /*!< Queued events, oldest first from head */
+    size_t head; /*!< Index of the oldest event */
+    size_t count; /*!< Number of events queued */
+    pthread_mutex_t lock; /*!< Protects the queue */
+} sampler = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/**
+ * Returns the monotonic time.
+ *
+ * @return The time, in nanoseconds.
+ */
+static long long monotonic_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * Queues a load event for the timer.
+ *
+ * The window is woken up to drain the queue, so it only fills up if the
+ * timer is stuck. The events alternate, so when it's full the last one queued
+ * and the new one cancel out and are both dropped, which only hides a
+ * load or a gap between two loads.
+ *
+ * @param loading Whether the game is loading.
+ * @param time When it was sampled, in microseconds.
+ */
+static void queue_event(bool loading, long long time)
+{
+    pthread_mutex_lock(&sampler.lock);
+    if (sampler.count == LASR_SAMPLER_EVENTS) {
+        sampler.count--;
+    } else {
+        const size_t tail = (sampler.head + sampler.count) % LASR_SAMPLER_EVENTS;
+        sampler.events[tail].loading = loading;
+        sampler.events[tail].time = time;
+        sampler.count++;
+    }
+    pthread_mutex_unlock(&sampler.lock);
+    // The window doesn't step while the timer is idle
+    ls_app_wake();
+}
+
+/**
+ * Compares a sampled value to the loading value.
+ *
+ * @param config What is sampled.
+ * @param raw The bytes read from the game memory.
+ *
+ * @return True if the game is loading.
+ */
+static bool sample_matches(const lasr_sampler_config* config, const unsigned char* raw)
+{
+    int order;
+    if (config->kind == LASR_SAMPLE_FLOAT || config->kind == LASR_SAMPLE_DOUBLE) {
+        double value;
+        if (config->kind == LASR_SAMPLE_FLOAT) {
+            float f;
+            memcpy(&f, raw, sizeof(f));
+            value = f;
+        } else {
+            memcpy(&value, raw, sizeof(value));
+        }
+        order = (value > config->number) - (value < config->number);
+    } else {
+        uint64_t bits = 0;
+        memcpy(&bits, raw, config->size); // little endian
+        if (config->kind == LASR_SAMPLE_SIGNED) {
+            const unsigned shift = 64 - 8 * config->size;
+            const int64_t value = (int64_t)(bits << shift) >> shift;
+            order = (value > config->integer) - (value < config->integer);
+        } else {
+            const uint64_t value = bits;
+            const uint64_t other = (uint64_t)config->integer;
+            order = (value > other) - (value < other);
+        }
+    }
+
+    switch (config->compare) {
+        case LASR_COMPARE_EQ:
+            return order == 0;
+        case LASR_COMPARE_NE:
+            return order != 0;
+        case LASR_COMPARE_LT:
+            return order < 0;
+        case LASR_COMPARE_LE:
+            return order <= 0;
+        case LASR_COMPARE_GT:
+            return order > 0;
+        case LASR_COMPARE_GE:
+            return order >= 0;
+    }
+    return false;
+}
+
+/**
+ * The sampler thread, reading the value at a fixed rate until stopped.
+ *
+ * @param arg Unused.
+ */
+static void* sampler_thread(void* arg)
+{
+    prctl(PR_SET_NAME, "LS Sampler", 0, 0, 0);
+    const lasr_sampler_config* config = &sampler.config;
+    const long long period = 1000000000LL / config->rate;
+    long long deadline = monotonic_time();
+    int last = -1; // The state last queued, -1 if none
+
+    while (atomic_load(&sampler.active)) {
+        if (atomic_exchange(&sampler.resync, false)) {
+            last = -1;
+        }
+        const uint64_t address = atomic_load(&sampler.address);
+        if (address) {
+            unsigned char raw[8];
+            struct iovec local = { raw, config->size };
+            struct iovec remote = { (void*)(uintptr_t)address, config->size };
+            const long long time = monotonic_time();
+            if (process_vm_readv(atomic_load(&sampler.pid), &local, 1, &remote, 1, 0) == (ssize_t)config->size) {
+                const int loading = sample_matches(config, raw);
+                if (loading != last) {
+                    queue_event(loading, time / 1000);
+                    last = loading;
+                }
+            }
+        }
+
+        deadline += period;
+        const long long now = monotonic_time();
+        if (now - deadline >= period) {
+            // Fell behind, don't take the missed samples back to back
+            deadline = now;
+        }
+        const struct timespec ts = { deadline / 1000000000LL, deadline % 1000000000LL };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+            // Interrupted by a signal, keep sleeping
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Starts sampling a value, replacing what was sampled before.
+ *
+ * Must be called from the auto splitter thread.
+ *
+ * @param config What to sample.
+ */
+void lasr_sampler_start(const lasr_sampler_config* config)
+{
+    lasr_sampler_stop();
+    sampler.config = *config;
+    atomic_store(&sampler.resync, false);
+    atomic_store(&sampler.active, true);
+    lasr_sampler_update();
+    if (pthread_create(&sampler.thread, NULL, sampler_thread, NULL) != 0) {
+        printf("[sampleLoading] Cannot start the sampler thread\n");
+        atomic_store(&sampler.active, false);
+        return;
+    }
+    sampler.started = true;
+}
+
+/**
+ * Stops sampling and drops the events not taken yet.
+ *
+ * Must be called from the auto splitter thread.
+ */
+void lasr_sampler_stop(void)
+{
+    if (!sampler.started) {
+        return;
+    }
+    atomic_store(&sampler.active, false);
+    pthread_join(sampler.thread, NULL);
+    sampler.started = false;
+    atomic_store(&sampler.address, 0);
+
+    pthread_mutex_lock(&sampler.lock);
+    sampler.count = 0;
+    pthread_mutex_unlock(&sampler.lock);
+}
+
+/**
+ * Follows the pointer path again, as the pointers may change at any time.
+ *
+ * Must be called from the auto splitter thread, once per cycle.
+ */
+void lasr_sampler_update(void)
+{
+    if (!atomic_load(&sampler.active)) {
+        return;
+    }
+    const lasr_sampler_config* config = &sampler.config;
+    uint64_t address = config->module[0] ? find_base_address(config->module) : process.base_address;
+    if (!address) {
+        atomic_store(&sampler.address, 0);
+        return;
+    }
+
+    int32_t error = 0;
+    memory_error = false;
+    address += config->offsets[0];
+    for (size_t i = 1; i <= config->offset_count && !memory_error; i++) {
+        if (address <= UINT32_MAX) {
+            address = read_memory_uint32_t(address, &error);
+        } else {
+            address = read_memory_uint64_t(address, &error);
+        }
+        address += config->offsets[i];
+    }
+    atomic_store(&sampler.pid, process.pid);
+    atomic_store(&sampler.address, memory_error ? 0 : address);
+}
+
+/**
+ * Makes the sampler queue the state of the game with its next sample,
+ * for instance after the timer was reset and forgot about the load.
+ */
+void lasr_sampler_resync(void)
+{
+    atomic_store(&sampler.resync, true);
+}
+
+/**
+ * Takes the oldest load event queued by the sampler.
+ *
+ * @param event Where to store the event.
+ *
+ * @return True if there was an event.
+ */
+bool lasr_sampler_take(lasr_load_event* event)
+{
+    pthread_mutex_lock(&sampler.lock);
+    const bool found = sampler.count > 0;
+    if (found) {
+        *event = sampler.events[sampler.head];
+        sampler.head = (sampler.head + 1) % LASR_SAMPLER_EVENTS;
+        sampler.count--;
+    }
+    pthread_mutex_unlock(&sampler.lock);
+    return found;
+}
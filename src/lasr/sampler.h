@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LASR_SAMPLER_MAX_OFFSETS 16 /*!< Longest pointer path the sampler follows */
+#define LASR_SAMPLER_EVENTS 64 /*!< Load events waiting for the timer, at most */
+#define LASR_SAMPLER_MIN_RATE 100 /*!< Slowest sampling rate, in Hz */
+#define LASR_SAMPLER_MAX_RATE 20000 /*!< Fastest sampling rate, in Hz */
+
+/**
+ * @brief How a sampled value is interpreted.
+ */
+typedef enum lasr_sample_kind {
+    LASR_SAMPLE_SIGNED,
+    LASR_SAMPLE_UNSIGNED,
+    LASR_SAMPLE_FLOAT,
+    LASR_SAMPLE_DOUBLE,
+} lasr_sample_kind;
+
+/**
+ * @brief How a sampled value is compared to the loading value.
+ */
+typedef enum lasr_sample_compare {
+    LASR_COMPARE_EQ,
+    LASR_COMPARE_NE,
+    LASR_COMPARE_LT,
+    LASR_COMPARE_LE,
+    LASR_COMPARE_GT,
+    LASR_COMPARE_GE,
+} lasr_sample_compare;
+
+/**
+ * @brief A value in the game memory telling whether it's loading.
+ */
+typedef struct lasr_sampler_config {
+    char module[256]; /*!< Module the path starts from, empty for the main module */
+    int64_t offsets[LASR_SAMPLER_MAX_OFFSETS + 1]; /*!< Offset from the module, then of each pointer to follow */
+    size_t offset_count; /*!< Number of pointers to follow, after the first offset */
+    lasr_sample_kind kind; /*!< How to interpret the value */
+    size_t size; /*!< Size of the value, in bytes */
+    lasr_sample_compare compare; /*!< Comparison that is true while loading */
+    int64_t integer; /*!< Value to compare integers to */
+    double number; /*!< Value to compare floating point numbers to */
+    int rate; /*!< Samples per second */
+} lasr_sampler_config;
+
+/**
+ * @brief A load starting or ending, as seen by the sampler.
+ */
+typedef struct lasr_load_event {
+    bool loading; /*!< Whether the game started or stopped loading */
+    long long time; /*!< When it was sampled, on the monotonic clock, in microseconds */
+} lasr_load_event;
+
+void lasr_sampler_start(const lasr_sampler_config* config);
+void lasr_sampler_stop(void);
+void lasr_sampler_update(void);
+void lasr_sampler_resync(void);
+bool lasr_sampler_take(lasr_load_event* event);
@@ -6,6 +6,7 @@
 #include <glib.h>
 #include <stdatomic.h>
 #include <stdio.h>
+#include <unistd.h>
 
 game_process process;
 
@@ -19,14 +20,29 @@ bool restart_auto_splitter(void)
     const bool was_asl_enabled = atomic_load(&auto_splitter_enabled);
     if (was_asl_enabled) {
         atomic_store(&auto_splitter_enabled, false);
-        while (atomic_load(&auto_splitter_running) && was_asl_enabled) {
-            // wait, this will be very fast so its ok to just spin
+        while (atomic_load(&auto_splitter_running)) {
+            // wait for the auto splitter to notice, at most one of its cycles
+            usleep(1000);
         }
         atomic_store(&auto_splitter_enabled, true);
     }
     return was_asl_enabled;
 }
 
+/**
+ * Asks the auto splitter to get ready for a new attempt, without waiting.
+ *
+ * Unlike restart_auto_splitter, the script keeps running and keeps the
+ * process and addresses it found, see warm_reset in auto-splitter.c.
+ * It's only loaded again if its file changed.
+ */
+void reset_auto_splitter(void)
+{
+    if (atomic_load(&auto_splitter_enabled)) {
+        atomic_store(&auto_splitter_reset, true);
+    }
+}
+
 /**
  * Gets the base address of a module.
  *
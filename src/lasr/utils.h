@@ -33,6 +33,7 @@ typedef struct ProcessMap {
 } ProcessMap;
 
 bool restart_auto_splitter(void);
+void reset_auto_splitter(void);
 uintptr_t find_base_address(const char* module);
 bool handle_memory_error(uint32_t err);
 const char* value_to_c_string(lua_State* L, int index);
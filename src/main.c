@@ -1,14 +1,18 @@
+#include "comparisons.h"
 #include "gui/app_window.h"
 #include "gui/dialogs.h"
+#include "gui/icon_cache.h"
 #include "gui/timer.h"
 #include "keybinds/keybinds_callbacks.h"
 #include "lasr/auto-splitter.h"
 #include "logging.h"
+#include "saver.h"
 #include "server.h"
 #include "settings/utils.h"
 #include "shared.h"
 #include "src/gui/dialogs.h"
 #include "src/keybinds/delayed_callbacks.h"
+#include "stats.h"
 
 #include <gtk/gtk.h>
 #include <jansson.h>
@@ -60,7 +64,7 @@ void handle_ctl_command(CTLCommand command)
             timer_skip(win);
             break;
         case CTL_CMD_EXIT:
-            exit(0);
+            exit(ls_saver_flush() ? EXIT_FAILURE : EXIT_SUCCESS);
             break;
         default:
             printf("Unknown CTL command: %d\n", command);
@@ -77,14 +81,17 @@ static void* ls_auto_splitter(void* arg)
 {
     prctl(PR_SET_NAME, "LS LASR", 0, 0, 0);
     while (1) {
+        bool reload = false;
         if (atomic_load(&auto_splitter_enabled) && auto_splitter_file[0] != '\0') {
             atomic_store(&auto_splitter_running, true);
-            run_auto_splitter();
+            reload = run_auto_splitter();
         }
         atomic_store(&auto_splitter_running, false);
         if (atomic_load(&exit_requested))
             return 0;
-        usleep(50000);
+        if (!reload) {
+            usleep(50000);
+        }
     }
     return NULL;
 }
@@ -97,6 +104,8 @@ static bool bypass_root_protection(void)
 
 int main(int argc, char* argv[])
 {
+    ls_stats_phase("main");
+
     // Check if app is running as root.
     if (geteuid() == 0 && !bypass_root_protection()) {
         gtk_init(&argc, &argv);
@@ -117,11 +126,21 @@ int main(int argc, char* argv[])
     pthread_t t3; // Logging Thread
     pthread_create(&t3, NULL, &loggingThread, NULL);
 
+    pthread_t t4; // Saver thread
+    pthread_create(&t4, NULL, &ls_saver_thread, NULL);
+    pthread_t t5; // Comparisons thread
+    pthread_create(&t5, NULL, &ls_comparisons_thread, NULL);
+    pthread_t t6; // Split icons thread
+    pthread_create(&t6, NULL, &ls_icon_cache_thread, NULL);
+
     g_application_run(G_APPLICATION(g_app), argc, argv);
 
     pthread_join(t1, NULL);
     pthread_join(t2, NULL);
     pthread_join(t3, NULL);
+    pthread_join(t4, NULL);
+    pthread_join(t5, NULL);
+    pthread_join(t6, NULL);
 
     return 0;
 }
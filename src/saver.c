@@ -0,0 +1,379 @@
+/** \file saver.c
+ * Asynchronous split file and run history writer.
+ *
+ * A single long-lived thread receives immutable JSON snapshots, and runs to
+ * append to the history, and writes them to disk, so the GTK thread never
+ * waits on the filesystem. Every JSON write goes to a temporary file that is
+ * synced and then renamed over the destination, so a crash can never leave
+ * a half-written split file behind.
+ */
+#include "saver.h"
+#include "comparisons.h"
+#include "logging.h"
+
+#include <fcntl.h>
+#include <libgen.h>
+#include <linux/prctl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*! The save queue, filled by the main thread and consumed by the saver thread */
+static LSSaveQueue saveQueue = {
+    .head = NULL,
+    .tail = NULL,
+    .writing = false,
+    .active = true,
+    .running = true,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .idle = PTHREAD_COND_INITIALIZER,
+};
+
+/**
+ * Syncs the directory containing a file, making a rename inside it durable.
+ *
+ * @param path The path of the file whose directory should be synced.
+ */
+static void sync_parent_directory(const char* path)
+{
+    char dir_path[PATH_MAX];
+    strncpy(dir_path, path, sizeof(dir_path) - 1);
+    dir_path[sizeof(dir_path) - 1] = '\0';
+
+    int dir_fd = open(dirname(dir_path), O_RDONLY | O_DIRECTORY);
+    if (dir_fd == -1) {
+        return;
+    }
+    fsync(dir_fd);
+    close(dir_fd);
+}
+
+/**
+ * Atomically replaces a file with the serialized JSON document.
+ *
+ * The document is written to a temporary file next to the destination,
+ * flushed to disk and then renamed over the destination. Readers (and
+ * crashes) will only ever see either the old or the new file.
+ *
+ * @param json The document to write.
+ * @param path The destination path, symlinks are followed.
+ *
+ * @return Zero on success, non-zero otherwise.
+ */
+int ls_json_dump_atomic(const json_t* json, const char* path)
+{
+    char real_path[PATH_MAX];
+    char tmp_path[PATH_MAX];
+    struct stat st;
+
+    // Replace the file the symlink points to rather than the symlink itself
+    if (!realpath(path, real_path)) {
+        strncpy(real_path, path, sizeof(real_path) - 1);
+        real_path[sizeof(real_path) - 1] = '\0';
+    }
+
+    const int ret = snprintf(tmp_path, sizeof(tmp_path), "%s.XXXXXX", real_path);
+    if (ret < 0 || (size_t)ret >= sizeof(tmp_path)) {
+        LOG_ERRF("Path too long to save atomically: %s", real_path);
+        return 1;
+    }
+
+    const int fd = mkstemp(tmp_path);
+    if (fd == -1) {
+        LOG_ERRF("Cannot create temporary file for %s", real_path);
+        return 1;
+    }
+
+    // mkstemp creates files readable only by the user, keep the old permissions
+    if (stat(real_path, &st) == 0) {
+        fchmod(fd, st.st_mode & 07777);
+    } else {
+        fchmod(fd, 0644);
+    }
+
+    if (json_dumpfd(json, fd, JSON_PRESERVE_ORDER | JSON_INDENT(2)) != 0 || fsync(fd) != 0) {
+        LOG_ERRF("Error writing JSON to %s", tmp_path);
+        close(fd);
+        unlink(tmp_path);
+        return 1;
+    }
+
+    if (close(fd) != 0 || rename(tmp_path, real_path) != 0) {
+        LOG_ERRF("Error replacing %s", real_path);
+        unlink(tmp_path);
+        return 1;
+    }
+
+    sync_parent_directory(real_path);
+    return 0;
+}
+
+/**
+ * Writes a job to disk and frees it.
+ *
+ * @param job The job.
+ * @param comparisons Whether the comparisons worker is still there to take
+ *                    the runs appended to the history.
+ *
+ * @return Zero on success, non-zero otherwise.
+ */
+static int run_job(LSSaveJob* job, bool comparisons)
+{
+    int error = 0;
+    size_t position;
+    switch (job->kind) {
+        case LS_SAVE_JSON:
+            error = ls_json_dump_atomic(job->json, job->path);
+            json_decref(job->json);
+            break;
+        case LS_SAVE_HISTORY:
+            error = ls_history_append(job->path, job->run, &position);
+            if (error == 0 && comparisons) {
+                // The comparisons worker takes the run from here
+                ls_comparisons_add_run(job->path, job->run, position);
+            } else {
+                ls_history_run_free(job->run);
+            }
+            break;
+        case LS_SAVE_MIGRATE:
+            ls_history_migrate(job->path);
+            // Only now is the history complete
+            if (comparisons) {
+                ls_comparisons_load(job->path);
+            }
+            break;
+    }
+
+    if (error) {
+        LOG_ERRF("Failed to save %s", job->path);
+        pthread_mutex_lock(&saveQueue.lock);
+        saveQueue.failures++;
+        const LSSaverErrorCallback on_error = saveQueue.on_error;
+        pthread_mutex_unlock(&saveQueue.lock);
+        if (on_error) {
+            on_error(job->path);
+        }
+    }
+    free(job);
+    return error;
+}
+
+/**
+ * Appends a new job at the end of the queue.
+ *
+ * Once the saver thread is gone, the job is written right away instead.
+ *
+ * @param kind What the job writes.
+ * @param path The destination path, or split file for history jobs.
+ * @param json The snapshot to write, if any.
+ * @param run The run to append, if any.
+ *
+ * @return Zero if the job was queued or written, the queue then owns json
+ *         and run. Non-zero otherwise.
+ */
+static int push_job(LSSaveJobKind kind, const char* path, json_t* json, ls_history_run* run)
+{
+    if (strlen(path) >= sizeof(((LSSaveJob*)NULL)->path)) {
+        LOG_ERRF("Path too long to save: %s", path);
+        return 1;
+    }
+    LSSaveJob* job = calloc(1, sizeof(LSSaveJob));
+    if (!job) {
+        LOG_ERRF("Cannot allocate memory to save %s", path);
+        return 1;
+    }
+    job->kind = kind;
+    strcpy(job->path, path);
+    job->json = json;
+    job->run = run;
+
+    pthread_mutex_lock(&saveQueue.lock);
+    if (!saveQueue.running) {
+        // Closed, nobody would write it anymore
+        pthread_mutex_unlock(&saveQueue.lock);
+        return run_job(job, false);
+    }
+    if (saveQueue.tail) {
+        saveQueue.tail->next = job;
+    } else {
+        saveQueue.head = job;
+    }
+    saveQueue.tail = job;
+
+    pthread_cond_signal(&saveQueue.cond);
+    pthread_mutex_unlock(&saveQueue.lock);
+    return 0;
+}
+
+/**
+ * Queues a JSON snapshot to be written to disk by the saver thread.
+ *
+ * If a snapshot for the same path is still waiting, it is replaced, so
+ * a burst of save requests results in a single write of the latest state.
+ *
+ * @param json The snapshot to save, the queue steals this reference.
+ * @param path The destination path.
+ *
+ * @return Zero if the snapshot was queued, non-zero otherwise. Errors while
+ *         writing it are reported by ls_saver_flush and the error callback.
+ */
+int ls_saver_queue(json_t* json, const char* path)
+{
+    if (!json) {
+        return 1;
+    }
+
+    pthread_mutex_lock(&saveQueue.lock);
+    for (LSSaveJob* job = saveQueue.head; job != NULL; job = job->next) {
+        if (job->kind == LS_SAVE_JSON && strcmp(job->path, path) == 0) {
+            // Coalesce with the pending save, only the newest snapshot matters
+            json_decref(job->json);
+            job->json = json;
+            pthread_mutex_unlock(&saveQueue.lock);
+            return 0;
+        }
+    }
+
+    pthread_mutex_unlock(&saveQueue.lock);
+
+    const int error = push_job(LS_SAVE_JSON, path, json, NULL);
+    if (error) {
+        json_decref(json);
+    }
+    return error;
+}
+
+/**
+ * Queues a run to be appended to the history of a split file.
+ *
+ * Unlike snapshots, runs are never coalesced.
+ *
+ * @param run The run to append, the queue takes ownership of it.
+ * @param split_file The path of the split file the run belongs to.
+ *
+ * @return Zero if the run was queued, non-zero otherwise.
+ */
+int ls_saver_queue_run(ls_history_run* run, const char* split_file)
+{
+    if (!run) {
+        return 1;
+    }
+    const int error = push_job(LS_SAVE_HISTORY, split_file, NULL, run);
+    if (error) {
+        ls_history_run_free(run);
+    }
+    return error;
+}
+
+/**
+ * Queues the import of the legacy run files of a split file into its history.
+ *
+ * Queued when a split file is opened, so it always happens before
+ * any run of that split file is appended.
+ *
+ * @param split_file The path of the split file.
+ */
+void ls_saver_queue_migration(const char* split_file)
+{
+    push_job(LS_SAVE_MIGRATE, split_file, NULL, NULL);
+}
+
+/**
+ * Sets the function told about the saves that failed.
+ *
+ * It's called from the saver thread, or from the thread queuing the save
+ * once the saver is closed.
+ *
+ * @param callback The function, NULL for none.
+ */
+void ls_saver_set_error_callback(LSSaverErrorCallback callback)
+{
+    pthread_mutex_lock(&saveQueue.lock);
+    saveQueue.on_error = callback;
+    pthread_mutex_unlock(&saveQueue.lock);
+}
+
+/**
+ * Blocks until every queued snapshot has been written to disk.
+ *
+ * Needed before exiting the process without going through the
+ * normal shutdown, otherwise pending saves would be lost.
+ *
+ * @return The number of saves that failed since the last flush.
+ */
+int ls_saver_flush(void)
+{
+    pthread_mutex_lock(&saveQueue.lock);
+    while (saveQueue.running && (saveQueue.head != NULL || saveQueue.writing)) {
+        pthread_cond_wait(&saveQueue.idle, &saveQueue.lock);
+    }
+    const int failures = (int)saveQueue.failures;
+    saveQueue.failures = 0;
+    pthread_mutex_unlock(&saveQueue.lock);
+    return failures;
+}
+
+/**
+ * Makes the saver thread exit, once all the pending snapshots are written.
+ *
+ * Blocks until then. Saves queued afterwards are written right away, on
+ * the thread queuing them.
+ */
+void ls_saver_close(void)
+{
+    pthread_mutex_lock(&saveQueue.lock);
+    saveQueue.active = false;
+    pthread_cond_signal(&saveQueue.cond);
+    while (saveQueue.running) {
+        pthread_cond_wait(&saveQueue.idle, &saveQueue.lock);
+    }
+    pthread_mutex_unlock(&saveQueue.lock);
+}
+
+/**
+ * The saver thread, writes the queued snapshots to disk.
+ *
+ * Works as a consumer
+ *
+ * @param arg Unused.
+ */
+void* ls_saver_thread(void* arg)
+{
+    prctl(PR_SET_NAME, "LS Saver", 0, 0, 0);
+
+    pthread_mutex_lock(&saveQueue.lock);
+    while (1) {
+        while (saveQueue.head == NULL && saveQueue.active) {
+            pthread_cond_wait(&saveQueue.cond, &saveQueue.lock);
+        }
+        if (saveQueue.head == NULL) {
+            // Closing and nothing left to write
+            break;
+        }
+
+        LSSaveJob* job = saveQueue.head;
+        saveQueue.head = job->next;
+        if (!saveQueue.head) {
+            saveQueue.tail = NULL;
+        }
+        saveQueue.writing = true;
+
+        // Write without holding the lock, so new jobs can be queued meanwhile
+        pthread_mutex_unlock(&saveQueue.lock);
+        run_job(job, true);
+        pthread_mutex_lock(&saveQueue.lock);
+
+        saveQueue.writing = false;
+        if (saveQueue.head == NULL) {
+            pthread_cond_broadcast(&saveQueue.idle);
+        }
+    }
+    saveQueue.running = false;
+    pthread_cond_broadcast(&saveQueue.idle);
+    pthread_mutex_unlock(&saveQueue.lock);
+    return NULL;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "history.h"
+
+#include <jansson.h>
+#include <linux/limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+
+/**
+ * @brief What a save job writes.
+ */
+typedef enum LSSaveJobKind {
+    LS_SAVE_JSON, /*!< Replace a JSON document */
+    LS_SAVE_HISTORY, /*!< Append a run to the history of a split file */
+    LS_SAVE_MIGRATE, /*!< Import the legacy run files of a split file */
+} LSSaveJobKind;
+
+/**
+ * @brief A pending write to disk.
+ */
+typedef struct LSSaveJob {
+    LSSaveJobKind kind; /*!< What to write */
+    char path[PATH_MAX]; /*!< Destination of the document, or the split file for history jobs */
+    json_t* json; /*!< Immutable snapshot to write, owned by the job */
+    ls_history_run* run; /*!< Run to append to the history, owned by the job */
+    struct LSSaveJob* next; /*!< Next job in the queue */
+} LSSaveJob;
+
+/**
+ * @brief Called when a save failed, from whichever thread wrote it.
+ *
+ * @param path The file that couldn't be written.
+ */
+typedef void (*LSSaverErrorCallback)(const char* path);
+
+/** \brief The Save Queue
+ *
+ * FIFO of jobs waiting for the saver thread. JSON jobs targeting a path that
+ * is already queued replace the older snapshot instead of being appended.
+ */
+typedef struct LSSaveQueue {
+    LSSaveJob* head; /*!< Next job to be written */
+    LSSaveJob* tail; /*!< Last queued job */
+    bool writing; /*!< Whether the saver thread is currently writing a job */
+    bool active; /*!< Cleared to make the saver thread exit once the queue is empty */
+    bool running; /*!< Whether the saver thread still takes jobs, saves are written right away otherwise */
+    unsigned int failures; /*!< Saves that failed since the last flush */
+    LSSaverErrorCallback on_error; /*!< Told about every failed save, may be NULL */
+    pthread_mutex_t lock; /*!< Lock to avoid race conditions */
+    pthread_cond_t cond; /*!< Signals new jobs to the saver thread */
+    pthread_cond_t idle; /*!< Signals an empty queue to anyone flushing */
+} LSSaveQueue;
+
+int ls_json_dump_atomic(const json_t* json, const char* path);
+
+int ls_saver_queue(json_t* json, const char* path);
+int ls_saver_queue_run(ls_history_run* run, const char* split_file);
+void ls_saver_queue_migration(const char* split_file);
+void ls_saver_set_error_callback(LSSaverErrorCallback callback);
+int ls_saver_flush(void);
+void ls_saver_close(void);
+
+void* ls_saver_thread(void* arg);
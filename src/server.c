@@ -1,4 +1,5 @@
 #include "shared.h"
+#include "stats.h"
 
 #include <arpa/inet.h>
 #include <gtk/gtk.h>
@@ -85,6 +86,22 @@ int receive_message(int sockfd, CTLMessage** out)
     return 0;
 }
 
+/**
+ * Replies to a stats command with the statistics, as text.
+ *
+ * @param sockfd The socket file descriptor of the client.
+ */
+static void send_stats(int sockfd)
+{
+    char text[4096];
+    const int len = ls_stats_format(text, sizeof(text));
+    const uint32_t header = htonl(len);
+    if (write(sockfd, &header, sizeof(header)) != sizeof(header)
+        || write(sockfd, text, len) != len) {
+        fprintf(stderr, "Failed to send the stats to the client.\n");
+    }
+}
+
 /**
  * The remote control server thread.
  *
@@ -166,11 +183,16 @@ void* ls_ctl_server(void* arg)
             if (result == 0) {
                 if (msg->length == sizeof(CTLCommand)) {
                     CTLCommand command = *(CTLCommand*)msg->message;
-                    CommandData* cmd_data = g_malloc(sizeof(CommandData));
-                    cmd_data->command = command;
-
-                    // Queue command execution on main thread
-                    g_idle_add(execute_command_on_main_thread, cmd_data);
+                    if (command == CTL_CMD_STATS) {
+                        // The stats are thread safe, no need to bother the main thread
+                        send_stats(client_fd);
+                    } else {
+                        CommandData* cmd_data = g_malloc(sizeof(CommandData));
+                        cmd_data->command = command;
+
+                        // Queue command execution on main thread
+                        g_idle_add(execute_command_on_main_thread, cmd_data);
+                    }
                 } else {
                     printf("Invalid message length: %u (expected %zu)\n", msg->length, sizeof(CTLCommand));
                 }
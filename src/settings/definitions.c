@@ -49,17 +49,29 @@ AppConfig cfg = {
             .value.s = "",
             .desc = "Theme Variant (if any)",
         },
+        .layout = {
+            .key = "layout",
+            .type = CFG_STRING,
+            .value.s = LS_DEFAULT_LAYOUT,
+            .desc = "Components to show, in order",
+        },
         .decimals = {
             .key = "timer_decimals",
             .type = CFG_INT,
             .value.i = 2,
             .desc = "Decimals shown on timer",
         },
+        .redraw_rate = {
+            .key = "redraw_rate",
+            .type = CFG_INT,
+            .value.i = 30,
+            .desc = "Redraws per second while running (0 to follow the display)",
+        },
         .save_run_history = {
             .key = "save_run_history",
             .type = CFG_BOOL,
             .value.b = true,
-            .desc = "Save run history JSON files",
+            .desc = "Save the run history",
         },
         .ask_on_gold = {
             .key = "ask_on_gold",
@@ -4,6 +4,9 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+/*! Components shown when neither the settings nor the split file pick them */
+#define LS_DEFAULT_LAYOUT "title,splits,detailed-timer,prev-segment,best-sum,pb,wr"
+
 typedef enum ConfigType {
     CFG_BOOL,
     CFG_INT,
@@ -33,7 +36,9 @@ typedef struct LibreSplitConfig {
     ConfigEntry global_hotkeys;
     ConfigEntry theme;
     ConfigEntry theme_variant;
+    ConfigEntry layout;
     ConfigEntry decimals;
+    ConfigEntry redraw_rate;
     ConfigEntry save_run_history;
     ConfigEntry ask_on_gold;
     ConfigEntry ask_on_worse;
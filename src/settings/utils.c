@@ -93,6 +93,8 @@ void check_directories(void)
     char themes_directory[PATH_MAX];
     char splits_directory[PATH_MAX];
     char runs_directory[PATH_MAX];
+    char theme_cache_directory[PATH_MAX];
+    char lasr_cache_directory[PATH_MAX];
 
     strcpy(auto_splitters_directory, libresplit_directory);
     strcat(auto_splitters_directory, "/auto-splitters");
@@ -106,6 +108,12 @@ void check_directories(void)
     strcpy(runs_directory, libresplit_directory);
     strcat(runs_directory, "/runs");
 
+    strcpy(theme_cache_directory, libresplit_data_directory);
+    strcat(theme_cache_directory, "/theme-cache");
+
+    strcpy(lasr_cache_directory, libresplit_data_directory);
+    strcat(lasr_cache_directory, "/lasr-cache");
+
     // Make the libresplit data directory if it doesn't exist
     mkdir_p(libresplit_data_directory, 0755);
 
@@ -131,4 +139,14 @@ void check_directories(void)
     if (mkdir(runs_directory, 0755) == -1) {
         // Directory already exists or there was an error
     }
+
+    // Make the theme cache directory if it doesn't exist
+    if (mkdir(theme_cache_directory, 0755) == -1) {
+        // Directory already exists or there was an error
+    }
+
+    // Make the auto splitters bytecode cache directory if it doesn't exist
+    if (mkdir(lasr_cache_directory, 0755) == -1) {
+        // Directory already exists or there was an error
+    }
 }
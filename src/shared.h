@@ -17,6 +17,7 @@ typedef enum CTLCommand {
     CTL_CMD_UNSPLIT, /*!< Undo split */
     CTL_CMD_SKIP, /*!< Skip split */
     CTL_CMD_EXIT, /*!< Exit */
+    CTL_CMD_STATS, /*!< Reply with the startup and frame statistics, as a CTLMessage of text */
 } CTLCommand;
 
 /**
@@ -0,0 +1,253 @@
+/** \file stats.c
+ * Runtime statistics, written by the threads doing the work and
+ * read from anywhere, for instance to answer a control command.
+ */
+#include "stats.h"
+#include "logging.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+static ls_frame_stats frame_stats;
+static ls_auto_splitter_stats auto_splitter_stats;
+static ls_startup_phase phases[LS_STATS_MAX_PHASES];
+static size_t phase_count;
+static long long startup_time; /*!< Monotonic time of the first phase */
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Records a frame that was just drawn.
+ *
+ * @param draw_time Time spent drawing the frame, in microseconds.
+ * @param interval Time since the previous frame, 0 if the window was idle.
+ */
+void ls_stats_frame(long long draw_time, long long interval)
+{
+    pthread_mutex_lock(&stats_lock);
+    frame_stats.frames++;
+    frame_stats.last_draw = draw_time;
+    frame_stats.total_draw += draw_time;
+    if (draw_time > frame_stats.max_draw) {
+        frame_stats.max_draw = draw_time;
+    }
+    frame_stats.last_interval = interval;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+/**
+ * Copies the frame statistics.
+ *
+ * @param stats Where to copy the statistics.
+ */
+void ls_stats_get_frames(ls_frame_stats* stats)
+{
+    pthread_mutex_lock(&stats_lock);
+    *stats = frame_stats;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+/**
+ * Finds the histogram bucket of a time.
+ *
+ * @param time The time, in microseconds.
+ *
+ * @return The bucket, see ls_auto_splitter_stats.
+ */
+static size_t histogram_bucket(long long time)
+{
+    size_t bucket = 0;
+    while (time > 0 && bucket < LS_STATS_BUCKETS - 1) {
+        time >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * Records an auto splitter cycle that just ran.
+ *
+ * @param lateness How long after it was due the cycle started, in microseconds.
+ * @param duration Time spent running the cycle, in microseconds.
+ * @param allocations Heap allocations the script made during the cycle.
+ * @param memory Memory used by the script, in bytes.
+ * @param peak_memory Most memory used by the script at once, in bytes.
+ */
+void ls_stats_auto_splitter_cycle(long long lateness, long long duration, unsigned long allocations,
+    size_t memory, size_t peak_memory)
+{
+    pthread_mutex_lock(&stats_lock);
+    auto_splitter_stats.cycles++;
+    auto_splitter_stats.last_cycle = duration;
+    if (duration > auto_splitter_stats.max_cycle) {
+        auto_splitter_stats.max_cycle = duration;
+    }
+    auto_splitter_stats.cycle_histogram[histogram_bucket(duration)]++;
+    auto_splitter_stats.last_lateness = lateness;
+    if (lateness > auto_splitter_stats.max_lateness) {
+        auto_splitter_stats.max_lateness = lateness;
+    }
+    auto_splitter_stats.lateness_histogram[histogram_bucket(lateness)]++;
+    auto_splitter_stats.allocations += allocations;
+    auto_splitter_stats.last_allocations = allocations;
+    auto_splitter_stats.memory = memory;
+    auto_splitter_stats.peak_memory = peak_memory;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+/**
+ * Records auto splitter cycles that were skipped.
+ *
+ * @param cycles The number of cycles skipped.
+ */
+void ls_stats_auto_splitter_skip(unsigned long cycles)
+{
+    pthread_mutex_lock(&stats_lock);
+    auto_splitter_stats.skipped += cycles;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+/**
+ * Copies the auto splitter statistics.
+ *
+ * @param stats Where to copy the statistics.
+ */
+void ls_stats_get_auto_splitter(ls_auto_splitter_stats* stats)
+{
+    pthread_mutex_lock(&stats_lock);
+    *stats = auto_splitter_stats;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+/**
+ * Returns the monotonic time.
+ *
+ * @return The time, in microseconds.
+ */
+static long long monotonic_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/**
+ * Records the end of a startup phase. The first one marks the startup.
+ *
+ * @param name Name of the phase, must outlive the program, like a literal.
+ */
+void ls_stats_phase(const char* name)
+{
+    const long long now = monotonic_time();
+    pthread_mutex_lock(&stats_lock);
+    if (!phase_count) {
+        startup_time = now;
+    }
+    const long long time = now - startup_time;
+    if (phase_count < LS_STATS_MAX_PHASES) {
+        phases[phase_count].name = name;
+        phases[phase_count].time = time;
+        phase_count++;
+    }
+    pthread_mutex_unlock(&stats_lock);
+    LOG_DEBUGF("Startup: %s after %lld us", name, time);
+}
+
+/**
+ * Copies the startup phases recorded so far.
+ *
+ * @param out Where to copy the phases, room for LS_STATS_MAX_PHASES.
+ *
+ * @return The number of phases copied.
+ */
+size_t ls_stats_get_phases(ls_startup_phase* out)
+{
+    pthread_mutex_lock(&stats_lock);
+    const size_t count = phase_count;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = phases[i];
+    }
+    pthread_mutex_unlock(&stats_lock);
+    return count;
+}
+
+/**
+ * Appends formatted text to a buffer, unless it's full.
+ *
+ * @param buffer The buffer.
+ * @param size Size of the buffer.
+ * @param len Length of the text already in the buffer.
+ * @param format The printf format.
+ *
+ * @return The new length of the text, may exceed the size if truncated.
+ */
+static size_t append(char* buffer, size_t size, size_t len, const char* format, ...)
+{
+    if (len >= size) {
+        return len;
+    }
+    va_list args;
+    va_start(args, format);
+    const int written = vsnprintf(&buffer[len], size - len, format, args);
+    va_end(args);
+    return written > 0 ? len + (size_t)written : len;
+}
+
+/**
+ * Writes every statistic as text, for instance to answer a control command.
+ *
+ * @param buffer Where to write the text.
+ * @param size Size of the buffer.
+ *
+ * @return The length of the text, truncated to fit the buffer.
+ */
+int ls_stats_format(char* buffer, size_t size)
+{
+    ls_startup_phase copy[LS_STATS_MAX_PHASES];
+    ls_frame_stats frames;
+    ls_auto_splitter_stats auto_splitter;
+    const size_t count = ls_stats_get_phases(copy);
+    ls_stats_get_frames(&frames);
+    ls_stats_get_auto_splitter(&auto_splitter);
+
+    size_t len = 0;
+    len = append(buffer, size, len, "Startup:\n");
+    for (size_t i = 0; i < count; ++i) {
+        len = append(buffer, size, len, "  %-16s %8.1f ms\n", copy[i].name, copy[i].time / 1000.);
+    }
+    len = append(buffer, size, len, "Frames:\n");
+    len = append(buffer, size, len, "  drawn            %8lu\n", frames.frames);
+    len = append(buffer, size, len, "  last draw        %8.3f ms\n", frames.last_draw / 1000.);
+    len = append(buffer, size, len, "  average draw     %8.3f ms\n",
+        frames.frames ? (double)frames.total_draw / frames.frames / 1000. : 0.);
+    len = append(buffer, size, len, "  longest draw     %8.3f ms\n", frames.max_draw / 1000.);
+    len = append(buffer, size, len, "  last interval    %8.3f ms\n", frames.last_interval / 1000.);
+    len = append(buffer, size, len, "Auto splitter:\n");
+    len = append(buffer, size, len, "  cycles           %8lu\n", auto_splitter.cycles);
+    len = append(buffer, size, len, "  skipped cycles   %8lu\n", auto_splitter.skipped);
+    len = append(buffer, size, len, "  last cycle       %8.3f ms\n", auto_splitter.last_cycle / 1000.);
+    len = append(buffer, size, len, "  longest cycle    %8.3f ms\n", auto_splitter.max_cycle / 1000.);
+    len = append(buffer, size, len, "  last lateness    %8.3f ms\n", auto_splitter.last_lateness / 1000.);
+    len = append(buffer, size, len, "  worst lateness   %8.3f ms\n", auto_splitter.max_lateness / 1000.);
+    len = append(buffer, size, len, "  allocations      %8llu\n", auto_splitter.allocations);
+    len = append(buffer, size, len, "  last allocations %8lu\n", auto_splitter.last_allocations);
+    len = append(buffer, size, len, "  memory           %8.1f KiB\n", auto_splitter.memory / 1024.);
+    len = append(buffer, size, len, "  peak memory      %8.1f KiB\n", auto_splitter.peak_memory / 1024.);
+    len = append(buffer, size, len, "  time        cycle run   lateness\n");
+    for (size_t i = 0; i < LS_STATS_BUCKETS; ++i) {
+        if (!auto_splitter.cycle_histogram[i] && !auto_splitter.lateness_histogram[i]) {
+            continue;
+        }
+        char bucket[16];
+        if (i == LS_STATS_BUCKETS - 1) {
+            snprintf(bucket, sizeof(bucket), ">= %lld us", 1LL << (i - 1));
+        } else {
+            snprintf(bucket, sizeof(bucket), "< %lld us", 1LL << i);
+        }
+        len = append(buffer, size, len, "  %-11s %9lu %10lu\n", bucket,
+            auto_splitter.cycle_histogram[i], auto_splitter.lateness_histogram[i]);
+    }
+
+    return len < size ? (int)len : (int)size - 1;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+
+#define LS_STATS_MAX_PHASES 16 /*!< Startup phases past this many aren't recorded */
+#define LS_STATS_BUCKETS 18 /*!< Buckets of the histograms, the last one holds times from 2^(LS_STATS_BUCKETS - 2) us */
+
+/**
+ * @brief How long frames take to draw and how often they are drawn.
+ * All times are in microseconds.
+ */
+typedef struct ls_frame_stats {
+    unsigned long frames; /*!< Frames drawn since startup */
+    long long last_draw; /*!< Time spent drawing the last frame */
+    long long max_draw; /*!< Longest time spent drawing a frame */
+    long long total_draw; /*!< Time spent drawing all the frames */
+    long long last_interval; /*!< Time between the last two frames, 0 after being idle */
+} ls_frame_stats;
+
+void ls_stats_frame(long long draw_time, long long interval);
+void ls_stats_get_frames(ls_frame_stats* stats);
+
+/**
+ * @brief How long the auto splitter cycles take, how late they start and
+ * how much they allocate. All times are in microseconds.
+ *
+ * The histograms count cycles by powers of two: bucket 0 holds times
+ * under 1 us, bucket i times from 2^(i - 1) to 2^i us.
+ */
+typedef struct ls_auto_splitter_stats {
+    unsigned long cycles; /*!< Cycles run since startup */
+    unsigned long skipped; /*!< Cycles skipped because the previous ones ran late */
+    long long last_cycle; /*!< Time spent running the last cycle */
+    long long max_cycle; /*!< Longest time spent running a cycle */
+    long long last_lateness; /*!< How late the last cycle started */
+    long long max_lateness; /*!< Latest a cycle started */
+    unsigned long cycle_histogram[LS_STATS_BUCKETS]; /*!< Cycles by time spent running them */
+    unsigned long lateness_histogram[LS_STATS_BUCKETS]; /*!< Cycles by how late they started */
+    unsigned long long allocations; /*!< Heap allocations made by the script during all the cycles */
+    unsigned long last_allocations; /*!< Heap allocations made by the script during the last cycle */
+    size_t memory; /*!< Memory used by the script after the last cycle, in bytes */
+    size_t peak_memory; /*!< Most memory used by the script at once, in bytes */
+} ls_auto_splitter_stats;
+
+void ls_stats_auto_splitter_cycle(long long lateness, long long duration, unsigned long allocations,
+    size_t memory, size_t peak_memory);
+void ls_stats_auto_splitter_skip(unsigned long cycles);
+void ls_stats_get_auto_splitter(ls_auto_splitter_stats* stats);
+
+/**
+ * @brief A startup phase and when it ended.
+ */
+typedef struct ls_startup_phase {
+    const char* name; /*!< Name of the phase, a string literal */
+    long long time; /*!< When the phase ended, in microseconds since startup */
+} ls_startup_phase;
+
+void ls_stats_phase(const char* name);
+size_t ls_stats_get_phases(ls_startup_phase* phases);
+
+int ls_stats_format(char* buffer, size_t size);
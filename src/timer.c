@@ -4,8 +4,10 @@
  */
 #include "timer.h"
 #include "gui/dialogs.h"
+#include "history.h"
+#include "journal.h"
 #include "logging.h"
-#include "settings/utils.h"
+#include "saver.h"
 
 #include "lasr/auto-splitter.h"
 
@@ -31,6 +33,17 @@ static long long ls_time_now(void)
     return timespec.tv_sec * 1000000LL + timespec.tv_nsec / 1000;
 }
 
+/**
+ * Reads the monotonic clock, the default clock of every timer
+ *
+ * @param data Unused
+ * @return The current time, in microseconds
+ */
+static long long monotonic_clock_now(void* data)
+{
+    return ls_time_now();
+}
+
 /**
  * Gets the timer current time, either game time or real time depending on the timer state.
  *
@@ -216,57 +229,70 @@ void ls_delta_string(char* string, long long time)
 }
 
 /**
- * Frees the memory allocated for a game struct and sets all its pointers to NULL.
+ * Frees the memory allocated for a game struct.
  *
  * @param game
  */
 void ls_game_release(ls_game* game)
 {
-    if (game->title) {
-        free(game->title);
-        game->title = 0;
-    }
-    if (game->theme) {
-        free(game->theme);
-        game->theme = 0;
-    }
-    if (game->theme_variant) {
-        free(game->theme_variant);
-        game->theme_variant = 0;
-    }
-    if (game->split_titles) {
-        for (unsigned int i = 0; i < game->split_count; ++i) {
-            if (game->split_titles[i]) {
-                free(game->split_titles[i]);
-                game->split_titles[i] = 0;
-            }
-        }
-        free(game->split_titles);
-        game->split_titles = 0;
-    }
-    if (game->split_times) {
-        free(game->split_times);
-        game->split_times = 0;
-    }
-    if (game->split_icon_paths) {
-        free(game->split_icon_paths);
-    }
-    if (game->segment_times) {
-        free(game->segment_times);
-        game->segment_times = 0;
-    }
-    if (game->best_splits) {
-        free(game->best_splits);
-        game->best_splits = 0;
-    }
-    if (game->best_segments) {
-        free(game->best_segments);
-        game->best_segments = 0;
-    }
-
+    free(game->arena);
     free(game);
 }
 
+/**
+ * Returns a string member of a JSON object.
+ *
+ * @param object The JSON object.
+ * @param key The name of the member.
+ * @return The string, NULL if there's no such string member
+ */
+static const char* json_member_string(const json_t* object, const char* key)
+{
+    return json_string_value(json_object_get(object, key));
+}
+
+/**
+ * Returns the size of a string, including its terminator.
+ *
+ * @param string The string, may be NULL.
+ * @return The size, 0 for NULL.
+ */
+static size_t string_size(const char* string)
+{
+    return string ? strlen(string) + 1 : 0;
+}
+
+/**
+ * Copies a string into an arena.
+ *
+ * @param cursor Where the next string goes in the arena, moved past the copy.
+ * @param string The string, may be NULL.
+ * @return The copy, NULL for NULL.
+ */
+static char* arena_strdup(char** cursor, const char* string)
+{
+    if (!string) {
+        return NULL;
+    }
+    const size_t size = strlen(string) + 1;
+    char* copy = memcpy(*cursor, string, size);
+    *cursor += size;
+    return copy;
+}
+
+/**
+ * Loads a split file into a new game.
+ *
+ * Every array and string of the game is carved out of a single arena. The
+ * split_times, segment_times, best_splits and best_segments arrays come
+ * first and in this order, so they are also the image a timer is reset from
+ * with a single copy, see ls_timer.
+ *
+ * @param game_ptr Where to store the game, an old game there is released.
+ * @param path The path of the split file.
+ * @param error_msg Where to store why the split file can't be loaded, to be freed by the caller.
+ * @return Whether the game creation had an error or not
+ */
 int ls_game_create(ls_game** game_ptr, const char* path, char** error_msg)
 {
     int error = 0;
@@ -296,33 +322,6 @@ int ls_game_create(ls_game** game_ptr, const char* path, char** error_msg)
         sprintf(*error_msg, "%s (%d:%d)", json_error.text, json_error.line, json_error.column);
         goto game_create_error;
     }
-    // copy title
-    ref = json_object_get(json, "title");
-    if (ref) {
-        game->title = strdup(json_string_value(ref));
-        if (!game->title) {
-            error = 1;
-            goto game_create_error;
-        }
-    }
-    // copy theme
-    ref = json_object_get(json, "theme");
-    if (ref) {
-        game->theme = strdup(json_string_value(ref));
-        if (!game->theme) {
-            error = 1;
-            goto game_create_error;
-        }
-    }
-    // copy theme variant
-    ref = json_object_get(json, "theme_variant");
-    if (ref) {
-        game->theme_variant = strdup(json_string_value(ref));
-        if (!game->theme_variant) {
-            error = 1;
-            goto game_create_error;
-        }
-    }
     // get attempt count
     ref = json_object_get(json, "attempt_count");
     if (ref) {
@@ -369,106 +368,89 @@ int ls_game_create(ls_game** game_ptr, const char* path, char** error_msg)
         sprintf(*error_msg, "Split file must contain a non-empty splits array");
         goto game_create_error;
     }
-    if (ref) {
-        game->split_count = json_array_size(ref);
+    game->split_count = json_array_size(ref);
 
-        int split_count = game->split_count + 1; // +1 for the final split to end cursor on
+    const size_t split_count = game->split_count + 1; // +1 for the final split to end cursor on
+    static const char* const keys[] = { "title", "theme", "theme_variant", "layout" };
 
-        // allocate titles
-        game->split_titles = calloc(split_count, sizeof(char*));
-        if (!game->split_titles) {
-            error = 1;
-            goto game_create_error;
+    // measure the arena: the times, the string pointers, then the strings
+    size_t size = 4 * split_count * sizeof(long long) + 2 * split_count * sizeof(char*);
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i) {
+        size += string_size(json_member_string(json, keys[i]));
+    }
+    for (unsigned int i = 0; i < game->split_count; ++i) {
+        json_t* split = json_array_get(ref, i);
+        size += string_size(json_member_string(split, "title"));
+        size += string_size(json_member_string(split, "icon"));
+    }
+    game->arena = calloc(1, size);
+    if (!game->arena) {
+        error = 1;
+        goto game_create_error;
+    }
+    long long* times = game->arena;
+    game->split_times = times;
+    game->segment_times = times + split_count;
+    game->best_splits = times + 2 * split_count;
+    game->best_segments = times + 3 * split_count;
+    game->split_titles = (char**)(times + 4 * split_count);
+    game->split_icon_paths = game->split_titles + split_count;
+    char* strings = (char*)(game->split_icon_paths + split_count);
+
+    // copy title, theme, theme variant and layout
+    game->title = arena_strdup(&strings, json_member_string(json, "title"));
+    game->theme = arena_strdup(&strings, json_member_string(json, "theme"));
+    game->theme_variant = arena_strdup(&strings, json_member_string(json, "theme_variant"));
+    game->layout = arena_strdup(&strings, json_member_string(json, "layout"));
+
+    game->contains_icons = false;
+    // copy splits
+    for (unsigned int i = 0; i < game->split_count; ++i) {
+        json_t* split;
+        json_t* split_ref;
+        split = json_array_get(ref, i);
+        game->split_titles[i] = arena_strdup(&strings, json_member_string(split, "title"));
+        game->split_icon_paths[i] = arena_strdup(&strings, json_member_string(split, "icon"));
+        if (game->split_icon_paths[i]) {
+            game->contains_icons = true;
         }
-        // allocate splits
-        game->split_times = calloc(split_count, sizeof(long long));
-        if (!game->split_times) {
-            error = 1;
-            goto game_create_error;
+
+        split_ref = json_object_get(split, "time");
+        if (split_ref) {
+            game->split_times[i] = ls_time_value(
+                json_string_value(split_ref));
         }
-        game->split_icon_paths = calloc(split_count, sizeof(char*));
-        if (!game->split_icon_paths) {
-            error = 1;
-            goto game_create_error;
+
+        // Check whether the split time is 0, if it is set it to max value
+        if (game->split_times[i] == 0) {
+            game->split_times[i] = LLONG_MAX;
         }
-        game->segment_times = calloc(split_count, sizeof(long long));
-        if (!game->segment_times) {
-            error = 1;
-            goto game_create_error;
+        if (i && game->split_times[i] && game->split_times[i - 1]) {
+            game->segment_times[i] = game->split_times[i] - game->split_times[i - 1];
+        } else if (!i && game->split_times[0]) {
+            game->segment_times[0] = game->split_times[0];
         }
-        game->best_splits = calloc(split_count, sizeof(long long));
-        if (!game->best_splits) {
-            error = 1;
-            goto game_create_error;
+
+        if (game->best_splits[i] == 0) {
+            game->best_splits[i] = LLONG_MAX;
         }
-        game->best_segments = calloc(split_count, sizeof(long long));
-        if (!game->best_segments) {
-            error = 1;
-            goto game_create_error;
+        split_ref = json_object_get(split, "best_time");
+        if (split_ref) {
+            game->best_splits[i] = ls_time_value(
+                json_string_value(split_ref));
+        } else if (game->split_times[i]) {
+            game->best_splits[i] = game->split_times[i];
         }
-        game->contains_icons = false;
-        // copy splits
-        for (unsigned int i = 0; i < game->split_count; ++i) {
-            json_t* split;
-            json_t* split_ref;
-            split = json_array_get(ref, i);
-            split_ref = json_object_get(split, "title");
-            if (split_ref) {
-                game->split_titles[i] = strdup(
-                    json_string_value(split_ref));
-                if (!game->split_titles[i]) {
-                    error = 1;
-                    goto game_create_error;
-                }
-            }
 
-            split_ref = json_object_get(split, "icon");
-            if (split_ref) {
-                game->split_icon_paths[i] = strdup(json_string_value(split_ref));
-                if (!game->split_icon_paths[i]) {
-                    error = 1;
-                    goto game_create_error;
-                }
-                game->contains_icons = true;
-            }
-
-            split_ref = json_object_get(split, "time");
-            if (split_ref) {
-                game->split_times[i] = ls_time_value(
-                    json_string_value(split_ref));
-            }
-
-            // Check whether the split time is 0, if it is set it to max value
-            if (game->split_times[i] == 0) {
-                game->split_times[i] = LLONG_MAX;
-            }
-            if (i && game->split_times[i] && game->split_times[i - 1]) {
-                game->segment_times[i] = game->split_times[i] - game->split_times[i - 1];
-            } else if (!i && game->split_times[0]) {
-                game->segment_times[0] = game->split_times[0];
-            }
-
-            if (game->best_splits[i] == 0) {
-                game->best_splits[i] = LLONG_MAX;
-            }
-            split_ref = json_object_get(split, "best_time");
-            if (split_ref) {
-                game->best_splits[i] = ls_time_value(
-                    json_string_value(split_ref));
-            } else if (game->split_times[i]) {
-                game->best_splits[i] = game->split_times[i];
-            }
-
-            if (game->best_segments[i] == 0) {
-                game->best_segments[i] = LLONG_MAX;
-            }
-            split_ref = json_object_get(split, "best_segment");
-            if (split_ref) {
-                game->best_segments[i] = ls_time_value(
-                    json_string_value(split_ref));
-            } else if (game->segment_times[i]) {
-                game->best_segments[i] = game->segment_times[i];
-            }
+        if (game->best_segments[i] == 0) {
+            game->best_segments[i] = LLONG_MAX;
+        }
+        split_ref = json_object_get(split, "best_segment");
+        if (split_ref) {
+            game->best_segments[i] = ls_time_value(
+                json_string_value(split_ref));
+        } else if (game->segment_times[i]) {
+            game->best_segments[i] = game->segment_times[i];
         }
     }
 game_create_error:
@@ -552,9 +534,19 @@ bool ls_timer_has_gold_split(const ls_timer* timer)
     return false;
 }
 
+/**
+ * Saves the split file.
+ *
+ * Only builds a snapshot of the game on the calling thread, the
+ * actual (atomic) write happens on the saver thread, which reports
+ * its errors through ls_saver_flush and its error callback.
+ *
+ * @param game The game to save.
+ *
+ * @return Zero if the save was queued, non-zero otherwise.
+ */
 int ls_game_save(const ls_game* game)
 {
-    int error = 0;
     char str[256];
     json_t* json = json_object();
     json_t* splits = json_array();
@@ -605,142 +597,194 @@ int ls_game_save(const ls_game* game)
         json_object_set_new(json, "theme_variant",
             json_string(game->theme_variant));
     }
+    if (game->layout) {
+        json_object_set_new(json, "layout", json_string(game->layout));
+    }
     if (game->width) {
         json_object_set_new(json, "width", json_integer(game->width));
     }
     if (game->height) {
         json_object_set_new(json, "height", json_integer(game->height));
     }
-    const int json_dump_result = json_dump_file(json, game->path, JSON_PRESERVE_ORDER | JSON_INDENT(2));
-    if (json_dump_result) {
-        printf("Error dumping JSON:\n%s\n", json_dumps(json, JSON_PRESERVE_ORDER | JSON_INDENT(2)));
-        printf("Error: '%d'\n", json_dump_result);
-        printf("Path: %s\n", game->path);
-        error = 1;
-    }
-    json_decref(json);
-    return error;
+    // The snapshot is written (and released) by the saver thread
+    return ls_saver_queue(json, game->path);
 }
 
+/**
+ * Saves the current run in the run history of its split file
+ *
+ * The run is copied right away, the append happens on the saver thread.
+ *
+ * @param timer The timer instance
+ * @param reason Why the run ended, "FINISHED" or "RESET"
+ * @return Zero if the run was queued, non-zero otherwise
+ */
 int ls_run_save(ls_timer* timer, const char* reason)
 {
     if (ls_timer_get_time(timer, true) == 0)
         return 0;
 
-    int error = 0;
-    char final_time_str[128];
-    ls_time_string_serialized(final_time_str, ls_timer_get_time(timer, true));
-
-    // Root JSON Object
-    json_t* json = json_object();
-
-    // Basic Run Info
-    if (timer->game->title) {
-        json_object_set_new(json, "title", json_string(timer->game->title));
-    }
-    if (timer->game->attempt_count) {
-        json_object_set_new(json, "attempt_count", json_integer(timer->game->attempt_count));
+    ls_history_run* run = ls_history_run_new(timer->game->split_count);
+    if (!run) {
+        LOG_ERR("Cannot allocate memory to save the run");
+        return 1;
     }
-    if (timer->game->finished_count) {
-        json_object_set_new(json, "finished_count", json_integer(timer->game->finished_count));
+    run->header.date = time(NULL);
+    run->header.final_time = ls_timer_get_time(timer, true);
+    run->header.splits_reached = timer->curr_split;
+    if (strcmp(reason, "FINISHED") == 0) {
+        run->header.flags |= LS_HISTORY_COMPLETED;
     }
-    json_object_set_new(json, "final_time", json_string(final_time_str));
-    json_object_set_new(json, "reason", json_string(reason));
-
-    // Splits Array
-    json_t* splits = json_array();
 
-    for (unsigned int i = 0; i < timer->game->split_count; i++) {
-        json_t* split = json_object();
-
-        // Title
-        json_object_set_new(split, "title", json_string(timer->game->split_titles[i]));
-
-        // Time
-        if (i < timer->curr_split) {
-            // Check if time > 0, avoids saving time on skipped splits
-            if (timer->split_times[i] > 0 && timer->split_times[i] < LLONG_MAX) {
-                char split_time_str[128];
-                ls_time_string_serialized(split_time_str, timer->split_times[i]);
-                json_object_set_new(split, "time", json_string(split_time_str));
-                // Check if segment time > 0, avoids saving segment time AFTER skipped split
-                if (timer->segment_times[i] > 0 && timer->segment_times[i] < LLONG_MAX) {
-                    char segment_time_str[128];
-                    ls_time_string_serialized(segment_time_str, timer->segment_times[i]);
-                    json_object_set_new(split, "segment", json_string(segment_time_str));
-                } else {
-                    json_object_set_new(split, "segment", json_null());
-                }
-            } else {
-                json_object_set_new(split, "time", json_null());
-                json_object_set_new(split, "segment", json_null());
+    for (unsigned int i = 0; i < timer->curr_split && i < timer->game->split_count; i++) {
+        // Check if time > 0, avoids saving time on skipped splits
+        if (timer->split_times[i] > 0 && timer->split_times[i] < LLONG_MAX) {
+            run->split_times[i] = timer->split_times[i];
+            // Check if segment time > 0, avoids saving segment time AFTER skipped split
+            if (timer->segment_times[i] > 0 && timer->segment_times[i] < LLONG_MAX) {
+                run->segment_times[i] = timer->segment_times[i];
             }
         }
-        json_array_append_new(splits, split);
     }
 
-    json_object_set_new(json, "splits", splits);
+    return ls_saver_queue_run(run, timer->game->path);
+}
 
-    char path[PATH_MAX];
-    get_libresplit_folder_path(path);
-    strncat(path, "/runs", sizeof(path) - strlen(path) - 1);
-
-    time_t rawtime;
-    struct tm* timeinfo;
-    char time_buf[64];
-    time(&rawtime);
-    timeinfo = localtime(&rawtime);
-    strftime(time_buf, sizeof(time_buf), "%Y-%m-%d_%H-%M-%S", timeinfo);
-
-    char filename[PATH_MAX];
-    int ret = snprintf(filename, sizeof(filename), "%s/run_%s.json", path, time_buf);
-    if (ret < 0 || (size_t)ret >= sizeof(filename)) {
-        printf("Error creating run filename. The path may be too long, aborting save.\n");
-        return 1;
-    }
+/**
+ * Frees all the timer information, but not itself
+ *
+ * @param timer The timer instance
+ */
+void ls_timer_release(ls_timer* timer)
+{
+    free(timer->arena);
+    free(timer->events);
+    free(timer);
+}
 
-    const int json_dump_result = json_dump_file(json, filename, JSON_PRESERVE_ORDER | JSON_INDENT(2));
-    if (json_dump_result) {
-        printf("Error dumping JSON:\n%s\n", json_dumps(json, JSON_PRESERVE_ORDER | JSON_INDENT(2)));
-        printf("Error: '%d'\n", json_dump_result);
-        printf("Path: %s\n", filename);
-        error = 1;
+/**
+ * Returns the best time of a segment, from the run or from the split file
+ *
+ * @param timer The timer instance
+ * @param i The index of the segment
+ * @return The best segment time, 0 if unknown
+ */
+static long long best_segment(const ls_timer* timer, unsigned int i)
+{
+    // Check no segments are erroring with LLONG_MAX
+    if (timer->best_segments[i] && timer->best_segments[i] < LLONG_MAX) {
+        return timer->best_segments[i];
     }
-
-    json_decref(json);
-    return error;
+    if (timer->game->best_segments[i] && timer->game->best_segments[i] < LLONG_MAX) {
+        return timer->game->best_segments[i];
+    }
+    return 0;
 }
 
 /**
- * Frees all the timer information, but not itself
+ * Updates the sum of best segments from the best segments tree
  *
  * @param timer The timer instance
  */
-void ls_timer_release(ls_timer* timer)
+static void update_sum_of_bests(ls_timer* timer)
 {
-    if (timer->split_times) {
-        free(timer->split_times);
+    const unsigned int n = timer->game->split_count;
+    if (ls_fenwick_sum(&timer->missing_bests, 0, n)) {
+        timer->sum_of_bests = 0;
+    } else {
+        timer->sum_of_bests = ls_fenwick_sum(&timer->bests, 0, n);
     }
-    if (timer->split_deltas) {
-        free(timer->split_deltas);
+}
+
+/**
+ * Fills a tree, and the tree of its unknown values, with segment times
+ *
+ * @param segments The tree of the segment times
+ * @param missing The tree counting the unknown segment times
+ * @param times The segment times, 0 or LLONG_MAX where unknown
+ */
+static void build_segments(ls_fenwick* segments, ls_fenwick* missing, const long long* times)
+{
+    for (unsigned int i = 0; i < segments->size; ++i) {
+        const bool known = times[i] > 0 && times[i] < LLONG_MAX;
+        segments->values[i] = known ? times[i] : 0;
+        missing->values[i] = !known;
     }
-    if (timer->segment_times) {
-        free(timer->segment_times);
+    ls_fenwick_build(segments);
+    ls_fenwick_build(missing);
+}
+
+/**
+ * Projects the final time of the run, if the rest of it goes like some segments
+ *
+ * @param segments The segment times to project with
+ * @param missing The tree counting the unknown segment times
+ * @param first The first segment of the ongoing stretch, after the last split done
+ * @param curr The current split
+ * @param n The number of splits
+ * @param now The current time of the run
+ * @param elapsed The time spent since the last split done
+ * @return The final time, 0 if unknown
+ */
+static long long project_final_time(const ls_fenwick* segments, const ls_fenwick* missing,
+    unsigned int first, unsigned int curr, unsigned int n, long long now, long long elapsed)
+{
+    if (ls_fenwick_sum(missing, first, n)) {
+        return 0;
     }
-    if (timer->segment_deltas) {
-        free(timer->segment_deltas);
+    const long long ongoing = ls_fenwick_sum(segments, first, curr + 1);
+    return now + (ongoing > elapsed ? ongoing - elapsed : 0) + ls_fenwick_sum(segments, curr + 1, n);
+}
+
+/**
+ * Updates the best possible time, the possible time saves and the pace
+ *
+ * Only sums of ranges of segments are needed, which the trees give in
+ * O(log n), so this is cheap enough to run on every step.
+ *
+ * @param timer The timer instance
+ */
+static void update_live_stats(ls_timer* timer)
+{
+    const unsigned int n = timer->game->split_count;
+    const unsigned int curr = timer->curr_split;
+    timer->best_possible_time = 0;
+    timer->possible_time_save = 0;
+    timer->total_time_save = 0;
+    timer->current_pace = 0;
+    if (!n) {
+        return;
     }
-    if (timer->split_info) {
-        free(timer->split_info);
+    if (curr >= n) {
+        timer->best_possible_time = timer->split_times[n - 1];
+        timer->current_pace = timer->split_times[n - 1];
+        return;
     }
-    if (timer->best_splits) {
-        free(timer->best_splits);
+
+    long long now = timer->started ? ls_timer_get_time(timer, true) : 0;
+    if (now < 0) {
+        now = 0;
     }
-    if (timer->best_segments) {
-        free(timer->best_segments);
+    // After skipped splits, the ongoing stretch covers more than one segment
+    unsigned int first = curr;
+    while (first && !timer->split_times[first - 1]) {
+        --first;
     }
+    const long long since = first ? timer->split_times[first - 1] : 0;
+    const long long elapsed = now > since ? now - since : 0;
+    timer->best_possible_time = project_final_time(&timer->bests, &timer->missing_bests,
+        first, curr, n, now, elapsed);
+    timer->current_pace = project_final_time(&timer->comparison, &timer->missing_comparison,
+        first, curr, n, now, elapsed);
 
-    free(timer);
+    if (!timer->missing_bests.values[curr] && !timer->missing_comparison.values[curr]) {
+        const long long save = timer->comparison.values[curr] - timer->bests.values[curr];
+        timer->possible_time_save = save > 0 ? save : 0;
+    }
+    if (!ls_fenwick_sum(&timer->missing_bests, curr, n) && !ls_fenwick_sum(&timer->missing_comparison, curr, n)) {
+        const long long save = ls_fenwick_sum(&timer->comparison, curr, n) - ls_fenwick_sum(&timer->bests, curr, n);
+        timer->total_time_save = save > 0 ? save : 0;
+    }
 }
 
 /**
@@ -761,27 +805,22 @@ static void reset_timer(ls_timer* timer)
     timer->loading = false;
     timer->loadingTime = 0;
     timer->last_tick = 0;
-    int size = timer->game->split_count * sizeof(long long);
-    memcpy(timer->split_times, timer->game->split_times, size);
-    memset(timer->split_deltas, 0, size);
-    memcpy(timer->segment_times, timer->game->segment_times, size);
-    memset(timer->segment_deltas, 0, size);
-    memcpy(timer->best_splits, timer->game->best_splits, size);
-    memcpy(timer->best_segments, timer->game->best_segments, size);
-    size = timer->game->split_count * sizeof(int);
-    memset(timer->split_info, 0, size);
-    timer->sum_of_bests = 0;
+    timer->event_count = 0;
+    timer->generation++;
+    // The times of the game, then the deltas and infos, see ls_timer
+    const size_t split_count = timer->game->split_count + 1;
+    memcpy(timer->split_times, timer->game->split_times, 4 * split_count * sizeof(long long));
+    memset(timer->split_deltas, 0, 2 * split_count * sizeof(long long) + split_count * sizeof(int));
     for (unsigned int i = 0; i < timer->game->split_count; ++i) {
-        // Check no segments are erroring with LLONG_MAX
-        if (timer->best_segments[i] && timer->best_segments[i] < LLONG_MAX) {
-            timer->sum_of_bests += timer->best_segments[i];
-        } else if (timer->game->best_segments[i] && timer->game->best_segments[i] < LLONG_MAX) {
-            timer->sum_of_bests += timer->game->best_segments[i];
-        } else {
-            timer->sum_of_bests = 0;
-            break;
-        }
-    }
+        timer->bests.values[i] = best_segment(timer, i);
+        timer->missing_bests.values[i] = !timer->bests.values[i];
+    }
+    ls_fenwick_build(&timer->bests);
+    ls_fenwick_build(&timer->missing_bests);
+    // A finished run may have replaced the segments of the personal best
+    build_segments(&timer->comparison, &timer->missing_comparison, timer->comparison_segments);
+    update_sum_of_bests(timer);
+    update_live_stats(timer);
 }
 
 /**
@@ -804,44 +843,37 @@ int ls_timer_create(ls_timer** timer_ptr, ls_game* game)
     timer->game = game;
     timer->attempt_count = &game->attempt_count;
     timer->finished_count = &game->finished_count;
-    // alloc splits
-    int split_count = timer->game->split_count + 1; // +1 for the last invisible "split" that exists to signify no split
-
-    timer->split_times = calloc(split_count, sizeof(long long));
-    if (!timer->split_times) {
-        error = 1;
-        goto timer_create_error;
-    }
-    timer->split_deltas = calloc(split_count, sizeof(long long));
-    if (!timer->split_deltas) {
-        error = 1;
-        goto timer_create_error;
-    }
-    timer->segment_times = calloc(split_count, sizeof(long long));
-    if (!timer->segment_times) {
-        error = 1;
-        goto timer_create_error;
-    }
-    timer->segment_deltas = calloc(split_count, sizeof(long long));
-    if (!timer->segment_deltas) {
-        error = 1;
-        goto timer_create_error;
-    }
-    timer->best_splits = calloc(split_count, sizeof(long long));
-    if (!timer->best_splits) {
-        error = 1;
-        goto timer_create_error;
-    }
-    timer->best_segments = calloc(split_count, sizeof(long long));
-    if (!timer->best_segments) {
-        error = 1;
-        goto timer_create_error;
-    }
-    timer->split_info = calloc(split_count, sizeof(int));
-    if (!timer->split_info) {
+    timer->clock.now = monotonic_clock_now;
+    timer->comparison_splits = game->split_times;
+    timer->comparison_segments = game->segment_times;
+    // alloc the arena, see ls_timer
+    const size_t split_count = timer->game->split_count + 1; // +1 for the last invisible "split" that exists to signify no split
+    const size_t fenwick_size = ls_fenwick_memory(game->split_count);
+    timer->arena = calloc(1, split_count * sizeof(unsigned long)
+            + 6 * split_count * sizeof(long long)
+            + 4 * fenwick_size
+            + split_count * sizeof(int));
+    if (!timer->arena) {
         error = 1;
         goto timer_create_error;
     }
+    timer->split_generations = timer->arena;
+    long long* times = (long long*)(timer->split_generations + split_count);
+    timer->split_times = times;
+    timer->segment_times = times + split_count;
+    timer->best_splits = times + 2 * split_count;
+    timer->best_segments = times + 3 * split_count;
+    char* trees = (char*)(times + 4 * split_count);
+    ls_fenwick_place(&timer->bests, game->split_count, trees);
+    ls_fenwick_place(&timer->missing_bests, game->split_count, trees + fenwick_size);
+    ls_fenwick_place(&timer->comparison, game->split_count, trees + 2 * fenwick_size);
+    ls_fenwick_place(&timer->missing_comparison, game->split_count, trees + 3 * fenwick_size);
+    times = (long long*)(trees + 4 * fenwick_size);
+    timer->split_deltas = times;
+    timer->segment_deltas = times + split_count;
+    timer->split_info = (int*)(times + 2 * split_count);
+
+    build_segments(&timer->comparison, &timer->missing_comparison, timer->comparison_segments);
     reset_timer(timer);
 timer_create_error:
     if (error) {
@@ -862,78 +894,262 @@ timer_create_error:
 }
 
 /**
- * Executes a timer step, calculating deltas, times, and split infos
+ * Returns the current time according to the timer clock
  *
  * @param timer The timer instance
+ * @return The current time, in microseconds
  */
-void ls_timer_step(ls_timer* timer)
+static long long timer_now(const ls_timer* timer)
+{
+    return timer->clock.now(timer->clock.data);
+}
+
+/**
+ * Returns the current time according to the timer clock
+ *
+ * @param timer The timer instance
+ * @return The current time, in microseconds
+ */
+long long ls_timer_now(const ls_timer* timer)
+{
+    return timer_now(timer);
+}
+
+/**
+ * Appends an event to the event log of the current run
+ *
+ * Consecutive game time updates are merged, as only the last one
+ * before any other event affects the run.
+ *
+ * @param timer The timer instance
+ * @param event The event to append
+ */
+static void log_event(ls_timer* timer, const ls_timer_event* event)
+{
+    if (event->type == LS_EVENT_GAME_TIME && timer->event_count
+        && timer->events[timer->event_count - 1].type == LS_EVENT_GAME_TIME) {
+        timer->events[timer->event_count - 1] = *event;
+        return;
+    }
+    if (timer->event_count == timer->event_capacity) {
+        size_t capacity = timer->event_capacity ? timer->event_capacity * 2 : 64;
+        ls_timer_event* events = realloc(timer->events, capacity * sizeof(ls_timer_event));
+        if (!events) {
+            LOG_ERR("Cannot grow the timer event log");
+            return;
+        }
+        timer->events = events;
+        timer->event_capacity = capacity;
+    }
+    timer->events[timer->event_count++] = *event;
+}
+
+/**
+ * Appends an event to the run journal
+ *
+ * Game time updates are too frequent to be journaled one by one, every
+ * journaled event carries the game time at the moment it happened instead.
+ *
+ * @param timer The timer instance
+ * @param event The event to journal
+ */
+static void journal_event(const ls_timer* timer, const ls_timer_event* event)
+{
+    if (timer->replaying || event->type == LS_EVENT_GAME_TIME) {
+        return;
+    }
+    const LSJournalRecord record = {
+        .event = event->type,
+        .time = event->time,
+        .value = event->value,
+        .wall = ls_journal_wall_now(),
+        .game_time = timer->gameTime,
+    };
+    ls_journal_record(&record);
+}
+
+/**
+ * Changes the state of the journaled run, unless replaying it
+ *
+ * @param timer The timer instance
+ * @param state The new state of the run
+ */
+static void journal_set_state(const ls_timer* timer, LSJournalState state)
+{
+    if (!timer->replaying) {
+        ls_journal_set_state(state);
+    }
+}
+
+/**
+ * Calculates the deltas and split info of a split against the comparison
+ *
+ * @param timer The timer instance
+ * @param i The index of the split, its split time must be known
+ */
+static void update_deltas(ls_timer* timer, unsigned int i)
+{
+    const long long comparison_split = timer->comparison_splits[i];
+    const long long comparison_segment = timer->comparison_segments[i];
+    // calc delta and check it's not an error of LLONG_MAX
+    if (comparison_split && comparison_split < LLONG_MAX) {
+        timer->split_deltas[i] = timer->split_times[i] - comparison_split;
+    } else {
+        timer->split_deltas[i] = 0;
+    }
+    // check for behind time
+    if (timer->split_deltas[i] > 0) {
+        timer->split_info[i] |= LS_INFO_BEHIND_TIME;
+    } else {
+        timer->split_info[i] &= ~LS_INFO_BEHIND_TIME;
+    }
+    // For previous segment in footer
+    if ((!i || timer->split_times[i - 1]) && comparison_segment && comparison_segment < LLONG_MAX) {
+        timer->segment_deltas[i] = timer->segment_times[i] - comparison_segment;
+    } else {
+        timer->segment_deltas[i] = 0;
+    }
+    // check for losing time
+    if (i) {
+        if (timer->split_deltas[i] > timer->split_deltas[i - 1]) {
+            timer->split_info[i] |= LS_INFO_LOSING_TIME;
+        } else {
+            timer->split_info[i] &= ~LS_INFO_LOSING_TIME;
+        }
+    } else if (timer->split_deltas[i] > 0) {
+        timer->split_info[i] |= LS_INFO_LOSING_TIME;
+    } else {
+        timer->split_info[i] &= ~LS_INFO_LOSING_TIME;
+    }
+}
+
+/**
+ * Calculates the current split time, deltas and split info
+ *
+ * @param timer The timer instance
+ */
+static void update_current_split(ls_timer* timer)
+{
+    const unsigned int i = timer->curr_split;
+    if (i < timer->game->split_count) {
+        timer->split_times[i] = timer->usingGameTime ? timer->gameTime : timer->realTime - timer->loadingTime;
+        if (!i || timer->split_times[i - 1]) {
+            // calc segment time
+            timer->segment_times[i] = timer->split_times[i];
+            if (i) {
+                timer->segment_times[i] -= timer->split_times[i - 1];
+            }
+        }
+        update_deltas(timer, i);
+        timer->split_generations[i]++;
+    }
+    update_live_stats(timer);
+}
+
+/**
+ * Changes the times the run is compared against
+ *
+ * Deltas of the splits already done are recalculated right away.
+ * The arrays are not copied, they must outlive the timer or
+ * be replaced before being freed.
+ *
+ * @param timer The timer instance
+ * @param split_times Cumulative split times to compare against, NULL for the personal best
+ * @param segment_times Segment times to compare against, NULL for the personal best
+ */
+void ls_timer_set_comparison(ls_timer* timer, const long long* split_times, const long long* segment_times)
+{
+    timer->comparison_splits = split_times ? split_times : timer->game->split_times;
+    timer->comparison_segments = segment_times ? segment_times : timer->game->segment_times;
+    build_segments(&timer->comparison, &timer->missing_comparison, timer->comparison_segments);
+    timer->generation++;
+    for (unsigned int i = 0; i < timer->curr_split && i < timer->game->split_count; ++i) {
+        if (timer->split_times[i]) {
+            update_deltas(timer, i);
+        }
+    }
+    if (timer->running) {
+        update_current_split(timer);
+    } else {
+        update_live_stats(timer);
+    }
+}
+
+/**
+ * Advances the timer up to a given time, accumulating real and loading time
+ *
+ * @param timer The timer instance
+ * @param now The time to advance to
+ */
+static void timer_advance(ls_timer* timer, long long now)
 {
-    long long now = ls_time_now();
     if (timer->running) {
         long long delta = timer->last_tick ? now - timer->last_tick : 0;
         timer->realTime += delta; // Accumulate the elapsed time
         if (timer->loading) {
             timer->loadingTime += delta; // Accumulate loading time if currently loading
         }
-        if (timer->curr_split < timer->game->split_count) {
-            timer->split_times[timer->curr_split] = timer->usingGameTime ? timer->gameTime : timer->realTime - timer->loadingTime;
-            // calc delta and check it's not an error of LLONG_MAX
-            if (timer->game->split_times[timer->curr_split] && timer->game->split_times[timer->curr_split] < LLONG_MAX) {
-                timer->split_deltas[timer->curr_split] = timer->split_times[timer->curr_split]
-                    - timer->game->split_times[timer->curr_split];
-            }
-            // check for behind time
-            if (timer->split_deltas[timer->curr_split] > 0) {
-                timer->split_info[timer->curr_split] |= LS_INFO_BEHIND_TIME;
-            } else {
-                timer->split_info[timer->curr_split] &= ~LS_INFO_BEHIND_TIME;
-            }
-            if (!timer->curr_split || timer->split_times[timer->curr_split - 1]) {
-                // calc segment time and delta
-                timer->segment_times[timer->curr_split] = timer->split_times[timer->curr_split];
-                if (timer->curr_split) {
-                    timer->segment_times[timer->curr_split] -= timer->split_times[timer->curr_split - 1];
-                }
-                // For previous segment in footer
-                if (timer->game->segment_times[timer->curr_split] && timer->game->segment_times[timer->curr_split] < LLONG_MAX) {
-                    timer->segment_deltas[timer->curr_split] = timer->segment_times[timer->curr_split]
-                        - timer->game->segment_times[timer->curr_split];
-                }
-            }
-            // check for losing time
-            if (timer->curr_split) {
-                if (timer->split_deltas[timer->curr_split]
-                    > timer->split_deltas[timer->curr_split - 1]) {
-                    timer->split_info[timer->curr_split]
-                        |= LS_INFO_LOSING_TIME;
-                } else {
-                    timer->split_info[timer->curr_split]
-                        &= ~LS_INFO_LOSING_TIME;
-                }
-            } else if (timer->split_deltas[timer->curr_split] > 0) {
-                timer->split_info[timer->curr_split]
-                    |= LS_INFO_LOSING_TIME;
-            } else {
-                timer->split_info[timer->curr_split]
-                    &= ~LS_INFO_LOSING_TIME;
-            }
-        }
+        update_current_split(timer);
     }
     timer->last_tick = now; // Update the start time for the next iteration
 }
 
 /**
- * Starts the timer, setting it to running and incrementing attempt count if not already started
+ * Applies the loading part of a pause or unpause that happened before the
+ * last step, such as a load seen by the sampler of the auto splitter:
+ * the time since then is moved into or out of the loading time, instead
+ * of advancing the timer backwards.
  *
  * @param timer The timer instance
- * @return Whether the timer is now running
+ * @param event The event, older than the last step
  */
-int ls_timer_start(ls_timer* timer)
+static void timer_backdate(ls_timer* timer, const ls_timer_event* event)
+{
+    const long long late = timer->last_tick - event->time;
+    if (!timer->running) {
+        return;
+    }
+    if (event->type == LS_EVENT_PAUSE && !timer->loading) {
+        timer->loadingTime += late;
+    } else if (event->type == LS_EVENT_UNPAUSE && timer->loading) {
+        timer->loadingTime -= late;
+    }
+    // The load can't have started before the run
+    if (timer->loadingTime > timer->realTime) {
+        timer->loadingTime = timer->realTime;
+    } else if (timer->loadingTime < 0) {
+        timer->loadingTime = 0;
+    }
+    update_current_split(timer);
+}
+
+/**
+ * Executes a timer step, calculating deltas, times, and split infos
+ *
+ * @param timer The timer instance
+ */
+void ls_timer_step(ls_timer* timer)
+{
+    long long now = timer_now(timer);
+    timer_advance(timer, now);
+    if (timer->running) {
+        const LSJournalRecord heartbeat = {
+            .time = now,
+            .wall = ls_journal_wall_now(),
+            .game_time = timer->gameTime,
+        };
+        ls_journal_heartbeat(&heartbeat);
+    }
+}
+
+static int timer_start(ls_timer* timer)
 {
     // TODO: Allow starting when split_count is 0 for splitless runs, other stuff has to change for this to work (components, timer logic, etc)
     if (timer->curr_split < timer->game->split_count) {
         if (!timer->started) {
-            ++*timer->attempt_count;
+            if (timer->replaying != LS_REPLAY_LOG) {
+                ++*timer->attempt_count;
+            }
             timer->started = 1;
             atomic_store(&run_started, true);
         }
@@ -943,13 +1159,13 @@ int ls_timer_start(ls_timer* timer)
     return timer->running;
 }
 
-/**
- * Performs a split
- *
- * @param timer The timer instance
- * @return The current split index after splitting, 0 if no split happened
- */
-int ls_timer_split(ls_timer* timer)
+static void timer_stop(ls_timer* timer)
+{
+    timer->running = false;
+    atomic_store(&run_running, false);
+}
+
+static int timer_split(ls_timer* timer)
 {
     if (ls_timer_get_time(timer, true) <= 0) {
         return 0;
@@ -973,49 +1189,39 @@ int ls_timer_split(ls_timer* timer)
         timer->best_segments[timer->curr_split] = timer->segment_times[timer->curr_split];
         timer->split_info[timer->curr_split]
             |= LS_INFO_BEST_SEGMENT;
-    }
-    // update sum of bests
-    timer->sum_of_bests = 0;
-    for (unsigned int i = 0; i < timer->game->split_count; ++i) {
-        // Check if any best segment is missing/LLONG_MAX
-        if (timer->best_segments[i] && timer->best_segments[i] < LLONG_MAX) {
-            timer->sum_of_bests += timer->best_segments[i];
-        } else if (timer->game->best_segments[i] && timer->game->best_segments[i] < LLONG_MAX) {
-            timer->sum_of_bests += timer->game->best_segments[i];
-        } else {
-            timer->sum_of_bests = 0;
-            break;
-        }
+        // update sum of bests
+        const long long best = best_segment(timer, timer->curr_split);
+        ls_fenwick_set(&timer->bests, timer->curr_split, best);
+        ls_fenwick_set(&timer->missing_bests, timer->curr_split, !best);
+        update_sum_of_bests(timer);
     }
 
     ++timer->curr_split;
     // stop timer if last split
     if (timer->curr_split == timer->game->split_count) {
-        // Increment finished_count
-        ++*timer->finished_count;
-        ls_timer_stop(timer);
-        ls_game_update_splits((ls_game*)timer->game, timer);
-        if (cfg.libresplit.save_run_history.value.b) {
+        timer_stop(timer);
+        journal_set_state(timer, LS_JOURNAL_FINISHED);
+        // A replayed log must leave the split file as it was
+        if (timer->replaying != LS_REPLAY_LOG) {
+            ++*timer->finished_count;
+            ls_game_update_splits((ls_game*)timer->game, timer);
+        }
+        if (cfg.libresplit.save_run_history.value.b && !timer->replaying) {
             ls_run_save(timer, "FINISHED");
         }
     }
+    update_live_stats(timer);
     return timer->curr_split;
 }
 
-/**
- * Skips a split, moving the timer forward one split and setting the split and segment times and deltas to 0
- *
- * @param timer The timer instance
- * @return The current split index after skipping, 0 if no skip happened
- */
-int ls_timer_skip(ls_timer* timer)
+static int timer_skip(ls_timer* timer)
 {
     if (ls_timer_get_time(timer, false) <= 0)
         return 0;
 
     if (timer->curr_split + 1 == timer->game->split_count) {
         // This is the last split, do a normal split instead of skipping
-        return ls_timer_split(timer);
+        return timer_split(timer);
     }
 
     if (timer->curr_split >= timer->game->split_count) {
@@ -1027,21 +1233,22 @@ int ls_timer_skip(ls_timer* timer)
     timer->split_info[timer->curr_split] = 0;
     timer->segment_times[timer->curr_split] = 0;
     timer->segment_deltas[timer->curr_split] = 0;
-    return ++timer->curr_split;
+    ++timer->curr_split;
+    update_live_stats(timer);
+    return timer->curr_split;
 }
 
-/**
- * Unsplits the last split, moving the timer back one split and resetting the split and segment times and deltas to the game times
- *
- * @param timer The timer instance
- * @return The current split index after unsplitting, the same or 0 if no unsplit happened
- */
-int ls_timer_unsplit(ls_timer* timer)
+static int timer_unsplit(ls_timer* timer)
 {
     if (timer->curr_split == 0) {
         return 0;
     }
 
+    if (timer->curr_split == timer->game->split_count) {
+        // The run isn't finished anymore
+        journal_set_state(timer, LS_JOURNAL_RUNNING);
+    }
+
     unsigned int curr = --timer->curr_split;
     for (unsigned int i = curr; i < timer->game->split_count; ++i) {
         timer->split_times[i] = timer->game->split_times[i];
@@ -1054,9 +1261,140 @@ int ls_timer_unsplit(ls_timer* timer)
         timer->running = true;
         atomic_store(&run_running, true);
     }
+    update_live_stats(timer);
     return timer->curr_split;
 }
 
+/**
+ * Applies an event to the timer, the only way the state of a run changes
+ *
+ * The timer is first advanced to the time of the event, so the result
+ * only depends on the sequence of events and not on how often the timer
+ * is stepped. The event is then recorded in the event log and the journal.
+ *
+ * @param timer The timer instance
+ * @param event The event to apply
+ * @return The result of the matching ls_timer_* action, 0 for events without one
+ */
+int ls_timer_apply_event(ls_timer* timer, const ls_timer_event* event)
+{
+    int result = 0;
+    if (event->time < timer->last_tick) {
+        timer_backdate(timer, event);
+    } else {
+        timer_advance(timer, event->time);
+    }
+
+    if (event->type == LS_EVENT_START && !timer->started && !timer->replaying) {
+        // A new run begins, so does its journal
+        ls_journal_begin(timer->game->path, timer->game->split_count);
+    }
+    log_event(timer, event);
+    journal_event(timer, event);
+    if (event->type != LS_EVENT_GAME_TIME) {
+        // Game time only ever changes the current split, tracked below
+        timer->generation++;
+    }
+
+    switch (event->type) {
+        case LS_EVENT_START:
+            result = timer_start(timer);
+            break;
+        case LS_EVENT_SPLIT:
+            result = timer_split(timer);
+            break;
+        case LS_EVENT_SKIP:
+            result = timer_skip(timer);
+            break;
+        case LS_EVENT_UNSPLIT:
+            result = timer_unsplit(timer);
+            break;
+        case LS_EVENT_PAUSE:
+            timer->loading = 1;
+            break;
+        case LS_EVENT_UNPAUSE:
+            timer->loading = 0;
+            break;
+        case LS_EVENT_STOP:
+            timer_stop(timer);
+            break;
+        case LS_EVENT_GAME_TIME:
+            timer->gameTime = event->value;
+            break;
+        case LS_EVENT_USE_GAME_TIME:
+            timer->usingGameTime = event->value;
+            break;
+    }
+
+    if (timer->running) {
+        // Make the new state visible right away, without waiting for a step
+        update_current_split(timer);
+    }
+    return result;
+}
+
+/**
+ * Applies an event of the given type, happening now
+ *
+ * @param timer The timer instance
+ * @param type The type of the event
+ * @param value The argument of the event
+ * @return The result of ls_timer_apply_event
+ */
+static int timer_event(ls_timer* timer, ls_timer_event_type type, long long value)
+{
+    const ls_timer_event event = {
+        .type = type,
+        .time = timer_now(timer),
+        .value = value,
+    };
+    return ls_timer_apply_event(timer, &event);
+}
+
+/**
+ * Starts the timer, setting it to running and incrementing attempt count if not already started
+ *
+ * @param timer The timer instance
+ * @return Whether the timer is now running
+ */
+int ls_timer_start(ls_timer* timer)
+{
+    return timer_event(timer, LS_EVENT_START, 0);
+}
+
+/**
+ * Performs a split
+ *
+ * @param timer The timer instance
+ * @return The current split index after splitting, 0 if no split happened
+ */
+int ls_timer_split(ls_timer* timer)
+{
+    return timer_event(timer, LS_EVENT_SPLIT, 0);
+}
+
+/**
+ * Skips a split, moving the timer forward one split and setting the split and segment times and deltas to 0
+ *
+ * @param timer The timer instance
+ * @return The current split index after skipping, 0 if no skip happened
+ */
+int ls_timer_skip(ls_timer* timer)
+{
+    return timer_event(timer, LS_EVENT_SKIP, 0);
+}
+
+/**
+ * Unsplits the last split, moving the timer back one split and resetting the split and segment times and deltas to the game times
+ *
+ * @param timer The timer instance
+ * @return The current split index after unsplitting, the same or 0 if no unsplit happened
+ */
+int ls_timer_unsplit(ls_timer* timer)
+{
+    return timer_event(timer, LS_EVENT_UNSPLIT, 0);
+}
+
 /**
  * Marks the timer as loading, incrementing loading time in step until unpaused
  *
@@ -1064,7 +1402,7 @@ int ls_timer_unsplit(ls_timer* timer)
  */
 void ls_timer_pause(ls_timer* timer)
 {
-    timer->loading = 1;
+    timer_event(timer, LS_EVENT_PAUSE, 0);
 }
 
 /**
@@ -1074,7 +1412,37 @@ void ls_timer_pause(ls_timer* timer)
  */
 void ls_timer_unpause(ls_timer* timer)
 {
-    timer->loading = 0;
+    timer_event(timer, LS_EVENT_UNPAUSE, 0);
+}
+
+/**
+ * Marks the timer as loading since a given time, which may have passed
+ *
+ * @param timer The timer instance
+ * @param time When the load started, according to the timer clock
+ */
+void ls_timer_pause_at(ls_timer* timer, long long time)
+{
+    const ls_timer_event event = {
+        .type = LS_EVENT_PAUSE,
+        .time = time,
+    };
+    ls_timer_apply_event(timer, &event);
+}
+
+/**
+ * Marks the timer as not loading since a given time, which may have passed
+ *
+ * @param timer The timer instance
+ * @param time When the load ended, according to the timer clock
+ */
+void ls_timer_unpause_at(ls_timer* timer, long long time)
+{
+    const ls_timer_event event = {
+        .type = LS_EVENT_UNPAUSE,
+        .time = time,
+    };
+    ls_timer_apply_event(timer, &event);
 }
 
 /**
@@ -1084,8 +1452,68 @@ void ls_timer_unpause(ls_timer* timer)
  */
 void ls_timer_stop(ls_timer* timer)
 {
-    timer->running = false;
-    atomic_store(&run_running, false);
+    timer_event(timer, LS_EVENT_STOP, 0);
+}
+
+/**
+ * Updates the game time, as reported by the auto splitter
+ *
+ * @param timer The timer instance
+ * @param game_time The new game time
+ */
+void ls_timer_set_game_time(ls_timer* timer, long long game_time)
+{
+    timer_event(timer, LS_EVENT_GAME_TIME, game_time);
+}
+
+/**
+ * Switches the timer between game time and real time
+ *
+ * @param timer The timer instance
+ * @param use_game_time Whether to use game time
+ */
+void ls_timer_use_game_time(ls_timer* timer, bool use_game_time)
+{
+    timer_event(timer, LS_EVENT_USE_GAME_TIME, use_game_time);
+}
+
+/**
+ * Replaces the clock the timer takes the current time from
+ *
+ * @param timer The timer instance
+ * @param clock The new clock
+ */
+void ls_timer_set_clock(ls_timer* timer, ls_clock clock)
+{
+    timer->clock = clock;
+    // Times from the old clock mean nothing to the new one
+    timer->last_tick = 0;
+}
+
+/**
+ * Replays a recorded run through the timer
+ *
+ * The timer is reset, then every event is applied in order. Since the
+ * timer is only advanced to the time of each event, a run is replayed
+ * as fast as the split logic allows, no matter how long it lasted.
+ * Replaying doesn't journal anything nor save the run history, and
+ * leaves the linked game alone: no attempt nor finished run is counted
+ * and its splits aren't updated.
+ *
+ * @param timer The timer instance
+ * @param events The events to replay, must not be the timer own event log
+ * @param count The number of events
+ * @return The number of events replayed
+ */
+int ls_timer_replay(ls_timer* timer, const ls_timer_event* events, size_t count)
+{
+    timer->replaying = LS_REPLAY_LOG;
+    reset_timer(timer);
+    for (size_t i = 0; i < count; ++i) {
+        ls_timer_apply_event(timer, &events[i]);
+    }
+    timer->replaying = LS_REPLAY_NONE;
+    return (int)count;
 }
 
 /**
@@ -1124,6 +1552,7 @@ int ls_timer_reset(ls_timer* timer)
     }
 
     reset_timer(timer);
+    journal_set_state(timer, LS_JOURNAL_IDLE);
     return 1;
 }
 
@@ -1145,5 +1574,55 @@ int ls_timer_cancel(ls_timer* timer)
         }
     }
     reset_timer(timer);
+    journal_set_state(timer, LS_JOURNAL_IDLE);
+    return 1;
+}
+
+/**
+ * Restores the run in progress from the run journal
+ *
+ * Replays every journaled event, then accounts for the time that
+ * passed while LibreSplit was down.
+ *
+ * @param timer The timer instance, freshly created for the journaled split file
+ * @return Whether a run was restored
+ */
+int ls_timer_restore(ls_timer* timer)
+{
+    size_t count;
+    const LSJournalRecord* records = ls_journal_records(&count);
+    const LSJournalRecord* heartbeat = ls_journal_last_heartbeat();
+    if (!records || !count || !heartbeat) {
+        return 0;
+    }
+
+    timer->replaying = LS_REPLAY_JOURNAL;
+    for (size_t i = 0; i < count; ++i) {
+        // Game time updates aren't journaled, bring it up to date first
+        const ls_timer_event game_time = { LS_EVENT_GAME_TIME, records[i].time, records[i].game_time };
+        const ls_timer_event event = { records[i].event, records[i].time, records[i].value };
+        ls_timer_apply_event(timer, &game_time);
+        ls_timer_apply_event(timer, &event);
+    }
+
+    // Resume from the latest known state
+    if (heartbeat->time > records[count - 1].time) {
+        const ls_timer_event game_time = { LS_EVENT_GAME_TIME, heartbeat->time, heartbeat->game_time };
+        ls_timer_apply_event(timer, &game_time);
+    }
+    if (timer->running) {
+        // Real time kept going while LibreSplit was down
+        const long long downtime = ls_journal_wall_now() - heartbeat->wall;
+        if (downtime > 0) {
+            timer->realTime += downtime;
+            if (timer->loading) {
+                timer->loadingTime += downtime;
+            }
+        }
+        update_current_split(timer);
+    }
+    // The journal times come from a clock that may be gone, start ticking anew
+    timer->last_tick = 0;
+    timer->replaying = LS_REPLAY_NONE;
     return 1;
 }
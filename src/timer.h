@@ -1,8 +1,10 @@
 #pragma once
 
+#include "src/fenwick.h"
 #include "src/settings/definitions.h"
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #define LS_INFO_BEHIND_TIME (1 << 0)
 #define LS_INFO_LOSING_TIME (1 << 1)
@@ -16,6 +18,7 @@ typedef struct ls_game {
     char* title;
     char* theme;
     char* theme_variant;
+    char* layout; /*!< Components to show, NULL to use the settings */
     int attempt_count;
     int finished_count;
     int width;
@@ -30,11 +33,60 @@ typedef struct ls_game {
     long long* segment_times;
     long long* best_splits;
     long long* best_segments;
+    void* arena; /*!< Single allocation holding every array and string of the game */
 } ls_game;
 
+/**
+ * @brief A source of time for the timer.
+ * Defaults to the monotonic clock, can be replaced to drive the timer deterministically.
+ */
+typedef struct ls_clock {
+    long long (*now)(void* data); /*!< Returns the current time, in microseconds */
+    void* data; /*!< Passed as is to now() */
+} ls_clock;
+
+/**
+ * @brief The kind of a timer event.
+ */
+typedef enum ls_timer_event_type {
+    LS_EVENT_START,
+    LS_EVENT_SPLIT,
+    LS_EVENT_SKIP,
+    LS_EVENT_UNSPLIT,
+    LS_EVENT_PAUSE,
+    LS_EVENT_UNPAUSE,
+    LS_EVENT_STOP,
+    LS_EVENT_GAME_TIME, /*!< value is the new game time */
+    LS_EVENT_USE_GAME_TIME, /*!< value is whether to use game time */
+} ls_timer_event_type;
+
+/**
+ * @brief Something that happened to the timer at a given time.
+ * The state of a run is fully determined by its sequence of events.
+ */
+typedef struct ls_timer_event {
+    ls_timer_event_type type; /*!< What happened */
+    long long time; /*!< When it happened, according to the timer clock */
+    long long value; /*!< Argument of the event, if any */
+} ls_timer_event;
+
+/**
+ * @brief Where the events applied to a timer come from.
+ */
+typedef enum ls_timer_replay_mode {
+    LS_REPLAY_NONE, /*!< Live events, journaled and saved */
+    LS_REPLAY_JOURNAL, /*!< The run is restored from the journal, its events aren't journaled again nor saved */
+    LS_REPLAY_LOG, /*!< Events replayed by ls_timer_replay, which don't change the game either */
+} ls_timer_replay_mode;
+
 /**
  * @brief Timer structure for managing game and time.
  * Timer structure, it includes RTA, gametime, loading time, splits, deltas, and other relevant information for tracking the progress of a run.
+ *
+ * Every per split array lives in a single arena. split_times, segment_times,
+ * best_splits and best_segments are laid out like in the game, which is
+ * copied over them in one go on reset, and the deltas and split infos that
+ * a reset clears are contiguous too.
  */
 typedef struct ls_timer {
     bool usingGameTime; /*!< Splitter is using game time instead of real time. Only to be used internally */
@@ -58,6 +110,26 @@ typedef struct ls_timer {
     long long last_tick; // This NEEDS to be here for resetting
     int* attempt_count;
     int* finished_count;
+    ls_clock clock; /*!< Where the timer takes the current time from */
+    ls_timer_event* events; /*!< Events of the current run, in order */
+    size_t event_count; /*!< Number of events of the current run */
+    size_t event_capacity; /*!< Number of events that fit in the events array */
+    ls_timer_replay_mode replaying; /*!< Where the events being applied come from */
+    const long long* comparison_splits; /*!< Split times the run is compared against */
+    const long long* comparison_segments; /*!< Segment times the run is compared against */
+    const struct ls_run_graph* graph; /*!< Graphs of the run history, NULL until computed */
+    const struct ls_comparisons* comparisons; /*!< Every comparison of the run history, NULL until computed */
+    ls_fenwick bests; /*!< Best segments, 0 where unknown */
+    ls_fenwick missing_bests; /*!< 1 for every segment without a best time */
+    ls_fenwick comparison; /*!< Segments of the comparison, 0 where unknown */
+    ls_fenwick missing_comparison; /*!< 1 for every segment the comparison doesn't know */
+    long long best_possible_time; /*!< Best final time the run can still get, 0 if unknown */
+    long long possible_time_save; /*!< Time the comparison loses to the best segment on the current split, 0 if unknown */
+    long long total_time_save; /*!< Same as possible_time_save, for the current and all the following splits */
+    long long current_pace; /*!< Final time if the rest of the run goes like the comparison, 0 if unknown */
+    unsigned long generation; /*!< Bumped whenever the run changes in a way that may affect any split */
+    unsigned long* split_generations; /*!< Bumped whenever a single split changes, like the live one */
+    void* arena; /*!< Single allocation holding every per split array */
 } ls_timer;
 
 extern atomic_bool run_started;
@@ -88,6 +160,8 @@ void ls_game_release(ls_game* game);
 
 int ls_timer_create(ls_timer** timer_ptr, ls_game* game);
 
+long long ls_timer_now(const ls_timer* timer);
+
 void ls_timer_release(ls_timer* timer);
 
 int ls_timer_start(ls_timer* timer);
@@ -104,8 +178,26 @@ void ls_timer_pause(ls_timer* timer);
 
 void ls_timer_unpause(ls_timer* timer);
 
+void ls_timer_pause_at(ls_timer* timer, long long time);
+
+void ls_timer_unpause_at(ls_timer* timer, long long time);
+
 void ls_timer_stop(ls_timer* timer);
 
 int ls_timer_reset(ls_timer* timer);
 
 int ls_timer_cancel(ls_timer* timer);
+
+int ls_timer_restore(ls_timer* timer);
+
+void ls_timer_set_clock(ls_timer* timer, ls_clock clock);
+
+void ls_timer_set_comparison(ls_timer* timer, const long long* split_times, const long long* segment_times);
+
+void ls_timer_set_game_time(ls_timer* timer, long long game_time);
+
+void ls_timer_use_game_time(ls_timer* timer, bool use_game_time);
+
+int ls_timer_apply_event(ls_timer* timer, const ls_timer_event* event);
+
+int ls_timer_replay(ls_timer* timer, const ls_timer_event* events, size_t count);
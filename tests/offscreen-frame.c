@@ -0,0 +1,176 @@
+/** \file offscreen-frame.c
+ *
+ * Starts LibreSplit rendering offscreen and waits for it to publish a frame
+ * in shared memory. Needs a display, run it under Xvfb.
+ *
+ * Usage: test-offscreen-frame <path to libresplit>
+ */
+#include "src/gui/offscreen.h"
+
+#include <fcntl.h>
+#include <linux/limits.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define FRAME_WIDTH 320
+#define FRAME_HEIGHT 240
+#define TIMEOUT 20 /*!< How long to wait for a frame, in seconds */
+
+/**
+ * Reads the latest frame published in shared memory.
+ *
+ * @param fd The shared memory file.
+ * @param header Where to copy the header.
+ *
+ * @return The pixels of the frame, to be freed, or NULL if no whole frame was published.
+ */
+static uint8_t* read_frame(int fd, ls_offscreen_header* header)
+{
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(ls_offscreen_header)) {
+        return NULL;
+    }
+    const size_t map_size = st.st_size;
+    const uint8_t* shm = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (shm == MAP_FAILED) {
+        return NULL;
+    }
+    const uint32_t sequence = ((const ls_offscreen_header*)shm)->sequence;
+    atomic_thread_fence(memory_order_acquire);
+    memcpy(header, shm, sizeof(ls_offscreen_header));
+    const size_t pixels_size = (size_t)header->stride * header->height;
+    uint8_t* pixels = NULL;
+    if (header->frame && pixels_size && sizeof(ls_offscreen_header) + pixels_size <= map_size) {
+        pixels = malloc(pixels_size);
+        if (pixels) {
+            memcpy(pixels, shm + sizeof(ls_offscreen_header), pixels_size);
+        }
+    }
+    atomic_thread_fence(memory_order_acquire);
+    if ((sequence & 1) || sequence != ((const ls_offscreen_header*)shm)->sequence) {
+        free(pixels);
+        pixels = NULL;
+    }
+    munmap((void*)shm, map_size);
+    return pixels;
+}
+
+/**
+ * Counts the pixels of a frame that differ from its top left one, which
+ * is the window background.
+ *
+ * @param header The header of the frame.
+ * @param pixels The pixels of the frame.
+ *
+ * @return The number of pixels drawn over the background.
+ */
+static size_t count_drawn_pixels(const ls_offscreen_header* header, const uint8_t* pixels)
+{
+    uint32_t background;
+    memcpy(&background, pixels, sizeof(background));
+    size_t count = 0;
+    for (uint32_t y = 0; y < header->height; ++y) {
+        for (uint32_t x = 0; x < header->width; ++x) {
+            uint32_t pixel;
+            memcpy(&pixel, pixels + (size_t)y * header->stride + x * 4, sizeof(pixel));
+            if (pixel != background) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2) {
+        printf("Usage: %s <path to libresplit>\n", argv[0]);
+        return 1;
+    }
+
+    char dir[] = "/tmp/libresplit-offscreen-XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("Cannot create the test directory");
+        return 1;
+    }
+    char shm_path[PATH_MAX];
+    snprintf(shm_path, sizeof(shm_path), "%s/frame", dir);
+    const int fd = open(shm_path, O_RDWR | O_CREAT, 0600);
+    if (fd == -1) {
+        perror("Cannot create the shared memory file");
+        return 1;
+    }
+
+    const pid_t pid = fork();
+    if (pid == 0) {
+        char size[32];
+        snprintf(size, sizeof(size), "%dx%d", FRAME_WIDTH, FRAME_HEIGHT);
+        // Keep the settings and history of the user out of it
+        setenv("XDG_CONFIG_HOME", dir, 1);
+        setenv("XDG_DATA_HOME", dir, 1);
+        setenv("BYPASS_ROOT_PROTECTION_CHECKS", "1", 1);
+        setenv("LIBRESPLIT_OFFSCREEN_SHM", shm_path, 1);
+        setenv("LIBRESPLIT_OFFSCREEN_SIZE", size, 1);
+        execl(argv[1], argv[1], (char*)NULL);
+        perror("Cannot start LibreSplit");
+        _exit(127);
+    }
+    if (pid == -1) {
+        perror("Cannot start LibreSplit");
+        return 1;
+    }
+
+    ls_offscreen_header header;
+    uint8_t* pixels = NULL;
+    int status;
+    for (int i = 0; i < TIMEOUT * 10 && !pixels; ++i) {
+        if (waitpid(pid, &status, WNOHANG) == pid) {
+            printf("LibreSplit exited before publishing a frame\n");
+            return 1;
+        }
+        usleep(100000);
+        pixels = read_frame(fd, &header);
+    }
+    kill(pid, SIGTERM);
+    waitpid(pid, &status, 0);
+    close(fd);
+    // LibreSplit filled it with its settings and data directories
+    char command[PATH_MAX + 16];
+    snprintf(command, sizeof(command), "rm -rf '%s'", dir);
+    if (system(command) != 0) {
+        printf("Cannot remove %s\n", dir);
+    }
+
+    int failures = 0;
+    if (!pixels) {
+        printf("No frame published after %d seconds\n", TIMEOUT);
+        failures++;
+    } else {
+        if (header.magic != LS_OFFSCREEN_MAGIC) {
+            printf("magic: %08x, expected %08x\n", header.magic, LS_OFFSCREEN_MAGIC);
+            failures++;
+        }
+        // The size asked for is a minimum, the components may need more
+        if (header.width < FRAME_WIDTH || header.height < FRAME_HEIGHT) {
+            printf("size: %ux%u, expected at least %dx%d\n", header.width, header.height, FRAME_WIDTH, FRAME_HEIGHT);
+            failures++;
+        }
+        if (header.stride < header.width * 4) {
+            printf("stride: %u, narrower than the frame\n", header.stride);
+            failures++;
+        } else if (!count_drawn_pixels(&header, pixels)) {
+            // With no split file loaded, the welcome text at least
+            printf("The frame is only background\n");
+            failures++;
+        }
+    }
+    free(pixels);
+    return failures ? 1 : 0;
+}
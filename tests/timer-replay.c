@@ -0,0 +1,181 @@
+/** \file timer-replay.c
+ *
+ * Replays recorded runs through the timer and checks the times they end with.
+ */
+#include "src/settings/definitions.h"
+#include "src/timer.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define S 1000000LL /*!< A second, in microseconds */
+
+atomic_bool exit_requested = 0; /*!< Defined by main.c in LibreSplit itself */
+extern AppConfig cfg;
+
+static int failures = 0; /*!< Number of failed checks */
+
+/**
+ * Checks a time, reporting it if it's not the expected one.
+ *
+ * @param what What the time is.
+ * @param time The time.
+ * @param expected The expected time.
+ */
+static void check_time(const char* what, long long time, long long expected)
+{
+    if (time != expected) {
+        printf("%s: %lld, expected %lld\n", what, time, expected);
+        failures++;
+    }
+}
+
+/**
+ * Skipping a split and unsplitting right away continues the run as if the
+ * skip never happened.
+ *
+ * @param timer A timer on a game with 3 splits.
+ */
+static void replay_skip_unsplit(ls_timer* timer)
+{
+    const ls_timer_event events[] = {
+        { LS_EVENT_START, 1 * S, 0 },
+        { LS_EVENT_SPLIT, 11 * S, 0 },
+        { LS_EVENT_SKIP, 15 * S, 0 },
+        { LS_EVENT_UNSPLIT, 16 * S, 0 },
+        { LS_EVENT_SPLIT, 21 * S, 0 },
+        { LS_EVENT_SPLIT, 31 * S, 0 },
+    };
+    ls_timer_replay(timer, events, sizeof(events) / sizeof(events[0]));
+
+    check_time("skip/unsplit: final time", ls_timer_get_time(timer, true), 30 * S);
+    check_time("skip/unsplit: split 2", timer->split_times[1], 20 * S);
+    check_time("skip/unsplit: segment 2", timer->segment_times[1], 10 * S);
+    check_time("skip/unsplit: running", timer->running, 0);
+}
+
+/**
+ * A load going on while splitting is removed from both segments.
+ *
+ * @param timer A timer on a game with 3 splits.
+ */
+static void replay_pause_across_split(ls_timer* timer)
+{
+    const ls_timer_event events[] = {
+        { LS_EVENT_START, 1 * S, 0 },
+        { LS_EVENT_PAUSE, 6 * S, 0 },
+        { LS_EVENT_SPLIT, 8 * S, 0 },
+        { LS_EVENT_UNPAUSE, 10 * S, 0 },
+        { LS_EVENT_SPLIT, 13 * S, 0 },
+        { LS_EVENT_SPLIT, 15 * S, 0 },
+    };
+    ls_timer_replay(timer, events, sizeof(events) / sizeof(events[0]));
+
+    check_time("pause: final time", ls_timer_get_time(timer, true), 10 * S);
+    check_time("pause: real time", ls_timer_get_time(timer, false), 14 * S);
+    check_time("pause: split 1", timer->split_times[0], 5 * S);
+    check_time("pause: segment 2", timer->segment_times[1], 3 * S);
+}
+
+/**
+ * Switching to game time takes the splits from the game time.
+ *
+ * @param timer A timer on a game with 3 splits.
+ */
+static void replay_game_time(ls_timer* timer)
+{
+    const ls_timer_event events[] = {
+        { LS_EVENT_START, 1 * S, 0 },
+        { LS_EVENT_USE_GAME_TIME, 1 * S, 1 },
+        { LS_EVENT_GAME_TIME, 3 * S, 2 * S },
+        { LS_EVENT_SPLIT, 3 * S, 0 },
+        { LS_EVENT_GAME_TIME, 7 * S, 5 * S },
+        { LS_EVENT_SPLIT, 7 * S, 0 },
+        { LS_EVENT_GAME_TIME, 12 * S, 9 * S },
+        { LS_EVENT_SPLIT, 12 * S, 0 },
+    };
+    ls_timer_replay(timer, events, sizeof(events) / sizeof(events[0]));
+
+    check_time("game time: final time", ls_timer_get_time(timer, true), 9 * S);
+    check_time("game time: real time", timer->realTime, 11 * S);
+    check_time("game time: split 2", timer->split_times[1], 5 * S);
+}
+
+/**
+ * A finished run becomes the personal best, which the next attempt is
+ * paced against.
+ *
+ * Unlike a replayed log, a restored journal updates the split file, so
+ * the run is applied like one.
+ *
+ * @param timer A timer on a game with 3 splits.
+ */
+static void finish_and_reset(ls_timer* timer)
+{
+    const ls_timer_event events[] = {
+        { LS_EVENT_START, 1 * S, 0 },
+        { LS_EVENT_SPLIT, 11 * S, 0 },
+        { LS_EVENT_SPLIT, 21 * S, 0 },
+        { LS_EVENT_SPLIT, 31 * S, 0 },
+    };
+    // Neither ask before resetting nor save the run history
+    cfg.libresplit.ask_on_gold.value.b = false;
+    cfg.libresplit.save_run_history.value.b = false;
+
+    timer->replaying = LS_REPLAY_JOURNAL;
+    ls_timer_reset(timer);
+    for (size_t i = 0; i < sizeof(events) / sizeof(events[0]); ++i) {
+        ls_timer_apply_event(timer, &events[i]);
+    }
+    check_time("finish: final time", ls_timer_get_time(timer, true), 30 * S);
+    ls_timer_reset(timer);
+    timer->replaying = LS_REPLAY_NONE;
+
+    check_time("finish: pb segment 2", timer->game->segment_times[1], 10 * S);
+    check_time("finish: pace after reset", timer->current_pace, 30 * S);
+    check_time("finish: time save after reset", timer->total_time_save, 0);
+}
+
+int main(void)
+{
+    char path[] = "/tmp/libresplit-replay-XXXXXX";
+    const int fd = mkstemp(path);
+    FILE* file = fd == -1 ? NULL : fdopen(fd, "w");
+    if (!file) {
+        perror("Cannot create the split file");
+        return 1;
+    }
+    fputs("{\"title\": \"Replay\", \"attempt_count\": 5, \"finished_count\": 2,"
+          " \"splits\": [{\"title\": \"A\"}, {\"title\": \"B\"}, {\"title\": \"C\"}]}",
+        file);
+    fclose(file);
+
+    ls_game* game = NULL;
+    ls_timer* timer = NULL;
+    char* error_msg = NULL;
+    if (ls_game_create(&game, path, &error_msg) || ls_timer_create(&timer, game)) {
+        printf("Cannot load the split file: %s\n", error_msg ? error_msg : "out of memory");
+        unlink(path);
+        return 1;
+    }
+
+    replay_skip_unsplit(timer);
+    replay_pause_across_split(timer);
+    replay_game_time(timer);
+
+    // Replays must leave the split file alone
+    check_time("attempts", game->attempt_count, 5);
+    check_time("finished runs", game->finished_count, 2);
+    for (unsigned int i = 0; i < game->split_count; i++) {
+        check_time("split file time", game->split_times[i], 0);
+    }
+
+    finish_and_reset(timer);
+
+    ls_timer_release(timer);
+    ls_game_release(game);
+    unlink(path);
+    return failures ? 1 : 0;
+}